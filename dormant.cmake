@@ -7,11 +7,27 @@ endif()
 add_library(dormant STATIC)
 target_sources(dormant PUBLIC
     ${DORMANT_DIR}/src/DS3231.cpp
+    ${DORMANT_DIR}/src/I2CBus.cpp
+    ${DORMANT_DIR}/src/I2CDevice.cpp
+    ${DORMANT_DIR}/src/I2CTrace.cpp
     ${DORMANT_DIR}/src/Dormant.cpp
     ${DORMANT_DIR}/src/DeepSleep.cpp
     ${DORMANT_DIR}/src/DormantNotification.cpp
+    ${DORMANT_DIR}/src/SleepController.cpp
+    ${DORMANT_DIR}/src/SleepScheduler.cpp
+    ${DORMANT_DIR}/src/PowerManager.cpp
+    ${DORMANT_DIR}/src/WakeTimer.cpp
+    ${DORMANT_DIR}/src/DS3231WakeTimer.cpp
+    ${DORMANT_DIR}/src/RTCWakeTimer.cpp
+    ${DORMANT_DIR}/src/SampleBuffer.cpp
+    ${DORMANT_DIR}/src/UplinkPolicy.cpp
+    ${DORMANT_DIR}/src/PulseCounter.cpp
+    ${DORMANT_DIR}/src/PIOCounter.cpp
+    ${DORMANT_DIR}/src/ADCCapture.cpp
 )
 
+pico_generate_pio_header(dormant ${DORMANT_DIR}/src/pulse_count.pio)
+
 # Add include directory
 target_include_directories(dormant PUBLIC 
    ${DORMANT_DIR}/src
@@ -24,5 +40,22 @@ target_link_libraries(dormant PUBLIC
     hardware_rtc
     hardware_clocks
 	hardware_rosc
+	hardware_xosc
 	hardware_sleep
-	)
\ No newline at end of file
+	hardware_pwm
+	hardware_pio
+	hardware_adc
+	hardware_dma
+	)
+
+# Optional CYW43 radio observer, built with the application's cyw43_arch
+if (TARGET pico_cyw43_arch)
+    add_library(dormant_cyw43 INTERFACE)
+    target_sources(dormant_cyw43 INTERFACE
+        ${DORMANT_DIR}/src/CYW43Power.cpp
+    )
+    target_link_libraries(dormant_cyw43 INTERFACE
+        dormant
+        pico_cyw43_arch
+    )
+endif()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Power regression gate for the sleep benchmark.
+
+Compares the BENCH lines of a run, from the host simulator or captured
+from a target's serial output, with a baseline. Fails if a scenario on a
+platform in the baseline now stays awake longer, uses more charge, takes
+more I2C transactions or has more failed cycles. Rows not in the
+baseline are reported and skipped.
+
+The wifi_join scenario times a full join, a fixed cost on the host. The
+cached BSSID, channel and lease rejoin of the Wifi example is not
+covered by the gate.
+
+Usage: gate.py baseline.csv run.csv [tolerance_percent]
+"""
+
+import sys
+
+FIELDS = ["platform", "scenario", "cycles", "fails", "wake_us", "i2c",
+          "awake_us", "charge_uC", "pulses"]
+
+# Metric, allowed growth is tolerance percent unless exact
+CHECKS = [("awake_us", False), ("charge_uC", False), ("i2c", True),
+          ("fails", True)]
+
+DEFAULT_TOLERANCE = 5.0
+
+
+def load(path):
+    rows = {}
+    with open(path) as f:
+        for line in f:
+            parts = line.strip().split(",")
+            if len(parts) != len(FIELDS) + 1 or parts[0] != "BENCH":
+                continue
+            if parts[1] == "platform":
+                continue
+            row = dict(zip(FIELDS, parts[1:]))
+            rows[(row["platform"], row["scenario"])] = row
+    return rows
+
+
+def main(argv):
+    if len(argv) < 3:
+        print(__doc__)
+        return 2
+    tolerance = float(argv[3]) if len(argv) > 3 else DEFAULT_TOLERANCE
+
+    base = load(argv[1])
+    run = load(argv[2])
+    if not run:
+        print("GATE FAIL: no BENCH results in %s" % argv[2])
+        return 1
+
+    failed = False
+    for key in sorted(run):
+        if key not in base:
+            print("GATE SKIP %s/%s: not in baseline" % key)
+            continue
+        for metric, exact in CHECKS:
+            was = float(base[key][metric])
+            now = float(run[key][metric])
+            limit = was if exact else was * (1.0 + tolerance / 100.0)
+            if now > limit:
+                print("GATE FAIL %s/%s %s: %g > %g (baseline %g)"
+                      % (key[0], key[1], metric, now, limit, was))
+                failed = True
+            else:
+                print("GATE OK   %s/%s %s: %g (baseline %g)"
+                      % (key[0], key[1], metric, now, was))
+
+    for key in sorted(base):
+        if key not in run and key[0] in [k[0] for k in run]:
+            print("GATE FAIL %s/%s: missing from run" % key)
+            failed = True
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,50 @@
+/*
+ * HostTest.h
+ *
+ * Checks for the host tests. Each test executable includes this once,
+ * prints each failed check and ends with testResult.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HOSTTEST_H_
+#define SIM_HOSTTEST_H_
+
+#include <cstdio>
+#include <cstdint>
+
+static unsigned int xChecks = 0;
+static unsigned int xFails = 0;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) checkEq((uint64_t)(a), (uint64_t)(b), #a, __LINE__)
+
+static void check(bool ok, const char *what, int line){
+	xChecks++;
+	if (!ok){
+		xFails++;
+		printf("TEST FAIL line %d: %s\n", line, what);
+	}
+}
+
+static void checkEq(uint64_t got, uint64_t want, const char *what, int line){
+	xChecks++;
+	if (got != want){
+		xFails++;
+		printf("TEST FAIL line %d: %s is %llu, expected %llu\n", line, what,
+				(unsigned long long)got, (unsigned long long)want);
+	}
+}
+
+/***
+ * Print the totals
+ * @return exit code, non zero if any check failed
+ */
+static int testResult(){
+	printf("TEST %s: %u checks, %u failed\n",
+			(xFails == 0) ? "OK" : "FAIL", xChecks, xFails);
+	return (xFails == 0) ? 0 : 1;
+}
+
+#endif /* SIM_HOSTTEST_H_ */
@@ -0,0 +1,252 @@
+/**
+ * Replay an I2C trace against the DS3231 model
+ *
+ * Reads the I2CT lines printed by I2CTrace::dump, from a serial capture
+ * file or stdin. Writes are applied to the model and each read is
+ * compared with what the model returns, so a driver sequence that left
+ * the device in the wrong state shows as a mismatch at the record where
+ * it went wrong.
+ *
+ * Time, temperature and flags raised by the device come from the world,
+ * not the driver, so they are loaded into the model from each captured
+ * read. A status flag the model holds but the capture does not is still
+ * reported, as the driver failed to clear it.
+ *
+ * Traffic is counted for each segment between marks, normally one
+ * sleep cycle, and for each register.
+ *
+ * Exits 1 if any read did not match the model.
+ *
+ * Usage: i2c_replay [capture.txt] [-v]
+ */
+
+#include "I2CTrace.h"
+#include "SimDS3231.h"
+#include "SimHAL.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#define REPLAY_DS3231_ADDR	0x68
+#define REPLAY_LINE			256
+
+//Registers set by the device rather than by the driver
+#define REPLAY_TIME_LAST	0x06
+#define REPLAY_STATUS		0x0F
+#define REPLAY_TEMP_FIRST	0x11
+#define REPLAY_STATUS_FLAGS	0x83	// OSF, A2F, A1F
+
+struct ReplayStats {
+	uint32_t	trans;
+	uint32_t	bytes;
+	uint32_t	busUs;
+	uint32_t	errors;
+	uint32_t	mismatches;
+};
+
+static SimDS3231 xModel;
+static bool xVerbose = false;
+static uint32_t xRegReads[SIM_DS3231_REGS];
+static uint32_t xRegWrites[SIM_DS3231_REGS];
+
+/***
+ * Decode a hex line into a record
+ * @param hex - text after the prefix
+ * @param rec - output
+ * @return false if not a record
+ */
+static bool decode(const char *hex, I2CTraceRecord *rec){
+	uint8_t *b = (uint8_t *)rec;
+	char byte[3] = {0, 0, 0};
+
+	for (size_t i = 0; i < sizeof(I2CTraceRecord); i++){
+		byte[0] = hex[i * 2];
+		byte[1] = (byte[0] != 0) ? hex[i * 2 + 1] : 0;
+		char *end;
+		b[i] = (uint8_t)strtoul(byte, &end, 16);
+		if ((byte[1] == 0) || (*end != 0)){
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool external(uint8_t reg){
+	return (reg <= REPLAY_TIME_LAST) || (reg >= REPLAY_TEMP_FIRST);
+}
+
+/***
+ * Load what the world changed from a captured read into the model
+ * @param rec
+ * @param rx - captured read data
+ * @param n - bytes captured
+ */
+static void loadExternal(const I2CTraceRecord *rec, const uint8_t *rx, uint n){
+	for (uint i = 0; i < n; i++){
+		uint8_t reg = (rec->reg + i) % SIM_DS3231_REGS;
+		if (external(reg)){
+			xModel.setReg(reg, rx[i]);
+		} else if (reg == REPLAY_STATUS){
+			uint8_t raised = rx[i] & REPLAY_STATUS_FLAGS & ~xModel.getReg(reg);
+			if (raised){
+				xModel.setReg(reg, xModel.getReg(reg) | raised);
+			}
+		}
+	}
+}
+
+/***
+ * Apply a DS3231 transaction to the model
+ * @param index - record number, for the report
+ * @param rec
+ * @param stats - segment counts
+ */
+static void replay(uint32_t index, const I2CTraceRecord *rec, ReplayStats *stats){
+	uint8_t tx[I2C_TRACE_DATA + 1];
+	uint8_t rx[I2C_TRACE_DATA];
+	uint txLen = rec->txLen;
+	uint rxLen = rec->rxLen;
+
+	stats->trans++;
+	stats->busUs += rec->durationUs;
+	stats->bytes += rec->txLen + rec->rxLen +
+			((rec->flags & I2C_TRACE_NOREG) ? 0 : 1);
+	if (rec->result < 0){
+		//Device did not see a complete transaction
+		stats->errors++;
+		if (xVerbose){
+			printf("REPLAY,%lu,error,%d\n", (unsigned long)index, rec->result);
+		}
+		return;
+	}
+	if (rec->flags & I2C_TRACE_TRUNC){
+		printf("REPLAY,%lu,truncated\n", (unsigned long)index);
+	}
+	if (txLen > I2C_TRACE_DATA){
+		txLen = I2C_TRACE_DATA;
+	}
+	if (rxLen > I2C_TRACE_DATA - txLen){
+		rxLen = I2C_TRACE_DATA - txLen;
+	}
+
+	if (!(rec->flags & I2C_TRACE_NOREG)){
+		if (rxLen > 0){
+			loadExternal(rec, &rec->data[txLen], rxLen);
+		}
+		tx[0] = rec->reg;
+		memcpy(&tx[1], rec->data, txLen);
+		xModel.write(tx, txLen + 1);
+		for (uint i = 0; i < txLen; i++){
+			xRegWrites[(rec->reg + i) % SIM_DS3231_REGS]++;
+		}
+	}
+	if (rxLen == 0){
+		return;
+	}
+
+	xModel.read(rx, rxLen);
+	for (uint i = 0; i < rxLen; i++){
+		uint8_t reg = (rec->reg + i) % SIM_DS3231_REGS;
+		xRegReads[reg]++;
+		if (rx[i] != rec->data[txLen + i]){
+			stats->mismatches++;
+			printf("REPLAY,%lu,mismatch,reg 0x%02X,model 0x%02X,capture 0x%02X\n",
+					(unsigned long)index, reg, rx[i], rec->data[txLen + i]);
+		}
+	}
+}
+
+static void endSegment(uint seg, uint tag, const ReplayStats *s,
+		ReplayStats *total){
+	total->trans += s->trans;
+	total->bytes += s->bytes;
+	total->busUs += s->busUs;
+	total->errors += s->errors;
+	total->mismatches += s->mismatches;
+	printf("REPLAY,segment,%u,%u,%lu,%lu,%lu,%lu,%lu\n",
+			seg, tag,
+			(unsigned long)s->trans,
+			(unsigned long)s->bytes,
+			(unsigned long)s->busUs,
+			(unsigned long)s->errors,
+			(unsigned long)s->mismatches);
+}
+
+int main(int argc, char **argv) {
+	FILE *in = stdin;
+	char line[REPLAY_LINE];
+	I2CTraceRecord rec;
+	ReplayStats seg = {0, 0, 0, 0, 0};
+	ReplayStats total = {0, 0, 0, 0, 0};
+	uint segNum = 0;
+	uint tag = 0;
+	uint32_t index = 0;
+	uint32_t other = 0;
+	size_t prefix = strlen(I2C_TRACE_PREFIX);
+
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "-v") == 0){
+			xVerbose = true;
+		} else {
+			in = fopen(argv[i], "r");
+			if (in == NULL){
+				fprintf(stderr, "Can not open %s\n", argv[i]);
+				return 2;
+			}
+		}
+	}
+
+	SimHAL::attach(REPLAY_DS3231_ADDR, &xModel);
+	printf("REPLAY,segment,seg,tag,trans,bytes,bus_us,errors,mismatches\n");
+
+	while (fgets(line, sizeof(line), in) != NULL){
+		//Serial captures may have other output before the prefix
+		char *p = strstr(line, I2C_TRACE_PREFIX ",");
+		if (p == NULL){
+			continue;
+		}
+		p += prefix + 1;
+		if (strncmp(p, "dropped,", 8) == 0){
+			printf("REPLAY,dropped,%s", p + 8);
+			continue;
+		}
+		if (!decode(p, &rec)){
+			continue;
+		}
+
+		if (rec.addr == I2C_TRACE_MARK){
+			if (seg.trans > 0){
+				endSegment(segNum, tag, &seg, &total);
+			}
+			segNum++;
+			tag = rec.reg;
+			memset(&seg, 0, sizeof(seg));
+		} else if (rec.addr == REPLAY_DS3231_ADDR){
+			replay(index, &rec, &seg);
+		} else {
+			other++;
+		}
+		index++;
+	}
+	if (seg.trans > 0){
+		endSegment(segNum, tag, &seg, &total);
+	}
+	if (in != stdin){
+		fclose(in);
+	}
+
+	for (uint r = 0; r < SIM_DS3231_REGS; r++){
+		if ((xRegReads[r] > 0) || (xRegWrites[r] > 0)){
+			printf("REPLAY,reg,0x%02X,%lu,%lu\n", r,
+					(unsigned long)xRegReads[r],
+					(unsigned long)xRegWrites[r]);
+		}
+	}
+	//Other devices are counted but not modelled
+	printf("REPLAY,done,%lu,%lu,%lu,%lu\n",
+			(unsigned long)index,
+			(unsigned long)other,
+			(unsigned long)total.trans,
+			(unsigned long)total.mismatches);
+	return (total.mismatches > 0) ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * Host test of the PowerManager mode selection on the simulated HAL
+ *
+ * Checks that each break-even is where the next mode starts to use
+ * less charge and that longer sleeps never pick a mode that saves less,
+ * the rules for which modes keep the wake sources, and that the whole
+ * time is slept when minute sleeps wake early at a minute boundary.
+ * Prints each failed check and exits non zero if any failed.
+ *
+ * Usage: power_test
+ */
+
+#include "PowerManager.h"
+#include "DeepSleep.h"
+#include "SimHAL.h"
+#include "SimDS3231.h"
+#include "HostTest.h"
+
+#define TEST_DS3231_ADDR 0x68
+#define TEST_WAKE_PAD 15
+
+#define TEST_SEC_US 1000000ULL
+#define TEST_MIN_US (60 * TEST_SEC_US)
+
+static const uint32_t xSources[] = {
+	POWER_WAKE_TIMER,
+	POWER_WAKE_TIMER | POWER_WAKE_GPIO,
+	POWER_WAKE_TIMER | POWER_WAKE_PERIPHERAL,
+	POWER_WAKE_TIMER | POWER_WAKE_USB
+};
+
+/***
+ * Break-even of each step against the charge of the two modes
+ * @param pm
+ */
+static void checkBreakEven(PowerManager *pm){
+	for (uint m = POWER_MODE_BUSY + 1; m < POWER_MODES; m++){
+		PowerMode a = (PowerMode)(m - 1);
+		PowerMode b = (PowerMode)m;
+		uint64_t be = pm->getBreakEven(a, b);
+
+		CHECK(be != UINT64_MAX);
+		CHECK(pm->getCharge(b, be) < pm->getCharge(a, be));
+		if (be > 0){
+			CHECK(pm->getCharge(b, be - 1) >= pm->getCharge(a, be - 1));
+		}
+	}
+}
+
+/***
+ * Modes chosen as the sleep grows never save less
+ * @param pm
+ */
+static void checkOrder(PowerManager *pm){
+	for (uint s = 0; s < sizeof(xSources) / sizeof(xSources[0]); s++){
+		PowerMode last = POWER_MODE_BUSY;
+		for (uint64_t us = 1; us <= 2 * 3600 * TEST_SEC_US; us = us * 3 / 2 + 1){
+			PowerMode mode = pm->select(us, xSources[s]);
+			CHECK(mode >= last);
+			CHECK(pm->isFeasible(mode, us, xSources[s]));
+			last = mode;
+		}
+	}
+}
+
+static void testBreakEven(DS3231 *rtc){
+	PowerManager pm;
+	pm.setRTC(rtc, TEST_WAKE_PAD);
+
+	checkBreakEven(&pm);
+	checkOrder(&pm);
+	CHECK_EQ(pm.select(10, POWER_WAKE_TIMER), POWER_MODE_BUSY);
+	CHECK_EQ(pm.select(DEEPSLEEP_US_MIN, POWER_WAKE_TIMER), POWER_MODE_GATED);
+	CHECK_EQ(pm.select(TEST_SEC_US, POWER_WAKE_TIMER), POWER_MODE_XOSC);
+	CHECK_EQ(pm.select(2 * TEST_MIN_US, POWER_WAKE_TIMER), POWER_MODE_DORMANT);
+
+	//Busy current is also the current entering and leaving each mode
+	uint64_t be = pm.getBreakEven(POWER_MODE_GATED, POWER_MODE_XOSC);
+	pm.setCurrent(POWER_MODE_BUSY, POWER_AWAKE_UA * 2);
+	CHECK(pm.getBreakEven(POWER_MODE_GATED, POWER_MODE_XOSC) > be);
+	checkBreakEven(&pm);
+	checkOrder(&pm);
+
+	//Measured costs move the break-even
+	be = pm.getBreakEven(POWER_MODE_DEEP, POWER_MODE_DORMANT);
+	pm.setCost(POWER_MODE_DORMANT, POWER_COST_DORMANT_US * 2);
+	CHECK(pm.getBreakEven(POWER_MODE_DEEP, POWER_MODE_DORMANT) > be);
+	checkBreakEven(&pm);
+
+	//A mode drawing no less than the one before never pays
+	pm.setCurrent(POWER_MODE_DORMANT, POWER_DEEP_UA);
+	CHECK_EQ(pm.getBreakEven(POWER_MODE_DEEP, POWER_MODE_DORMANT), UINT64_MAX);
+	CHECK_EQ(pm.select(2 * TEST_MIN_US, POWER_WAKE_TIMER), POWER_MODE_DEEP);
+}
+
+static void testFeasible(DS3231 *rtc){
+	PowerManager pm;
+	uint64_t us = 2 * TEST_MIN_US;
+
+	//DS3231 alarm needs its INT pad to reach the core
+	pm.setRTC(rtc);
+	CHECK(!pm.isFeasible(POWER_MODE_DEEP, us, POWER_WAKE_TIMER));
+	CHECK(!pm.isFeasible(POWER_MODE_DORMANT, us, POWER_WAKE_TIMER));
+	CHECK(pm.isFeasible(POWER_MODE_XOSC, us, POWER_WAKE_TIMER));
+	CHECK_EQ(pm.select(us, POWER_WAKE_TIMER), POWER_MODE_XOSC);
+
+	pm.setRTC(rtc, TEST_WAKE_PAD);
+	CHECK(pm.isFeasible(POWER_MODE_DEEP, us, POWER_WAKE_TIMER));
+	CHECK(pm.isFeasible(POWER_MODE_DORMANT, us, POWER_WAKE_TIMER));
+	CHECK(pm.isFeasible(POWER_MODE_DORMANT, us, POWER_WAKE_TIMER | POWER_WAKE_GPIO));
+
+	//Minute modes need a minute
+	CHECK(!pm.isFeasible(POWER_MODE_DEEP, TEST_MIN_US - 1, POWER_WAKE_TIMER));
+	CHECK(!pm.isFeasible(POWER_MODE_DORMANT, TEST_MIN_US - 1, POWER_WAKE_TIMER));
+	CHECK(!pm.isFeasible(POWER_MODE_GATED, DEEPSLEEP_US_MIN - 1, POWER_WAKE_TIMER));
+
+	//Peripherals on clk_sys stop dormant
+	CHECK(pm.isFeasible(POWER_MODE_DEEP, us, POWER_WAKE_PERIPHERAL));
+	CHECK(!pm.isFeasible(POWER_MODE_DORMANT, us, POWER_WAKE_PERIPHERAL));
+	CHECK_EQ(pm.select(us, POWER_WAKE_PERIPHERAL), POWER_MODE_DEEP);
+
+	//USB clocks are gated in every sleep
+	for (uint m = POWER_MODE_BUSY + 1; m < POWER_MODES; m++){
+		CHECK(!pm.isFeasible((PowerMode)m, us, POWER_WAKE_TIMER | POWER_WAKE_USB));
+	}
+	CHECK_EQ(pm.select(us, POWER_WAKE_TIMER | POWER_WAKE_USB), POWER_MODE_BUSY);
+
+	//Pico RTC interrupts the core directly but stops dormant on the XOSC
+	pm.setRTC(NULL);
+	CHECK(pm.isFeasible(POWER_MODE_DEEP, us, POWER_WAKE_TIMER));
+	CHECK(!pm.isFeasible(POWER_MODE_DORMANT, us, POWER_WAKE_TIMER));
+}
+
+/***
+ * Sleep for a time starting part way through a minute
+ * @param rtc
+ * @param model
+ * @param secUs - time into the minute
+ * @param us - time to sleep
+ * @param minuteSleeps - expected minute mode sleeps
+ */
+static void runRemainder(DS3231 *rtc, SimDS3231 *model, uint64_t secUs,
+		uint64_t us, uint minuteSleeps){
+	PowerManager pm;
+	pm.setRTC(rtc, TEST_WAKE_PAD);
+
+	//Align the DS3231 to the minute then move into it
+	uint32_t epoch = model->getEpoch();
+	model->setEpoch(epoch - (epoch % 60) + 60);
+	SimHAL::run(secUs);
+
+	uint32_t hangs = SimHAL::getHangs();
+	uint64_t start = SimHAL::getWallUs();
+	CHECK(pm.sleepFor(us, POWER_WAKE_TIMER));
+	uint64_t took = SimHAL::getWallUs() - start;
+
+	//Slept time is counted in whole seconds of the wake timer
+	CHECK(took + TEST_SEC_US > us);
+	CHECK(took < us + TEST_SEC_US);
+	CHECK_EQ(pm.getCount(POWER_MODE_DORMANT), minuteSleeps);
+	CHECK_EQ(pm.getCount(POWER_MODE_XOSC), 1);
+	CHECK_EQ(pm.getLastMode(), POWER_MODE_XOSC);
+	CHECK_EQ(SimHAL::getHangs(), hangs);
+}
+
+static void testRemainder(DS3231 *rtc, SimDS3231 *model){
+	//First sleep ends 30s in at the minute, then a minute and 10s left
+	runRemainder(rtc, model, 30 * TEST_SEC_US, 100 * TEST_SEC_US, 2);
+
+	//Ends 0.1s in, then a minute and 39s left
+	runRemainder(rtc, model, 59 * TEST_SEC_US + 900000, 100 * TEST_SEC_US, 2);
+
+	//Whole minutes from a boundary, then the 30s left
+	runRemainder(rtc, model, 0, 150 * TEST_SEC_US, 1);
+}
+
+int main(int argc, char **argv) {
+	SimDS3231 model;
+	SimHAL::attach(TEST_DS3231_ADDR, &model);
+	SimHAL::wire(TEST_WAKE_PAD, &model);
+	DS3231 rtc(i2c0, 12, 13);
+
+	testBreakEven(&rtc);
+	testFeasible(&rtc);
+	testRemainder(&rtc, &model);
+
+	return testResult();
+}
@@ -0,0 +1,238 @@
+/**
+ * Host test of the SleepScheduler logic against SimWakeTimer
+ *
+ * Checks the sleep length chosen, the minute rounding, dispatch with the
+ * skip of periods missed over a long sleep, removal of one shot jobs and
+ * the wakes slack saves when periods drift in and out of step.
+ * Prints each failed check and exits non zero if any failed.
+ *
+ * Usage: scheduler_test
+ */
+
+#include "SleepScheduler.h"
+#include "SimWakeTimer.h"
+#include "HostTest.h"
+
+//18 Oct 2026 00:00:00 UTC, on a minute boundary
+#define TEST_BASE 1792281600
+
+/***
+ * Sleep controller on the simulated timer. The alarm matches on the
+ * minute, as the DS3231 alarm 2 does, and waking takes a second
+ */
+class TestController : public SleepController {
+public:
+	virtual void sleep(uint minutes, uint8_t wakePad){
+		uint64_t now = xTimer.getNow();
+		xTimer.setNow(now - (now % 60));
+		xTimer.setAlarm(minutes);
+		xTimer.fire();
+		xTimer.clearAlarm();
+		xTimer.setNow(xTimer.getNow() + 1);
+	}
+
+	virtual WakeTimer * getWakeTimer(){
+		return &xTimer;
+	}
+
+	SimWakeTimer xTimer;
+};
+
+static uint xCalls = 0;
+
+static void countJob(void *arg){
+	xCalls++;
+}
+
+static void testMinutesUntil(){
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE, TEST_BASE), 1);
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE - 5, TEST_BASE), 1);
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE + 60, TEST_BASE), 1);
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE + 61, TEST_BASE), 2);
+	//Counted from the start of the current minute
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE + 90, TEST_BASE + 30), 2);
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE + 120, TEST_BASE + 59), 2);
+	CHECK_EQ(SleepScheduler::minutesUntil(TEST_BASE + 24 * 3600, TEST_BASE),
+			SLEEP_SCHEDULER_MAX_MIN);
+}
+
+static void testSleepMinutes(){
+	TestController ctrl;
+	ctrl.xTimer.setNow(TEST_BASE);
+	SleepScheduler sched(&ctrl);
+
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), SLEEP_SCHEDULER_MAX_MIN);
+
+	int a = sched.addPeriodic(300, countJob);
+	CHECK(a >= 0);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), 5);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE + 10), 5);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE + 250), 1);
+
+	//Slack lets the wake move to the last minute of the window
+	int b = sched.addOneShot(150, countJob, NULL, 90);
+	CHECK(b >= 0);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), 4);
+
+	//Job whose window closes first decides
+	CHECK(sched.remove(a));
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), 4);
+	CHECK(sched.remove(b));
+
+	//Window with no minute boundary, wake just after due
+	int c = sched.addOneShot(150, countJob, NULL, 10);
+	CHECK(c >= 0);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), 3);
+	CHECK(sched.remove(c));
+
+	//Long sleeps are capped
+	int d = sched.addOneShot(5 * 3600, countJob);
+	CHECK(d >= 0);
+	CHECK_EQ(sched.getSleepMinutes(TEST_BASE), SLEEP_SCHEDULER_MAX_MIN);
+}
+
+static void testDispatch(){
+	TestController ctrl;
+	ctrl.xTimer.setNow(TEST_BASE);
+	SleepScheduler sched(&ctrl);
+	const SleepJob *job;
+
+	xCalls = 0;
+	int a = sched.addPeriodic(60, countJob);
+	CHECK(a >= 0);
+	job = sched.getJob(a);
+	CHECK(job != NULL);
+	CHECK_EQ(job->due, TEST_BASE + 60);
+
+	CHECK_EQ(sched.dispatch(TEST_BASE + 59), 0);
+	CHECK_EQ(xCalls, 0);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 60), 1);
+	CHECK_EQ(xCalls, 1);
+	CHECK_EQ(job->due, TEST_BASE + 120);
+	CHECK_EQ(job->missed, 0);
+
+	//Long sleep, runs once and skips the periods missed
+	CHECK_EQ(sched.dispatch(TEST_BASE + 250), 1);
+	CHECK_EQ(xCalls, 2);
+	CHECK_EQ(job->runs, 2);
+	CHECK_EQ(job->missed, 2);
+	CHECK_EQ(job->due, TEST_BASE + 300);
+
+	//Late but within slack is not a miss
+	CHECK(sched.setSlack(a, 20));
+	CHECK_EQ(sched.dispatch(TEST_BASE + 315), 1);
+	CHECK_EQ(job->missed, 2);
+	CHECK_EQ(job->due, TEST_BASE + 360);
+
+	//Slack opens the window early
+	CHECK_EQ(sched.dispatch(TEST_BASE + 339), 0);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 340), 1);
+	CHECK_EQ(job->due, TEST_BASE + 420);
+	CHECK_EQ(sched.getRuns(), 4);
+}
+
+static void testOneShot(){
+	TestController ctrl;
+	ctrl.xTimer.setNow(TEST_BASE);
+	SleepScheduler sched(&ctrl);
+
+	xCalls = 0;
+	int a = sched.addOneShot(120, countJob);
+	CHECK(a >= 0);
+	CHECK_EQ(sched.getNextDue(), TEST_BASE + 120);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 119), 0);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 120), 1);
+	CHECK_EQ(xCalls, 1);
+
+	//Removed once run, the slot is free again
+	CHECK(sched.getJob(a) == NULL);
+	CHECK(!sched.remove(a));
+	CHECK_EQ(sched.getNextDue(), 0);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 600), 0);
+	CHECK_EQ(sched.addOneShot(60, countJob), a);
+
+	//Removed before it runs, never runs
+	CHECK(sched.remove(a));
+	CHECK(sched.getJob(a) == NULL);
+	CHECK_EQ(sched.dispatch(TEST_BASE + 3600), 0);
+	CHECK_EQ(xCalls, 1);
+
+	//Full table
+	for (uint i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		CHECK(sched.addOneShot(60, countJob) >= 0);
+	}
+	CHECK_EQ(sched.addOneShot(60, countJob), -1);
+}
+
+static void testStep(){
+	TestController ctrl;
+	ctrl.xTimer.setNow(TEST_BASE);
+	SleepScheduler sched(&ctrl);
+
+	xCalls = 0;
+	sched.addPeriodic(60, countJob);
+	sched.addPeriodic(1800, countJob);
+	sched.addOneShot(300, countJob);
+	while (ctrl.xTimer.getNow() < TEST_BASE + 3600){
+		sched.step();
+	}
+	//A wake each minute. Jobs due on the hour wait for the next step
+	CHECK_EQ(sched.getWakes(), 60);
+	CHECK_EQ(sched.getRuns(), 59 + 1 + 1);
+	CHECK_EQ(xCalls, 59 + 1 + 1);
+	CHECK_EQ(sched.getWakesSaved(), 0);
+}
+
+/***
+ * Jobs every 5, 6 and 7 minutes for three hours
+ * @param slack - for the 5 and 6 minute jobs, twice this for the 7
+ * @param wakes - output
+ * @param saved - output
+ * @return wakes that ran no job
+ */
+static uint runDrift(uint32_t slack, uint32_t *wakes, uint32_t *saved){
+	TestController ctrl;
+	ctrl.xTimer.setNow(TEST_BASE);
+	SleepScheduler sched(&ctrl);
+	uint empty = 0;
+
+	sched.addPeriodic(300, countJob, NULL, 0, slack);
+	sched.addPeriodic(360, countJob, NULL, 0, slack);
+	sched.addPeriodic(420, countJob, NULL, 0, slack * 2);
+	while (ctrl.xTimer.getNow() < TEST_BASE + 3 * 3600){
+		uint32_t runs = sched.getRuns();
+		sched.step();
+		if ((sched.getRuns() == runs) && (sched.getWakes() > 1)){
+			empty++;
+		}
+	}
+	*wakes = sched.getWakes();
+	*saved = sched.getWakesSaved();
+	return empty;
+}
+
+static void testDrift(){
+	uint32_t wakes;
+	uint32_t saved;
+
+	//Without slack every distinct due minute is a wake
+	CHECK_EQ(runDrift(0, &wakes, &saved), 0);
+	CHECK_EQ(wakes, 76);
+	CHECK_EQ(saved, 0);
+
+	//With slack near misses share a wake
+	CHECK_EQ(runDrift(30, &wakes, &saved), 0);
+	CHECK_EQ(wakes, 65);
+	CHECK_EQ(saved, 13);
+}
+
+int main(int argc, char **argv) {
+	testMinutesUntil();
+	testSleepMinutes();
+	testDispatch();
+	testOneShot();
+	testStep();
+	testDrift();
+
+	return testResult();
+}
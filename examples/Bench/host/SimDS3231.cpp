@@ -0,0 +1,304 @@
+/*
+ * SimDS3231.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SimDS3231.h"
+#include "SimHAL.h"
+#include <string.h>
+
+#define REG_SEC		0x00
+#define REG_HOU		0x02
+#define REG_YEAR	0x06
+#define REG_ALM1	0x07
+#define REG_ALM2	0x0B
+#define REG_CONTROL	0x0E
+#define REG_STATUS	0x0F
+#define REG_TEMP	0x11
+
+#define CONTROL_A1IE	0x01
+#define CONTROL_A2IE	0x02
+#define CONTROL_INTCN	0x04
+#define STATUS_A1F		0x01
+#define STATUS_A2F		0x02
+#define STATUS_EN32KHZ	0x08
+#define STATUS_OSF		0x80
+
+#define ALARM_MASK		0x80
+#define ALARM_DY		0x40
+#define HOUR_12			0x40
+#define HOUR_PM			0x20
+
+/*
+ * Days from 1970-01-01 to a civil date, and back
+ */
+static int32_t daysFromCivil(int y, uint m, uint d){
+	y -= (m <= 2);
+	int32_t era = (y >= 0 ? y : y - 399) / 400;
+	uint yoe = (uint)(y - era * 400);
+	uint doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	uint doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int *y, uint *m, uint *d){
+	z += 719468;
+	int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+	uint doe = (uint)(z - era * 146097);
+	uint yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint mp = (5 * doy + 2) / 153;
+	*d = doy - (153 * mp + 2) / 5 + 1;
+	*m = mp < 10 ? mp + 3 : mp - 9;
+	*y = (int)yoe + era * 400 + (*m <= 2);
+}
+
+SimDS3231::SimDS3231(uint32_t epoch) {
+	memset(xRegs, 0, sizeof(xRegs));
+	xRegs[REG_CONTROL] = CONTROL_INTCN;
+	xRegs[REG_STATUS] = STATUS_EN32KHZ;
+	xRegs[REG_TEMP] = 25;
+	setEpoch(epoch);
+}
+
+SimDS3231::~SimDS3231() {
+	// NOP
+}
+
+void SimDS3231::setPresent(bool on){
+	xPresent = on;
+}
+
+void SimDS3231::setEpoch(uint32_t epoch){
+	xBaseEpoch = epoch;
+	xBaseUs = SimHAL::getWallUs();
+	xSynced = epoch;
+	regsFromEpoch(epoch);
+}
+
+uint32_t SimDS3231::getEpoch(){
+	return xBaseEpoch + (uint32_t)((SimHAL::getWallUs() - xBaseUs) / 1000000);
+}
+
+uint8_t SimDS3231::getReg(uint8_t reg){
+	sync();
+	return xRegs[reg % SIM_DS3231_REGS];
+}
+
+void SimDS3231::setReg(uint8_t reg, uint8_t value){
+	sync();
+	xRegs[reg % SIM_DS3231_REGS] = value;
+	if ((reg % SIM_DS3231_REGS) <= REG_YEAR){
+		setEpoch(epochFromRegs());
+	}
+}
+
+int SimDS3231::write(const uint8_t *src, size_t len){
+	bool timeSet = false;
+
+	if (!xPresent){
+		return PICO_ERROR_GENERIC;
+	}
+	if (len == 0){
+		return 0;
+	}
+	sync();
+	xPtr = src[0] % SIM_DS3231_REGS;
+	for (size_t i = 1; i < len; i++){
+		if (xPtr == REG_STATUS){
+			//Flags can only be cleared, BUSY is read only
+			uint8_t old = xRegs[REG_STATUS];
+			xRegs[REG_STATUS] = (src[i] & STATUS_EN32KHZ) |
+					(old & src[i] & (STATUS_OSF | STATUS_A1F | STATUS_A2F));
+		} else if (xPtr < REG_TEMP){
+			xRegs[xPtr] = src[i];
+			if (xPtr <= REG_YEAR){
+				timeSet = true;
+			}
+		}
+		xPtr = (xPtr + 1) % SIM_DS3231_REGS;
+	}
+	if (timeSet){
+		setEpoch(epochFromRegs());
+	}
+	return (int)len;
+}
+
+int SimDS3231::read(uint8_t *dst, size_t len){
+	if (!xPresent){
+		return PICO_ERROR_GENERIC;
+	}
+	sync();
+	for (size_t i = 0; i < len; i++){
+		dst[i] = xRegs[xPtr];
+		xPtr = (xPtr + 1) % SIM_DS3231_REGS;
+	}
+	return (int)len;
+}
+
+bool SimDS3231::isInterrupt(){
+	uint8_t ctrl;
+	uint8_t status;
+
+	sync();
+	ctrl = xRegs[REG_CONTROL];
+	status = xRegs[REG_STATUS];
+	if (!(ctrl & CONTROL_INTCN)){
+		return false;
+	}
+	return ((ctrl & CONTROL_A1IE) && (status & STATUS_A1F)) ||
+			((ctrl & CONTROL_A2IE) && (status & STATUS_A2F));
+}
+
+bool SimDS3231::nextInterrupt(uint64_t *us){
+	uint8_t ctrl = xRegs[REG_CONTROL];
+	uint32_t now;
+
+	if (isInterrupt()){
+		*us = SimHAL::getWallUs();
+		return true;
+	}
+	if (!(ctrl & CONTROL_INTCN) || !(ctrl & (CONTROL_A1IE | CONTROL_A2IE))){
+		return false;
+	}
+
+	now = getEpoch();
+	for (uint32_t e = now + 1; e <= now + SIM_DS3231_SEARCH_SEC; e++){
+		if (((ctrl & CONTROL_A1IE) && alarmMatch(1, e)) ||
+				((ctrl & CONTROL_A2IE) && alarmMatch(2, e))){
+			*us = xBaseUs + (uint64_t)(e - xBaseEpoch) * 1000000;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SimDS3231::sync(){
+	uint32_t now = getEpoch();
+
+	if (now == xSynced){
+		return;
+	}
+	//Only the last search period can matter for the flags
+	if ((now - xSynced) > SIM_DS3231_SEARCH_SEC){
+		xSynced = now - SIM_DS3231_SEARCH_SEC;
+	}
+	while (xSynced < now){
+		xSynced++;
+		checkAlarms(xSynced);
+	}
+	regsFromEpoch(now);
+}
+
+bool SimDS3231::checkAlarms(uint32_t epoch){
+	bool res = false;
+
+	if (alarmMatch(1, epoch)){
+		xRegs[REG_STATUS] |= STATUS_A1F;
+		res = res || (xRegs[REG_CONTROL] & CONTROL_A1IE);
+	}
+	if (alarmMatch(2, epoch)){
+		xRegs[REG_STATUS] |= STATUS_A2F;
+		res = res || (xRegs[REG_CONTROL] & CONTROL_A2IE);
+	}
+	return res;
+}
+
+bool SimDS3231::alarmMatch(uint alarm, uint32_t epoch){
+	uint sec = epoch % 60;
+	uint min = (epoch / 60) % 60;
+	uint hou = (epoch / 3600) % 24;
+	int32_t days = epoch / 86400;
+	uint dow = ((days + 4) % 7) + 1;
+	int y;
+	uint m, d;
+	const uint8_t *a;
+
+	civilFromDays(days, &y, &m, &d);
+
+	if (alarm == 1){
+		a = &xRegs[REG_ALM1];
+		if (!(a[0] & ALARM_MASK) && (fromBCD(a[0] & 0x7F) != sec)){
+			return false;
+		}
+		a++;
+	} else {
+		//Alarm 2 has no seconds and matches at the top of the minute
+		if (sec != 0){
+			return false;
+		}
+		a = &xRegs[REG_ALM2];
+	}
+
+	if (!(a[0] & ALARM_MASK) && (fromBCD(a[0] & 0x7F) != min)){
+		return false;
+	}
+	if (!(a[1] & ALARM_MASK) && (hourFromReg(a[1]) != hou)){
+		return false;
+	}
+	if (!(a[2] & ALARM_MASK)){
+		if (a[2] & ALARM_DY){
+			if ((a[2] & 0x0F) != dow){
+				return false;
+			}
+		} else if (fromBCD(a[2] & 0x3F) != d){
+			return false;
+		}
+	}
+	return true;
+}
+
+void SimDS3231::regsFromEpoch(uint32_t epoch){
+	int32_t days = epoch / 86400;
+	uint hou = (epoch / 3600) % 24;
+	int y;
+	uint m, d;
+
+	civilFromDays(days, &y, &m, &d);
+	xRegs[REG_SEC] = toBCD(epoch % 60);
+	xRegs[REG_SEC + 1] = toBCD((epoch / 60) % 60);
+	if (xRegs[REG_HOU] & HOUR_12){
+		uint h12 = hou % 12;
+		xRegs[REG_HOU] = HOUR_12 | ((hou >= 12) ? HOUR_PM : 0) |
+				toBCD(h12 == 0 ? 12 : h12);
+	} else {
+		xRegs[REG_HOU] = toBCD(hou);
+	}
+	xRegs[REG_HOU + 1] = ((days + 4) % 7) + 1;
+	xRegs[REG_HOU + 2] = toBCD(d);
+	xRegs[REG_HOU + 3] = toBCD(m);
+	xRegs[REG_YEAR] = toBCD(y % 100);
+}
+
+uint32_t SimDS3231::epochFromRegs(){
+	uint sec = fromBCD(xRegs[REG_SEC] & 0x7F);
+	uint min = fromBCD(xRegs[REG_SEC + 1] & 0x7F);
+	uint hou = hourFromReg(xRegs[REG_HOU]);
+	uint d = fromBCD(xRegs[REG_HOU + 2] & 0x3F);
+	uint m = fromBCD(xRegs[REG_HOU + 3] & 0x1F);
+	int y = 2000 + fromBCD(xRegs[REG_YEAR]);
+
+	if ((m < 1) || (m > 12) || (d < 1) || (d > 31)){
+		return xBaseEpoch;
+	}
+	return (uint32_t)daysFromCivil(y, m, d) * 86400 +
+			hou * 3600 + min * 60 + sec;
+}
+
+uint8_t SimDS3231::toBCD(uint v){
+	return (uint8_t)(((v / 10) << 4) | (v % 10));
+}
+
+uint SimDS3231::fromBCD(uint8_t v){
+	return ((v >> 4) * 10) + (v & 0x0F);
+}
+
+uint SimDS3231::hourFromReg(uint8_t v){
+	if (v & HOUR_12){
+		uint h = fromBCD(v & 0x1F) % 12;
+		return (v & HOUR_PM) ? h + 12 : h;
+	}
+	return fromBCD(v & 0x3F);
+}
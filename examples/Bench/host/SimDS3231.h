@@ -0,0 +1,125 @@
+/*
+ * SimDS3231.h
+ *
+ * Register model of the DS3231 on the simulated I2C bus. Keeps time
+ * from the SimHAL wall clock, sets the alarm flags as the alarms match
+ * and asserts INT/SQW when an enabled alarm flag is set in interrupt
+ * mode. Writes follow the device, status flags can only be cleared and
+ * the register pointer wraps after the last register.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_SIMDS3231_H_
+#define SIM_SIMDS3231_H_
+
+#include "SimI2CDevice.h"
+
+#define SIM_DS3231_REGS 0x13
+
+//18 Oct 2026 00:00:00 UTC
+#ifndef SIM_DS3231_START_EPOCH
+#define SIM_DS3231_START_EPOCH 1792281600
+#endif
+
+//Longest time searched ahead for an alarm
+#ifndef SIM_DS3231_SEARCH_SEC
+#define SIM_DS3231_SEARCH_SEC (2 * 24 * 3600)
+#endif
+
+class SimDS3231 : public SimI2CDevice {
+public:
+	/***
+	 * Constructor
+	 * @param epoch - time at the current wall clock
+	 */
+	SimDS3231(uint32_t epoch = SIM_DS3231_START_EPOCH);
+	virtual ~SimDS3231();
+
+	virtual int write(const uint8_t *src, size_t len);
+	virtual int read(uint8_t *dst, size_t len);
+
+	/***
+	 * Set the time now
+	 * @param epoch
+	 */
+	void setEpoch(uint32_t epoch);
+
+	/***
+	 * Time now
+	 * @return epoch
+	 */
+	uint32_t getEpoch();
+
+	/***
+	 * Is INT/SQW asserted by an alarm
+	 * @return true if asserted
+	 */
+	bool isInterrupt();
+
+	/***
+	 * Wall time INT/SQW will next be asserted, current wall time if
+	 * already asserted
+	 * @param us - output
+	 * @return false if not within SIM_DS3231_SEARCH_SEC
+	 */
+	virtual bool nextInterrupt(uint64_t *us);
+
+	/***
+	 * Register value now, without an I2C transfer
+	 * @param reg
+	 * @return value
+	 */
+	uint8_t getReg(uint8_t reg);
+
+	/***
+	 * Force a register, such as to inject a fault
+	 * @param reg
+	 * @param value
+	 */
+	void setReg(uint8_t reg, uint8_t value);
+
+	/***
+	 * Simulate a missing or unpowered device
+	 * @param on - false to NACK every transfer
+	 */
+	void setPresent(bool on);
+
+private:
+	/***
+	 * Bring time registers and alarm flags up to the wall clock
+	 */
+	void sync();
+
+	/***
+	 * Do the alarms match this second, setting the flags
+	 * @param epoch
+	 * @return true if an enabled alarm matched
+	 */
+	bool checkAlarms(uint32_t epoch);
+
+	/***
+	 * Alarm match without changing flags
+	 * @param alarm - 1 or 2
+	 * @param epoch
+	 * @return true if matched
+	 */
+	bool alarmMatch(uint alarm, uint32_t epoch);
+
+	void regsFromEpoch(uint32_t epoch);
+	uint32_t epochFromRegs();
+
+	static uint8_t toBCD(uint v);
+	static uint fromBCD(uint8_t v);
+	static uint hourFromReg(uint8_t v);
+
+	uint8_t xRegs[SIM_DS3231_REGS];
+	uint8_t xPtr = 0;
+	uint32_t xBaseEpoch;
+	uint64_t xBaseUs;
+	uint32_t xSynced;
+	bool xPresent = true;
+};
+
+#endif /* SIM_SIMDS3231_H_ */
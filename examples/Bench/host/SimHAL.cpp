@@ -0,0 +1,486 @@
+/*
+ * SimHAL.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SimHAL.h"
+#include "hardware/clocks.h"
+#include "hardware/rosc.h"
+#include "hardware/structs/scb.h"
+#include "hardware/sync.h"
+#include "pico/sleep.h"
+#include "hardware/xosc.h"
+
+SimI2CDevice * SimHAL::pDevices[128] = {NULL};
+uint64_t SimHAL::xWallUs = 0;
+uint64_t SimHAL::xAwakeUs = 0;
+uint32_t SimHAL::xTransfers = 0;
+uint32_t SimHAL::xHangs = 0;
+
+SimI2CDevice * SimHAL::pWired[SIM_PADS] = {NULL};
+bool SimHAL::xIRQ[SIM_PADS] = {false};
+bool SimHAL::xLevel[SIM_PADS] = {false};
+uint64_t SimHAL::xPulseUs[SIM_PADS] = {0};
+gpio_irq_callback_t SimHAL::pGPIOCB = NULL;
+
+bool SimHAL::xAlarmClaimed[SIM_ALARMS] = {false};
+bool SimHAL::xAlarmArmed[SIM_ALARMS] = {false};
+uint64_t SimHAL::xAlarmUs[SIM_ALARMS] = {0};
+hardware_alarm_callback_t SimHAL::pAlarmCB[SIM_ALARMS] = {NULL};
+
+bool SimHAL::xRTCRunning = false;
+uint32_t SimHAL::xRTCEpoch = 0;
+uint64_t SimHAL::xRTCBaseUs = 0;
+int8_t SimHAL::xRTCAlarm[3] = {-1, -1, -1};
+rtc_callback_t SimHAL::pRTCCB = NULL;
+
+i2c_inst_t i2c0_inst = {100000};
+i2c_inst_t i2c1_inst = {100000};
+
+//Reset values, every clock left on in sleep
+static clocks_hw_t xClocksHW = {0xFFFFFFFF, 0x00007FFF, 0xFFFFFFFF, 0x00007FFF};
+static rosc_hw_t xRoscHW = {0};
+static scb_hw_t xScbHW = {0};
+clocks_hw_t *clocks_hw = &xClocksHW;
+rosc_hw_t *rosc_hw = &xRoscHW;
+scb_hw_t *scb_hw = &xScbHW;
+
+void SimHAL::attach(uint8_t addr, SimI2CDevice *dev){
+	pDevices[addr & 0x7F] = dev;
+}
+
+void SimHAL::run(uint64_t us){
+	xWallUs += us;
+	xAwakeUs += us;
+}
+
+void SimHAL::sleep(uint64_t us){
+	xWallUs += us;
+}
+
+uint64_t SimHAL::getWallUs(){
+	return xWallUs;
+}
+
+uint64_t SimHAL::getAwakeUs(){
+	return xAwakeUs;
+}
+
+uint32_t SimHAL::getTransfers(){
+	return xTransfers;
+}
+
+int SimHAL::transfer(i2c_inst_t *i2c, uint8_t addr,
+		const uint8_t *tx, uint8_t *rx, size_t len){
+	SimI2CDevice *dev = pDevices[addr & 0x7F];
+	int res;
+
+	xTransfers++;
+	//Address byte and each data byte are 9 clocks
+	run(SIM_I2C_SETUP_US + ((len + 1) * 9 * 1000000) / i2c->baud);
+	if (dev == NULL){
+		return PICO_ERROR_GENERIC;
+	}
+	if (tx != NULL){
+		res = dev->write(tx, len);
+	} else {
+		res = dev->read(rx, len);
+	}
+	return res;
+}
+
+void SimHAL::wire(uint8_t pad, SimI2CDevice *dev){
+	if (pad < SIM_PADS){
+		pWired[pad] = dev;
+	}
+}
+
+void SimHAL::pulse(uint8_t pad, uint64_t us){
+	if (pad < SIM_PADS){
+		xPulseUs[pad] = us;
+	}
+}
+
+uint32_t SimHAL::getHangs(){
+	return xHangs;
+}
+
+bool SimHAL::padLevel(uint8_t pad){
+	uint64_t us;
+
+	if (pWired[pad] == NULL){
+		return false;
+	}
+	return pWired[pad]->nextInterrupt(&us) && (us <= xWallUs);
+}
+
+bool SimHAL::padNext(uint8_t pad, uint64_t *us){
+	bool found = false;
+	uint64_t t;
+
+	if (!xIRQ[pad]){
+		return false;
+	}
+	if (xPulseUs[pad] != 0){
+		*us = (xPulseUs[pad] > xWallUs) ? xPulseUs[pad] : xWallUs;
+		found = true;
+	}
+	if ((pWired[pad] != NULL) && pWired[pad]->nextInterrupt(&t)){
+		//Asserted since the IRQ was enabled is no edge
+		if ((t <= xWallUs) && xLevel[pad]){
+			return found;
+		}
+		if (t < xWallUs){
+			t = xWallUs;
+		}
+		if (!found || (t < *us)){
+			*us = t;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool SimHAL::rtcNext(uint64_t *us){
+	uint32_t now = getRTC();
+
+	for (uint32_t e = now + 1; e <= now + 24 * 3600; e++){
+		if (((xRTCAlarm[0] < 0) || (xRTCAlarm[0] == (int8_t)((e / 3600) % 24))) &&
+				((xRTCAlarm[1] < 0) || (xRTCAlarm[1] == (int8_t)((e / 60) % 60))) &&
+				((xRTCAlarm[2] < 0) || (xRTCAlarm[2] == (int8_t)(e % 60)))){
+			*us = xRTCBaseUs + (uint64_t)(e - xRTCEpoch) * 1000000;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SimHAL::clocked(uint32_t en0, uint32_t en1){
+	if ((scb_hw->scr & M0PLUS_SCR_SLEEPDEEP_BITS) == 0){
+		return true;
+	}
+	return ((clocks_hw->sleep_en0 & en0) != 0) ||
+			((clocks_hw->sleep_en1 & en1) != 0);
+}
+
+bool SimHAL::wfi(){
+	enum {NONE, PAD, ALARM, RTC} kind = NONE;
+	uint src = 0;
+	uint64_t next = 0;
+	uint64_t t;
+	bool timer = clocked(0, CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS);
+
+	for (uint pad = 0; pad < SIM_PADS; pad++){
+		if (padNext(pad, &t) && ((kind == NONE) || (t < next))){
+			kind = PAD;
+			src = pad;
+			next = t;
+		}
+	}
+	for (uint a = 0; timer && (a < SIM_ALARMS); a++){
+		if (!xAlarmArmed[a]){
+			continue;
+		}
+		t = xWallUs;
+		if (xAlarmUs[a] > xAwakeUs){
+			t += xAlarmUs[a] - xAwakeUs;
+		}
+		if ((kind == NONE) || (t < next)){
+			kind = ALARM;
+			src = a;
+			next = t;
+		}
+	}
+	if (xRTCRunning && (pRTCCB != NULL) &&
+			clocked(CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS, 0) &&
+			rtcNext(&t) && ((kind == NONE) || (t < next))){
+		kind = RTC;
+		next = t;
+	}
+
+	if (kind == NONE){
+		xHangs++;
+		return false;
+	}
+
+	//The system timer, so awake clock, counts on if it is clocked
+	if (timer){
+		run(next - xWallUs);
+	} else {
+		sleep(next - xWallUs);
+	}
+
+	switch(kind){
+	case PAD:
+		xPulseUs[src] = 0;
+		xLevel[src] = padLevel(src);
+		if (pGPIOCB != NULL){
+			pGPIOCB(src, GPIO_IRQ_EDGE_FALL);
+		}
+		break;
+	case ALARM:
+		xAlarmArmed[src] = false;
+		if (pAlarmCB[src] != NULL){
+			pAlarmCB[src](src);
+		}
+		break;
+	case RTC:
+		pRTCCB();
+		break;
+	default:
+		break;
+	}
+	return true;
+}
+
+bool SimHAL::dormant(uint8_t pad){
+	uint64_t next;
+	bool found;
+
+	if (pad < SIM_PADS){
+		//Edge detect is armed by the dormant wake, not the IRQ
+		bool irq = xIRQ[pad];
+		xIRQ[pad] = true;
+		xLevel[pad] = padLevel(pad);
+		found = padNext(pad, &next);
+		xIRQ[pad] = irq;
+	} else {
+		found = xRTCRunning && (pRTCCB != NULL) && rtcNext(&next);
+	}
+	if (!found){
+		xHangs++;
+		return false;
+	}
+
+	sleep(next - xWallUs);
+	if (pad < SIM_PADS){
+		xPulseUs[pad] = 0;
+		xLevel[pad] = padLevel(pad);
+	}
+	return true;
+}
+
+void SimHAL::setIRQ(uint gpio, bool enabled, gpio_irq_callback_t cb){
+	if (gpio >= SIM_PADS){
+		return;
+	}
+	if (cb != NULL){
+		pGPIOCB = cb;
+	}
+	xIRQ[gpio] = enabled;
+	xLevel[gpio] = padLevel(gpio);
+}
+
+int SimHAL::claimAlarm(){
+	for (uint a = 0; a < SIM_ALARMS; a++){
+		if (!xAlarmClaimed[a]){
+			xAlarmClaimed[a] = true;
+			return a;
+		}
+	}
+	return -1;
+}
+
+void SimHAL::setAlarmCB(uint alarm, hardware_alarm_callback_t cb){
+	if (alarm < SIM_ALARMS){
+		pAlarmCB[alarm] = cb;
+	}
+}
+
+bool SimHAL::setAlarm(uint alarm, uint64_t us){
+	if (alarm >= SIM_ALARMS){
+		return true;
+	}
+	if (us <= xAwakeUs){
+		xAlarmArmed[alarm] = false;
+		return true;
+	}
+	xAlarmUs[alarm] = us;
+	xAlarmArmed[alarm] = true;
+	return false;
+}
+
+void SimHAL::cancelAlarm(uint alarm){
+	if (alarm < SIM_ALARMS){
+		xAlarmArmed[alarm] = false;
+	}
+}
+
+void SimHAL::setRTC(uint32_t epoch){
+	xRTCEpoch = epoch;
+	xRTCBaseUs = xWallUs;
+	xRTCRunning = true;
+}
+
+uint32_t SimHAL::getRTC(){
+	return xRTCEpoch + (uint32_t)((xWallUs - xRTCBaseUs) / 1000000);
+}
+
+bool SimHAL::isRTCRunning(){
+	return xRTCRunning;
+}
+
+void SimHAL::setRTCAlarm(int8_t hour, int8_t min, int8_t sec,
+		rtc_callback_t cb){
+	xRTCAlarm[0] = hour;
+	xRTCAlarm[1] = min;
+	xRTCAlarm[2] = sec;
+	pRTCCB = cb;
+}
+
+/*
+ * Pico SDK stand ins
+ */
+
+uint32_t time_us_32(void){
+	return (uint32_t)SimHAL::getAwakeUs();
+}
+
+uint64_t time_us_64(void){
+	return SimHAL::getAwakeUs();
+}
+
+void sleep_us(uint64_t us){
+	SimHAL::run(us);
+}
+
+void sleep_ms(uint32_t ms){
+	SimHAL::run((uint64_t)ms * 1000);
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate){
+	return i2c_set_baudrate(i2c, baudrate);
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate){
+	i2c->baud = (baudrate == 0) ? 100000 : baudrate;
+	return i2c->baud;
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+		size_t len, bool nostop, uint timeout_us){
+	return SimHAL::transfer(i2c, addr, src, NULL, len);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+		size_t len, bool nostop, uint timeout_us){
+	return SimHAL::transfer(i2c, addr, NULL, dst, len);
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled){
+	SimHAL::setIRQ(gpio, enabled, NULL);
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask,
+		bool enabled, gpio_irq_callback_t callback){
+	SimHAL::setIRQ(gpio, enabled, callback);
+}
+
+void __wfi(void){
+	SimHAL::wfi();
+}
+
+void clocks_init(void){
+	SimHAL::run(SIM_WAKE_US);
+}
+
+void sleep_run_from_xosc(void){
+	SimHAL::run(SIM_ENTRY_US);
+}
+
+void sleep_goto_dormant_until_pin(uint gpio_pin, bool edge, bool high){
+	SimHAL::dormant(gpio_pin);
+}
+
+void xosc_dormant(void){
+	SimHAL::dormant(SIM_PADS);
+}
+
+absolute_time_t get_absolute_time(void){
+	return SimHAL::getAwakeUs();
+}
+
+void busy_wait_us(uint64_t us){
+	SimHAL::run(us);
+}
+
+int hardware_alarm_claim_unused(bool required){
+	return SimHAL::claimAlarm();
+}
+
+void hardware_alarm_set_callback(unsigned int alarm_num,
+		hardware_alarm_callback_t callback){
+	SimHAL::setAlarmCB(alarm_num, callback);
+}
+
+bool hardware_alarm_set_target(unsigned int alarm_num, absolute_time_t t){
+	return SimHAL::setAlarm(alarm_num, t);
+}
+
+void hardware_alarm_cancel(unsigned int alarm_num){
+	SimHAL::cancelAlarm(alarm_num);
+}
+
+/*
+ * Pico RTC on the wall clock, civil dates from days since 1970
+ */
+
+static uint32_t daysFromCivil(int y, uint m, uint d){
+	if (m <= 2){
+		y--;
+	}
+	m = (m > 2) ? m - 3 : m + 9;
+	return (uint32_t)(y * 365 + y / 4 - y / 100 + y / 400) +
+			(m * 153 + 2) / 5 + (d - 1) - 719468;
+}
+
+static void civilFromDays(uint32_t days, datetime_t *t){
+	int z = days + 719468;
+	int era = z / 146097;
+	uint doe = z - era * 146097;
+	uint yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint mp = (5 * doy + 2) / 153;
+	uint m = (mp < 10) ? mp + 3 : mp - 9;
+
+	t->year = yoe + era * 400 + ((m <= 2) ? 1 : 0);
+	t->month = m;
+	t->day = doy - (153 * mp + 2) / 5 + 1;
+	t->dotw = (days + 4) % 7;
+}
+
+void rtc_init(void){
+	if (!SimHAL::isRTCRunning()){
+		SimHAL::setRTC(0);
+	}
+}
+
+bool rtc_running(void){
+	return SimHAL::isRTCRunning();
+}
+
+bool rtc_set_datetime(const datetime_t *t){
+	SimHAL::setRTC(daysFromCivil(t->year, t->month, t->day) * 86400 +
+			t->hour * 3600 + t->min * 60 + t->sec);
+	return true;
+}
+
+bool rtc_get_datetime(datetime_t *t){
+	uint32_t e = SimHAL::getRTC();
+
+	civilFromDays(e / 86400, t);
+	t->hour = (e / 3600) % 24;
+	t->min = (e / 60) % 60;
+	t->sec = e % 60;
+	return true;
+}
+
+void rtc_set_alarm(const datetime_t *t, rtc_callback_t user_callback){
+	SimHAL::setRTCAlarm(t->hour, t->min, t->sec, user_callback);
+}
+
+void rtc_disable_alarm(void){
+	SimHAL::setRTCAlarm(-1, -1, -1, NULL);
+}
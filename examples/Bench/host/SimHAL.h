@@ -0,0 +1,203 @@
+/*
+ * SimHAL.h
+ *
+ * Simulated time, I2C and wake sources for the host build.
+ *
+ * Two clocks are kept. Wall time runs always and drives the simulated
+ * devices. Awake time, returned by time_us_64, stops while asleep as
+ * the system timer does in DeepSleep. I2C transfers cost bus time at
+ * the set baud rate.
+ *
+ * __wfi sleeps to the next enabled wake source and runs its handler, so
+ * DeepSleep runs unchanged. A source only counts if its clock is left
+ * on by sleep_en0/sleep_en1 when SLEEPDEEP is set: GPIO edges always,
+ * the Pico RTC alarm with clk_rtc, timer alarms with the system timer.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_SIMHAL_H_
+#define SIM_SIMHAL_H_
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/rtc.h"
+#include "SimI2CDevice.h"
+
+//Fixed cost of each transfer, start, address and stop handling
+#ifndef SIM_I2C_SETUP_US
+#define SIM_I2C_SETUP_US 20
+#endif
+
+//Sleep entry, switch to the XOSC in sleep_run_from_xosc
+#ifndef SIM_ENTRY_US
+#define SIM_ENTRY_US 150
+#endif
+
+//Clock recovery after the wake IRQ, in clocks_init
+#ifndef SIM_WAKE_US
+#define SIM_WAKE_US 1200
+#endif
+
+#define SIM_PADS 30
+#define SIM_ALARMS 4
+
+class SimHAL {
+public:
+	/***
+	 * Attach a device to the bus
+	 * @param addr - 7 bit address
+	 * @param dev - NULL to remove
+	 */
+	static void attach(uint8_t addr, SimI2CDevice *dev);
+
+	/***
+	 * Time passes awake
+	 * @param us
+	 */
+	static void run(uint64_t us);
+
+	/***
+	 * Time passes asleep, awake clock stops
+	 * @param us
+	 */
+	static void sleep(uint64_t us);
+
+	/***
+	 * Wall time since start
+	 * @return micro seconds
+	 */
+	static uint64_t getWallUs();
+
+	/***
+	 * Awake time since start
+	 * @return micro seconds
+	 */
+	static uint64_t getAwakeUs();
+
+	/***
+	 * Transfer on the bus, for the SDK stand in
+	 * @param i2c
+	 * @param addr
+	 * @param tx - data to write or NULL to read
+	 * @param rx - buffer to read into
+	 * @param len
+	 * @return bytes or PICO_ERROR_GENERIC if no device answers
+	 */
+	static int transfer(i2c_inst_t *i2c, uint8_t addr,
+			const uint8_t *tx, uint8_t *rx, size_t len);
+
+	/***
+	 * Number of transfers on the bus
+	 * @return count
+	 */
+	static uint32_t getTransfers();
+
+	/***
+	 * Wire the interrupt line of a device to a pad
+	 * @param pad
+	 * @param dev - NULL to remove
+	 */
+	static void wire(uint8_t pad, SimI2CDevice *dev);
+
+	/***
+	 * Edge on a pad at a wall time, as a button press
+	 * @param pad
+	 * @param us - wall time
+	 */
+	static void pulse(uint8_t pad, uint64_t us);
+
+	/***
+	 * Wait for interrupt. Sleeps to the next enabled and clocked wake
+	 * source and runs its handler. If there is none the core would
+	 * never wake, this is counted and returns at once.
+	 * @return false if nothing could wake the core
+	 */
+	static bool wfi();
+
+	/***
+	 * Number of WFI nothing could wake from
+	 * @return count
+	 */
+	static uint32_t getHangs();
+
+	/***
+	 * Dormant, all clocks stopped. Sleeps to the next falling edge on
+	 * the pad, which need not have its IRQ enabled, or if no pad to the
+	 * Pico RTC alarm. No handler is run.
+	 * @param pad - >= SIM_PADS for none
+	 * @return false if nothing could wake the core
+	 */
+	static bool dormant(uint8_t pad);
+
+	/*
+	 * Backing for the SDK stand ins
+	 */
+	static void setIRQ(uint gpio, bool enabled, gpio_irq_callback_t cb);
+	static int claimAlarm();
+	static void setAlarmCB(uint alarm, hardware_alarm_callback_t cb);
+	static bool setAlarm(uint alarm, uint64_t us);
+	static void cancelAlarm(uint alarm);
+	static void setRTC(uint32_t epoch);
+	static uint32_t getRTC();
+	static bool isRTCRunning();
+	static void setRTCAlarm(int8_t hour, int8_t min, int8_t sec,
+			rtc_callback_t cb);
+
+private:
+	/***
+	 * Is the pad asserted now by its device
+	 * @param pad
+	 * @return true if asserted
+	 */
+	static bool padLevel(uint8_t pad);
+
+	/***
+	 * Wall time of the next edge on a pad with its IRQ enabled
+	 * @param pad
+	 * @param us - output
+	 * @return false if none
+	 */
+	static bool padNext(uint8_t pad, uint64_t *us);
+
+	/***
+	 * Wall time of the next Pico RTC alarm match
+	 * @param us - output
+	 * @return false if none within a day
+	 */
+	static bool rtcNext(uint64_t *us);
+
+	/***
+	 * Is a clock left running in the current sleep
+	 * @param en0 - sleep_en0 bits
+	 * @param en1 - sleep_en1 bits
+	 * @return true if running
+	 */
+	static bool clocked(uint32_t en0, uint32_t en1);
+
+	static SimI2CDevice * pDevices[128];
+	static uint64_t xWallUs;
+	static uint64_t xAwakeUs;
+	static uint32_t xTransfers;
+	static uint32_t xHangs;
+
+	static SimI2CDevice * pWired[SIM_PADS];
+	static bool xIRQ[SIM_PADS];
+	static bool xLevel[SIM_PADS];
+	static uint64_t xPulseUs[SIM_PADS];
+	static gpio_irq_callback_t pGPIOCB;
+
+	static bool xAlarmClaimed[SIM_ALARMS];
+	static bool xAlarmArmed[SIM_ALARMS];
+	static uint64_t xAlarmUs[SIM_ALARMS];
+	static hardware_alarm_callback_t pAlarmCB[SIM_ALARMS];
+
+	static bool xRTCRunning;
+	static uint32_t xRTCEpoch;
+	static uint64_t xRTCBaseUs;
+	static int8_t xRTCAlarm[3];
+	static rtc_callback_t pRTCCB;
+};
+
+#endif /* SIM_SIMHAL_H_ */
@@ -0,0 +1,47 @@
+/*
+ * SimI2CDevice.h
+ *
+ * A simulated device on the host I2C bus, attached to SimHAL at its
+ * address. Transfers are whole, as the Pico SDK presents them.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_SIMI2CDEVICE_H_
+#define SIM_SIMI2CDEVICE_H_
+
+#include "pico/stdlib.h"
+
+class SimI2CDevice {
+public:
+	virtual ~SimI2CDevice() {}
+
+	/***
+	 * Controller writes to the device
+	 * @param src
+	 * @param len
+	 * @return bytes accepted or PICO_ERROR_GENERIC for a NACK
+	 */
+	virtual int write(const uint8_t *src, size_t len) = 0;
+
+	/***
+	 * Controller reads from the device
+	 * @param dst
+	 * @param len
+	 * @return bytes read or PICO_ERROR_GENERIC for a NACK
+	 */
+	virtual int read(uint8_t *dst, size_t len) = 0;
+
+	/***
+	 * Wall time the device interrupt line is next asserted, current wall
+	 * time if already asserted
+	 * @param us - output
+	 * @return false if it has no interrupt pending
+	 */
+	virtual bool nextInterrupt(uint64_t *us) {
+		return false;
+	}
+};
+
+#endif /* SIM_SIMI2CDEVICE_H_ */
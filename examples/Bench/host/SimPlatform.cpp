@@ -0,0 +1,108 @@
+/*
+ * SimPlatform.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SimPlatform.h"
+#include "SimHAL.h"
+#include "PulseCounter.h"
+
+#define SIM_DS3231_ADDR 0x68
+
+SimPlatform::SimPlatform() {
+	SimHAL::attach(SIM_DS3231_ADDR, &xModel);
+	SimHAL::wire(SIM_WAKE_PAD, &xModel);
+	pRTC = new DS3231(i2c0, 12, 13);
+	pDeepSleep = DeepSleep::singleton();
+	pDeepSleep->setRTC(pRTC, SIM_WAKE_PAD);
+	pDeepSleep->addObserver(this);
+}
+
+SimPlatform::~SimPlatform() {
+	pDeepSleep->delObserver(this);
+	pDeepSleep->setRTC(NULL);
+	SimHAL::wire(SIM_WAKE_PAD, NULL);
+	SimHAL::attach(SIM_DS3231_ADDR, NULL);
+	delete pRTC;
+}
+
+const char * SimPlatform::getName(){
+	return "sim";
+}
+
+uint64_t SimPlatform::nowUs(){
+	return time_us_64();
+}
+
+DS3231 * SimPlatform::getRTC(){
+	return pRTC;
+}
+
+SimDS3231 * SimPlatform::getModel(){
+	return &xModel;
+}
+
+bool SimPlatform::supports(BenchScenario s){
+	return (s < BENCH_SCENARIOS);
+}
+
+void SimPlatform::notifyClocksChanged(){
+	if (xEntryUs == 0){
+		xEntryUs = time_us_64();
+	}
+}
+
+void SimPlatform::cycle(BenchScenario s, uint minutes, BenchCycle *res){
+	res->ok = true;
+	switch(s){
+	case BENCH_RTC_SLEEP:
+		sleep(minutes, res);
+		break;
+	case BENCH_GPIO_WAKE:
+		SimHAL::pulse(SIM_WAKE_PAD,
+				SimHAL::getWallUs() + (uint64_t)SIM_GPIO_PERIOD_S * 1000000);
+		sleep(0, res);
+		break;
+	case BENCH_PWM_COUNT: {
+		sleep(minutes, res);
+		//Count continues asleep, each wrap is a short background wake
+		uint64_t pulses = xPulseRem + (res->sleptUs * SIM_PULSE_HZ) / 1000000;
+		res->pulses = (res->sleptUs * SIM_PULSE_HZ) / 1000000;
+		SimHAL::run((pulses / PULSE_COUNTER_WRAP) * SIM_WRAP_US);
+		xPulseRem = pulses % PULSE_COUNTER_WRAP;
+		break;
+	}
+	case BENCH_WIFI_JOIN:
+		SimHAL::run(SIM_JOIN_US);
+		res->radioUs = SIM_JOIN_US;
+		sleep(minutes, res);
+		break;
+	default:
+		res->ok = false;
+		break;
+	}
+}
+
+void SimPlatform::sleep(uint minutes, BenchCycle *res){
+	uint64_t wall = SimHAL::getWallUs();
+	uint64_t awake = SimHAL::getAwakeUs();
+	uint32_t hangs = SimHAL::getHangs();
+	uint32_t failures = pDeepSleep->getTimerFailures();
+
+	xEntryUs = 0;
+	if (minutes == 0){
+		pDeepSleep->sleep((uint8_t)SIM_WAKE_PAD);
+	} else {
+		pDeepSleep->sleep(minutes, SIM_WAKE_PAD);
+	}
+	res->wakeUs = (uint32_t)(time_us_64() - xEntryUs);
+	res->sleptUs += (SimHAL::getWallUs() - wall) - (SimHAL::getAwakeUs() - awake);
+
+	//Never woke, or fell back from the DS3231 to the Pico RTC
+	if ((SimHAL::getHangs() != hangs) ||
+			(pDeepSleep->getTimerFailures() != failures)){
+		res->ok = false;
+	}
+}
@@ -0,0 +1,85 @@
+/*
+ * SimPlatform.h
+ *
+ * Bench platform on the host. Sleeps go through DeepSleep, as on the
+ * target, with the DS3231 driver and DS3231WakeTimer against SimDS3231
+ * and its INT/SQW wired to the wake pad. So the sleep entry, wake IRQ,
+ * recovery and I2C traffic are those of the real code, timed by the
+ * SimHAL costs. Counter wraps and the radio join, which the host cannot
+ * run, are modelled by the constants here.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_SIMPLATFORM_H_
+#define SIM_SIMPLATFORM_H_
+
+#include "Bench.h"
+#include "DeepSleep.h"
+#include "DormantNotification.h"
+#include "SimDS3231.h"
+
+//Pad the DS3231 INT/SQW is wired to
+#ifndef SIM_WAKE_PAD
+#define SIM_WAKE_PAD 15
+#endif
+
+//Time before the simulated GPIO wake
+#ifndef SIM_GPIO_PERIOD_S
+#define SIM_GPIO_PERIOD_S 30
+#endif
+
+//Pulse rate and cost of each counter wrap IRQ
+#ifndef SIM_PULSE_HZ
+#define SIM_PULSE_HZ 2000
+#endif
+
+#ifndef SIM_WRAP_US
+#define SIM_WRAP_US 40
+#endif
+
+//Radio power up and full join
+#ifndef SIM_JOIN_US
+#define SIM_JOIN_US 1800000
+#endif
+
+class SimPlatform : public BenchPlatform, public DormantNotification {
+public:
+	SimPlatform();
+	virtual ~SimPlatform();
+
+	virtual const char * getName();
+	virtual uint64_t nowUs();
+	virtual DS3231 * getRTC();
+	virtual bool supports(BenchScenario s);
+	virtual void cycle(BenchScenario s, uint minutes, BenchCycle *res);
+
+	/***
+	 * The DS3231 model, to inject faults
+	 * @return model
+	 */
+	SimDS3231 * getModel();
+
+	/***
+	 * Time the first clock change of each sleep, the entry
+	 */
+	virtual void notifyClocksChanged();
+
+private:
+	/***
+	 * Sleep through DeepSleep, timed by the DS3231 alarm or untimed
+	 * until the wake pad
+	 * @param minutes - 0 for untimed
+	 * @param res
+	 */
+	void sleep(uint minutes, BenchCycle *res);
+
+	SimDS3231 xModel;
+	DS3231 *pRTC;
+	DeepSleep *pDeepSleep;
+	uint64_t xPulseRem = 0;
+	uint64_t xEntryUs = 0;
+};
+
+#endif /* SIM_SIMPLATFORM_H_ */
@@ -0,0 +1,70 @@
+/*
+ * hardware/clocks.h
+ *
+ * Host stand in for the Pico SDK clocks. The sleep enable registers are
+ * read by SimHAL to decide which wake sources are clocked in deep sleep,
+ * and clocks_init costs the simulated clock recovery time.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_CLOCKS_H_
+#define SIM_HARDWARE_CLOCKS_H_
+
+#include "pico/stdlib.h"
+
+enum clock_index {
+	clk_gpout0 = 0,
+	clk_gpout1,
+	clk_gpout2,
+	clk_gpout3,
+	clk_ref,
+	clk_sys,
+	clk_peri,
+	clk_usb,
+	clk_adc,
+	clk_rtc,
+	CLK_COUNT
+};
+
+typedef struct {
+	io_rw_32 wake_en0;
+	io_rw_32 wake_en1;
+	io_rw_32 sleep_en0;
+	io_rw_32 sleep_en1;
+} clocks_hw_t;
+
+extern clocks_hw_t *clocks_hw;
+
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS		0x80000000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS		0x40000000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS		0x20000000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS		0x10000000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS		0x01000000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PIO1_BITS		0x00400000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS		0x00200000u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_JTAG_BITS		0x00000800u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS		0x00000080u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS	0x00000010u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_RTC_BITS		0x00000008u
+#define CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS		0x00000004u
+#define CLOCKS_SLEEP_EN0_CLK_SYS_ADC_BITS		0x00000002u
+#define CLOCKS_SLEEP_EN0_CLK_ADC_ADC_BITS		0x00000001u
+
+#define CLOCKS_SLEEP_EN1_CLK_SYS_UART1_BITS		0x00000800u
+#define CLOCKS_SLEEP_EN1_CLK_PERI_UART1_BITS	0x00000400u
+#define CLOCKS_SLEEP_EN1_CLK_SYS_UART0_BITS		0x00000200u
+#define CLOCKS_SLEEP_EN1_CLK_PERI_UART0_BITS	0x00000100u
+#define CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS	0x00000020u
+#define CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS	0x00000010u
+#define CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS		0x00000004u
+
+void clocks_init(void);
+
+static inline bool clock_configure_gpin(enum clock_index clk, uint gpio,
+		uint32_t src_freq, uint32_t freq) {
+	return true;
+}
+
+#endif /* SIM_HARDWARE_CLOCKS_H_ */
@@ -0,0 +1,34 @@
+/*
+ * hardware/i2c.h
+ *
+ * Host stand in for the Pico SDK I2C, transfers go to the simulated
+ * devices attached in SimHAL.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_I2C_H_
+#define SIM_HARDWARE_I2C_H_
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst {
+	uint baud;
+} i2c_inst_t;
+
+extern i2c_inst_t i2c0_inst;
+extern i2c_inst_t i2c1_inst;
+
+#define i2c0 (&i2c0_inst)
+#define i2c1 (&i2c1_inst)
+#define i2c_default i2c0
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src,
+		size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst,
+		size_t len, bool nostop, uint timeout_us);
+
+#endif /* SIM_HARDWARE_I2C_H_ */
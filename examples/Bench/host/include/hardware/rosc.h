@@ -0,0 +1,27 @@
+/*
+ * hardware/rosc.h
+ *
+ * Host stand in for the Pico SDK ring oscillator.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_ROSC_H_
+#define SIM_HARDWARE_ROSC_H_
+
+#include "pico/stdlib.h"
+
+#define ROSC_CTRL_ENABLE_LSB 12
+
+typedef struct {
+	io_rw_32 ctrl;
+} rosc_hw_t;
+
+extern rosc_hw_t *rosc_hw;
+
+static inline void rosc_write(io_rw_32 *addr, uint32_t value) {
+	*addr = value;
+}
+
+#endif /* SIM_HARDWARE_ROSC_H_ */
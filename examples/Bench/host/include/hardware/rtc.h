@@ -0,0 +1,27 @@
+/*
+ * hardware/rtc.h
+ *
+ * Host stand in for the Pico RTC. Keeps time from the SimHAL wall clock,
+ * the alarm fires from SimHAL::wfi while clk_rtc is clocked. Only the
+ * sec, min and hour alarm fields are matched, the rest must be -1.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_RTC_H_
+#define SIM_HARDWARE_RTC_H_
+
+#include "pico/stdlib.h"
+#include "pico/util/datetime.h"
+
+typedef void (*rtc_callback_t)(void);
+
+void rtc_init(void);
+bool rtc_running(void);
+bool rtc_set_datetime(const datetime_t *t);
+bool rtc_get_datetime(datetime_t *t);
+void rtc_set_alarm(const datetime_t *t, rtc_callback_t user_callback);
+void rtc_disable_alarm(void);
+
+#endif /* SIM_HARDWARE_RTC_H_ */
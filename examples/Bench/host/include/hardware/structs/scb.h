@@ -0,0 +1,24 @@
+/*
+ * hardware/structs/scb.h
+ *
+ * Host stand in for the Cortex-M0+ system control block. SimHAL reads
+ * SLEEPDEEP to decide whether the clocks are gated during a WFI.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_STRUCTS_SCB_H_
+#define SIM_HARDWARE_STRUCTS_SCB_H_
+
+#include "pico/stdlib.h"
+
+#define M0PLUS_SCR_SLEEPDEEP_BITS 0x00000004u
+
+typedef struct {
+	io_rw_32 scr;
+} scb_hw_t;
+
+extern scb_hw_t *scb_hw;
+
+#endif /* SIM_HARDWARE_STRUCTS_SCB_H_ */
@@ -0,0 +1,25 @@
+/*
+ * hardware/sync.h
+ *
+ * Host stand in for the Pico SDK sync. The simulator is single threaded
+ * and IRQ handlers run from within __wfi, so masking does nothing.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_SYNC_H_
+#define SIM_HARDWARE_SYNC_H_
+
+#include "pico/stdlib.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+	return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {}
+
+//Sleep until the next enabled wake source, see SimHAL::wfi
+void __wfi(void);
+
+#endif /* SIM_HARDWARE_SYNC_H_ */
@@ -0,0 +1,36 @@
+/*
+ * hardware/timer.h
+ *
+ * Host stand in for the Pico SDK system timer and its alarms. The timer
+ * is the SimHAL awake clock, alarms fire from SimHAL::wfi and only while
+ * the timer is clocked.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_TIMER_H_
+#define SIM_HARDWARE_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint64_t absolute_time_t;
+typedef void (*hardware_alarm_callback_t)(unsigned int alarm_num);
+
+#define NUM_TIMERS 4
+
+absolute_time_t get_absolute_time(void);
+void busy_wait_us(uint64_t us);
+
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) {
+	return t + us;
+}
+
+int hardware_alarm_claim_unused(bool required);
+void hardware_alarm_set_callback(unsigned int alarm_num,
+		hardware_alarm_callback_t callback);
+bool hardware_alarm_set_target(unsigned int alarm_num, absolute_time_t t);
+void hardware_alarm_cancel(unsigned int alarm_num);
+
+#endif /* SIM_HARDWARE_TIMER_H_ */
@@ -0,0 +1,19 @@
+/*
+ * hardware/xosc.h
+ *
+ * Host stand in for the Pico SDK crystal oscillator. Going dormant
+ * sleeps to the Pico RTC alarm, as if the RTC ran from an external
+ * clock.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_HARDWARE_XOSC_H_
+#define SIM_HARDWARE_XOSC_H_
+
+#include "pico/stdlib.h"
+
+void xosc_dormant(void);
+
+#endif /* SIM_HARDWARE_XOSC_H_ */
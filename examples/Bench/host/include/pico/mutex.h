@@ -0,0 +1,36 @@
+/*
+ * pico/mutex.h
+ *
+ * Host stand in for the Pico SDK mutex, the simulator is single threaded.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_PICO_MUTEX_H_
+#define SIM_PICO_MUTEX_H_
+
+#include "pico/stdlib.h"
+
+typedef struct {
+	int depth;
+} recursive_mutex_t;
+
+static inline void recursive_mutex_init(recursive_mutex_t *mtx) {
+	mtx->depth = 0;
+}
+
+static inline void recursive_mutex_enter_blocking(recursive_mutex_t *mtx) {
+	mtx->depth++;
+}
+
+static inline bool recursive_mutex_enter_timeout_ms(recursive_mutex_t *mtx, uint32_t ms) {
+	mtx->depth++;
+	return true;
+}
+
+static inline void recursive_mutex_exit(recursive_mutex_t *mtx) {
+	mtx->depth--;
+}
+
+#endif /* SIM_PICO_MUTEX_H_ */
@@ -0,0 +1,13 @@
+/*
+ * pico/runtime_init.h
+ *
+ * Host stand in for the Pico SDK runtime init, nothing is needed.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_PICO_RUNTIME_INIT_H_
+#define SIM_PICO_RUNTIME_INIT_H_
+
+#endif /* SIM_PICO_RUNTIME_INIT_H_ */
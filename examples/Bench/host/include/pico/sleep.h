@@ -0,0 +1,21 @@
+/*
+ * pico/sleep.h
+ *
+ * Host stand in for the pico-extras sleep, costs the simulated entry
+ * time of the switch to the XOSC. Dormant until a pin sleeps to the
+ * next falling edge on the pad.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_PICO_SLEEP_H_
+#define SIM_PICO_SLEEP_H_
+
+#include "pico/stdlib.h"
+
+void sleep_run_from_xosc(void);
+
+void sleep_goto_dormant_until_pin(uint gpio_pin, bool edge, bool high);
+
+#endif /* SIM_PICO_SLEEP_H_ */
@@ -0,0 +1,75 @@
+/*
+ * pico/stdlib.h
+ *
+ * Host stand in for the Pico SDK, just enough for the DS3231, I2C bus,
+ * wake timers, DeepSleep and sample buffer sources to build against the
+ * simulator. Time and GPIO interrupts are simulated by SimHAL, other
+ * GPIO calls do nothing.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_PICO_STDLIB_H_
+#define SIM_PICO_STDLIB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+typedef volatile uint32_t io_rw_32;
+
+#define PICO_OK					0
+#define PICO_ERROR_GENERIC		-1
+#define PICO_ERROR_TIMEOUT		-2
+
+#define PICO_DEFAULT_I2C_SDA_PIN	4
+#define PICO_DEFAULT_I2C_SCL_PIN	5
+
+#define __uninitialized_ram(x)	x
+#define __not_in_flash_func(x)	x
+#define count_of(a)				(sizeof(a) / sizeof((a)[0]))
+
+#define GPIO_OUT	1
+#define GPIO_IN		0
+
+#define GPIO_IRQ_LEVEL_LOW	0x1u
+#define GPIO_IRQ_LEVEL_HIGH	0x2u
+#define GPIO_IRQ_EDGE_FALL	0x4u
+#define GPIO_IRQ_EDGE_RISE	0x8u
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+enum gpio_function {
+	GPIO_FUNC_I2C = 3,
+	GPIO_FUNC_PWM = 4,
+	GPIO_FUNC_SIO = 5
+};
+
+static inline void gpio_init(uint gpio) {}
+static inline void gpio_set_dir(uint gpio, bool out) {}
+static inline void gpio_put(uint gpio, bool value) {}
+static inline void gpio_pull_up(uint gpio) {}
+static inline void gpio_disable_pulls(uint gpio) {}
+static inline void gpio_set_function(uint gpio, enum gpio_function fn) {}
+
+static inline void uart_default_tx_wait_blocking(void) {}
+static inline bool stdio_init_all(void) { return true; }
+static inline uint get_core_num(void) { return 0; }
+
+//Simulated GPIO interrupts, see SimHAL
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask,
+		bool enabled, gpio_irq_callback_t callback);
+
+//Simulated awake time, see SimHAL
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+#include "hardware/timer.h"
+
+#endif /* SIM_PICO_STDLIB_H_ */
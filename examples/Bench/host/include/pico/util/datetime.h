@@ -0,0 +1,25 @@
+/*
+ * pico/util/datetime.h
+ *
+ * Host stand in for the Pico SDK datetime.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SIM_PICO_UTIL_DATETIME_H_
+#define SIM_PICO_UTIL_DATETIME_H_
+
+#include <stdint.h>
+
+typedef struct {
+	int16_t year;
+	int8_t month;
+	int8_t day;
+	int8_t dotw;
+	int8_t hour;
+	int8_t min;
+	int8_t sec;
+} datetime_t;
+
+#endif /* SIM_PICO_UTIL_DATETIME_H_ */
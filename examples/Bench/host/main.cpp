@@ -0,0 +1,44 @@
+/**
+ * Sleep and wake benchmark on the host simulator
+ *
+ * Runs the same scenarios as the target harness and prints the same
+ * BENCH CSV lines. Simulated time makes the output deterministic, so it
+ * can be checked against baseline.csv with gate.py on every change.
+ *
+ * Usage: bench_sim [cycles] [trace]
+ * With trace the RTC I2C trace is dumped after the run, for i2c_replay
+ */
+
+#include "Bench.h"
+#include "SimPlatform.h"
+#include <stdlib.h>
+#include <cstdio>
+#include <cstring>
+
+#define SIM_CYCLES 5
+
+int main(int argc, char **argv) {
+	uint cycles = SIM_CYCLES;
+	bool trace = false;
+
+	if (argc > 1){
+		cycles = atoi(argv[1]);
+	}
+	if ((argc > 2) && (strcmp(argv[2], "trace") == 0)){
+		trace = true;
+	}
+
+	SimPlatform platform;
+	Bench bench(&platform);
+	if (trace){
+		I2CTrace::singleton()->clear();
+		bench.setTrace(I2CTrace::singleton());
+	}
+
+	bench.run(cycles);
+	printf("BENCH,done\n");
+	if (trace){
+		I2CTrace::singleton()->dump();
+	}
+	return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * Bench.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "Bench.h"
+#include "SampleBuffer.h"
+#include <stdio.h>
+
+static const char * xScenarioNames[BENCH_SCENARIOS] = {
+	"rtc_sleep",
+	"gpio_wake",
+	"pwm_count",
+	"wifi_join"
+};
+
+Bench::Bench(BenchPlatform *platform) {
+	pPlatform = platform;
+	SampleBuffer::singleton()->setRTC(platform->getRTC());
+}
+
+Bench::~Bench() {
+	// NOP
+}
+
+void Bench::printHeader(){
+	printf("BENCH,platform,scenario,cycles,fails,wake_us,i2c,awake_us,charge_uC,pulses\n");
+}
+
+void Bench::setTrace(I2CTrace *trace){
+	pTrace = trace;
+	pPlatform->getRTC()->set_trace(trace);
+}
+
+const char * Bench::getScenarioName(BenchScenario s){
+	if (s >= BENCH_SCENARIOS){
+		return "unknown";
+	}
+	return xScenarioNames[s];
+}
+
+void Bench::run(uint cycles){
+	printHeader();
+	for (uint s = 0; s < BENCH_SCENARIOS; s++){
+		runScenario((BenchScenario)s, cycles);
+	}
+}
+
+bool Bench::runScenario(BenchScenario s, uint cycles){
+	DS3231 *rtc = pPlatform->getRTC();
+	uint fails = 0;
+	uint64_t wakeUs = 0;
+	uint64_t awakeUs = 0;
+	uint64_t sleptUs = 0;
+	uint64_t radioUs = 0;
+	uint64_t pulses = 0;
+	uint32_t i2c = 0;
+
+	if (!pPlatform->supports(s) || (cycles == 0)){
+		return false;
+	}
+
+	for (uint c = 0; c < cycles; c++){
+		BenchCycle res = {false, 0, 0, 0, 0, 0};
+		uint32_t trans = rtc->get_timing()->transactions;
+		uint64_t start = pPlatform->nowUs();
+
+		if (pTrace != NULL){
+			pTrace->mark(s);
+		}
+		work();
+		pPlatform->cycle(s, BENCH_SLEEP_MIN, &res);
+
+		//Awake clock does not run asleep so this is time awake
+		awakeUs += pPlatform->nowUs() - start;
+		i2c += rtc->get_timing()->transactions - trans - res.i2cOverhead;
+		wakeUs += res.wakeUs;
+		sleptUs += res.sleptUs;
+		radioUs += res.radioUs;
+		pulses += res.pulses;
+		if (!res.ok){
+			fails++;
+		}
+	}
+
+	//mA x us is nC, uA x s is uC
+	double charge = ((double)awakeUs * BENCH_AWAKE_MA / 1000.0) +
+			((double)sleptUs / 1000000.0 * BENCH_SLEEP_UA) +
+			((double)radioUs * BENCH_RADIO_MA / 1000.0);
+
+	printf("BENCH,%s,%s,%u,%u,%lu,%lu,%lu,%.1f,%lu\n",
+			pPlatform->getName(),
+			getScenarioName(s),
+			cycles,
+			fails,
+			(unsigned long)(wakeUs / cycles),
+			(unsigned long)(i2c / cycles),
+			(unsigned long)(awakeUs / cycles),
+			charge / cycles,
+			(unsigned long)(pulses / cycles));
+	return true;
+}
+
+void Bench::work(){
+	//Stamp and store a sample, as a sensor node does on each wake
+	SampleBuffer::singleton()->add(0, xValue++);
+}
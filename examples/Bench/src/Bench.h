@@ -0,0 +1,149 @@
+/*
+ * Bench.h
+ *
+ * Standard sleep and wake scenarios run against a BenchPlatform, either
+ * the hardware or the host simulator. Both print the same CSV lines so
+ * a run can be checked against baseline.csv with gate.py.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_BENCH_H_
+#define SRC_BENCH_H_
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+#include "I2CTrace.h"
+
+//Charge model, currents while awake, asleep and extra with radio on
+#ifndef BENCH_AWAKE_MA
+#define BENCH_AWAKE_MA 20.0
+#endif
+
+#ifndef BENCH_SLEEP_UA
+#define BENCH_SLEEP_UA 800.0
+#endif
+
+#ifndef BENCH_RADIO_MA
+#define BENCH_RADIO_MA 60.0
+#endif
+
+//Minutes slept each cycle by the timed scenarios
+#ifndef BENCH_SLEEP_MIN
+#define BENCH_SLEEP_MIN 1
+#endif
+
+enum BenchScenario {
+	BENCH_RTC_SLEEP = 0,	// Timed sleep woken by the DS3231 alarm
+	BENCH_GPIO_WAKE,		// Untimed sleep woken by a pad
+	BENCH_PWM_COUNT,		// Timed sleep counting pulses
+	BENCH_WIFI_JOIN,		// Full join, then timed sleep with radio off
+	BENCH_SCENARIOS
+};
+
+/***
+ * Measurements of one sleep by the platform
+ */
+struct BenchCycle {
+	bool		ok;
+	uint64_t	sleptUs;	// Time asleep
+	uint32_t	wakeUs;		// Last clock change before sleep to return
+	uint32_t	radioUs;	// Radio on
+	uint32_t	i2cOverhead;// Transactions made only to measure
+	uint64_t	pulses;
+};
+
+class BenchPlatform {
+public:
+	virtual ~BenchPlatform() {}
+
+	/***
+	 * Name printed in the report, such as target or sim
+	 * @return name
+	 */
+	virtual const char * getName() = 0;
+
+	/***
+	 * Awake time, must not advance while asleep
+	 * @return micro seconds
+	 */
+	virtual uint64_t nowUs() = 0;
+
+	/***
+	 * RTC used for the cycle work and I2C counts
+	 * @return rtc
+	 */
+	virtual DS3231 * getRTC() = 0;
+
+	/***
+	 * Can the platform run the scenario
+	 * @param s
+	 * @return true if supported
+	 */
+	virtual bool supports(BenchScenario s) = 0;
+
+	/***
+	 * Sleep once as the scenario requires
+	 * @param s - scenario
+	 * @param minutes - for timed scenarios
+	 * @param res - measurements
+	 */
+	virtual void cycle(BenchScenario s, uint minutes, BenchCycle *res) = 0;
+};
+
+class Bench {
+public:
+	/***
+	 * Constructor
+	 * @param platform - hardware or simulator
+	 */
+	Bench(BenchPlatform *platform);
+
+	virtual ~Bench();
+
+	/***
+	 * Run every scenario the platform supports
+	 * @param cycles - sleeps per scenario
+	 */
+	void run(uint cycles);
+
+	/***
+	 * Run a scenario and print its line
+	 * @param s
+	 * @param cycles
+	 * @return false if not supported
+	 */
+	bool runScenario(BenchScenario s, uint cycles);
+
+	/***
+	 * Print the CSV header
+	 */
+	static void printHeader();
+
+	/***
+	 * Name of a scenario as in the report
+	 * @param s
+	 * @return name
+	 */
+	static const char * getScenarioName(BenchScenario s);
+
+	/***
+	 * Trace the RTC I2C traffic with a mark at the start of each cycle,
+	 * tagged with the scenario
+	 * @param trace - NULL for none
+	 */
+	void setTrace(I2CTrace *trace);
+
+private:
+	/***
+	 * Work done on each wake, the same for all platforms
+	 */
+	void work();
+
+	BenchPlatform *pPlatform;
+	I2CTrace *pTrace = NULL;
+	int32_t xValue = 0;
+};
+
+#endif /* SRC_BENCH_H_ */
@@ -0,0 +1,103 @@
+/*
+ * TargetPlatform.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "TargetPlatform.h"
+#include <stdio.h>
+
+TargetPlatform::TargetPlatform(DS3231 *rtc, uint8_t wakePad, uint8_t countPad) :
+		xCounter(countPad) {
+	pRTC = rtc;
+	xWakePad = wakePad;
+	pDeepSleep = DeepSleep::singleton();
+	pDeepSleep->setRTC(rtc, wakePad);
+	pDeepSleep->addObserver(this);
+	xCounting = xCounter.start();
+#if BENCH_WIFI
+	xRadio.setCredentials(WIFI_SSID, WIFI_PASSWORD);
+	pDeepSleep->addObserver(&xRadio);
+#endif
+}
+
+TargetPlatform::~TargetPlatform() {
+	pDeepSleep->delObserver(this);
+}
+
+const char * TargetPlatform::getName(){
+	return "target";
+}
+
+uint64_t TargetPlatform::nowUs(){
+	return time_us_64();
+}
+
+DS3231 * TargetPlatform::getRTC(){
+	return pRTC;
+}
+
+bool TargetPlatform::supports(BenchScenario s){
+	switch(s){
+	case BENCH_RTC_SLEEP:
+	case BENCH_GPIO_WAKE:
+		return true;
+	case BENCH_PWM_COUNT:
+		return xCounting;
+	case BENCH_WIFI_JOIN:
+		return BENCH_WIFI;
+	default:
+		return false;
+	}
+}
+
+void TargetPlatform::notifyClocksChanged(){
+	if (xEntryUs == 0){
+		xEntryUs = time_us_64();
+	}
+}
+
+uint32_t TargetPlatform::epoch(BenchCycle *res){
+	uint32_t trans = pRTC->get_timing()->transactions;
+	uint32_t e = pRTC->get_epoch();
+
+	res->i2cOverhead += pRTC->get_timing()->transactions - trans;
+	return e;
+}
+
+void TargetPlatform::cycle(BenchScenario s, uint minutes, BenchCycle *res){
+	uint64_t pulses = xCounter.getCount();
+
+#if BENCH_WIFI
+	if (s == BENCH_WIFI_JOIN){
+		uint64_t radio = time_us_64();
+		res->ok = xRadio.up();
+		xRadio.down();
+		res->radioUs = time_us_64() - radio;
+	} else {
+		res->ok = true;
+	}
+#else
+	res->ok = true;
+#endif
+
+	uint32_t before = epoch(res);
+	uart_default_tx_wait_blocking();
+
+	xEntryUs = 0;
+	if (s == BENCH_GPIO_WAKE){
+		pDeepSleep->sleep(xWakePad);
+	} else {
+		pDeepSleep->sleep(minutes, xWakePad);
+	}
+	res->wakeUs = time_us_64() - xEntryUs;
+
+	uint32_t after = epoch(res);
+	if ((before == 0) || (after < before)){
+		res->ok = false;
+	} else {
+		res->sleptUs = (uint64_t)(after - before) * 1000000;
+	}
+	res->pulses = xCounter.getCount() - pulses;
+}
@@ -0,0 +1,72 @@
+/*
+ * TargetPlatform.h
+ *
+ * Bench platform on the hardware. DeepSleep woken by the DS3231 alarm
+ * on the wake pad, PulseCounter for pulses and, with BENCH_WIFI, the
+ * CYW43 radio joined on each cycle.
+ *
+ * The system timer is not clocked in DeepSleep, so time_us_64 only
+ * counts time awake.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_TARGETPLATFORM_H_
+#define SRC_TARGETPLATFORM_H_
+
+#include "Bench.h"
+#include "DeepSleep.h"
+#include "PulseCounter.h"
+#include "DormantNotification.h"
+
+#ifndef BENCH_WIFI
+#define BENCH_WIFI 0
+#endif
+
+#if BENCH_WIFI
+#include "CYW43Power.h"
+#endif
+
+class TargetPlatform : public BenchPlatform, public DormantNotification {
+public:
+	/***
+	 * Constructor
+	 * @param rtc - DS3231 with INT/SQW wired to wakePad
+	 * @param wakePad - GPIO Pad for wake
+	 * @param countPad - GPIO Pad for pulses, PWM channel B
+	 */
+	TargetPlatform(DS3231 *rtc, uint8_t wakePad, uint8_t countPad);
+	virtual ~TargetPlatform();
+
+	virtual const char * getName();
+	virtual uint64_t nowUs();
+	virtual DS3231 * getRTC();
+	virtual bool supports(BenchScenario s);
+	virtual void cycle(BenchScenario s, uint minutes, BenchCycle *res);
+
+	/***
+	 * Time the first clock change of each sleep, the entry
+	 */
+	virtual void notifyClocksChanged();
+
+private:
+	/***
+	 * Read RTC for the sleep time, counting the transaction as overhead
+	 * @param res
+	 * @return epoch
+	 */
+	uint32_t epoch(BenchCycle *res);
+
+	DeepSleep *pDeepSleep;
+	DS3231 *pRTC;
+	uint8_t xWakePad;
+	PulseCounter xCounter;
+	bool xCounting = false;
+	volatile uint64_t xEntryUs = 0;
+#if BENCH_WIFI
+	CYW43Power xRadio;
+#endif
+};
+
+#endif /* SRC_TARGETPLATFORM_H_ */
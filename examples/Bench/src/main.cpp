@@ -0,0 +1,60 @@
+/**
+ * Sleep and wake benchmark on a Raspberry PI Pico
+ *
+ * Runs the standard scenarios and prints BENCH CSV lines on the UART,
+ * the same format as the host simulator in host/. Capture the output
+ * and check it with gate.py against baseline.csv.
+ *
+ * RTC DS3231 connected on I2C to GP12 & 13
+ * RTC SQW used for interupt to wake on GP10, also used by the GPIO
+ * scenario so needs a jig or the alarm to pull it low
+ * Pulses to count on GP15
+ */
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+#include "I2CBus.h"
+#include "Bench.h"
+#include "TargetPlatform.h"
+#include <cstdio>
+
+#define SDA_PAD 12
+#define SCL_PAD 13
+#define WAKE_PAD 10
+#define COUNT_PAD 15
+
+#ifndef BENCH_CYCLES
+#define BENCH_CYCLES 5
+#endif
+
+//Dump the RTC I2C trace after the run, for host/i2c_replay
+#ifndef BENCH_TRACE
+#define BENCH_TRACE 0
+#endif
+
+int main() {
+    stdio_init_all();
+    sleep_ms(2000);
+    printf("GO\n");
+
+    I2CBus bus(i2c0, SDA_PAD, SCL_PAD);
+    DS3231 rtc(&bus);
+
+    TargetPlatform platform(&rtc, WAKE_PAD, COUNT_PAD);
+    Bench bench(&platform);
+#if BENCH_TRACE
+    I2CTrace::singleton()->clear();
+    bench.setTrace(I2CTrace::singleton());
+#endif
+
+    bench.run(BENCH_CYCLES);
+    printf("BENCH,done\n");
+#if BENCH_TRACE
+    I2CTrace::singleton()->dump();
+#endif
+    uart_default_tx_wait_blocking();
+
+    while (true) {
+    	sleep_ms(1000);
+    }
+}
@@ -4,19 +4,28 @@
  *
  * Use Internal RTC for recovery
  *
- * Count while sleep and awake using PWM on GPIO 15
+ * Count while sleep and awake using PWM on GPIO 15.
+ * PulseCounter extends the 16 bit PWM count, waking briefly on each
+ * wrap and going straight back to sleep.
+ *
+ * Count on GPIO 6 and 7 using PIO. Sleep ends early once GPIO 6
+ * has seen PIO_THRESHOLD pulses.
  */
 
 #include "pico/stdlib.h"
 #include "DeepSleep.h"
 #include <cstdio>
 #include "hardware/gpio.h"
-#include "hardware/pwm.h"
+#include "PulseCounter.h"
+#include "PIOCounter.h"
 
 
 #define LED_PAD 2
 #define DELAY 500 // in microseconds
 #define COUNT_PAD 15
+#define PIO_PAD_A 6
+#define PIO_PAD_B 7
+#define PIO_THRESHOLD 100
 
 void flash(uint count=1){
 	const uint LED_PIN = LED_PAD;
@@ -29,27 +38,6 @@ void flash(uint count=1){
 	}
 }
 
-uint slice_num;
-void setupPwmCount(uint8_t gp){
-    gpio_init(gp);
-    gpio_pull_up(gp);
-    gpio_set_dir(gp, GPIO_IN);
-
-    if (pwm_gpio_to_channel(gp) != PWM_CHAN_B){
-    	printf("ERROR - GPIO Must be PWM Channel B\n");
-    }
-   slice_num = pwm_gpio_to_slice_num(gp);
-
-   // Count once for every 1 cycles the PWM B input is HIGH
-   pwm_config cfg = pwm_get_default_config();
-   pwm_config_set_clkdiv_mode(&cfg, PWM_DIV_B_FALLING);
-   pwm_config_set_clkdiv(&cfg, 1);
-   pwm_init(slice_num, &cfg, false);
-   gpio_set_function(gp, GPIO_FUNC_PWM);
-   pwm_set_enabled(slice_num, true);
-}
-
-
 int main() {
 	uint resurrect = 0;
     stdio_init_all();
@@ -62,25 +50,42 @@ int main() {
     gpio_set_dir(LED_PIN, GPIO_OUT);
 
 
-    setupPwmCount(COUNT_PAD);
+    PulseCounter counter(COUNT_PAD);
+    if (!counter.start()){
+    	printf("ERROR - GPIO Must be PWM Channel B\n");
+    }
+
+    PIOCounter pioCounter;
+    int chanA = pioCounter.addChannel(PIO_PAD_A);
+    int chanB = pioCounter.addChannel(PIO_PAD_B, true);
+    pioCounter.setThreshold(chanA, PIO_THRESHOLD);
+    pioCounter.start();
 
     flash(10);
 
     //Drop into initial sleep for 1 minute
     DeepSleep* deepSleep = DeepSleep::singleton();
-    deepSleep->enablePWM();
 
     while (true) { // Loop forever
 
-        printf("SLEEP: Count at %d\n",  pwm_get_counter(slice_num));
+        printf("SLEEP: Count at %llu\n",  counter.getCount());
+        //No RTC in this example so time is taken as minutes slept
+        counter.mark(resurrect * 60);
         uart_default_tx_wait_blocking();
 
         deepSleep->sleepMin(1);
 
 		resurrect++;
-		printf("RESSURECT %u Count at %d\n",
+		printf("RESSURECT %u Count at %llu, %.2f Hz\n",
 				resurrect,
-				pwm_get_counter(slice_num)
+				counter.getCount(),
+				counter.getRate(resurrect * 60)
+				);
+
+		printf("PIO Counts %llu %llu%s\n",
+				pioCounter.getCount(chanA),
+				pioCounter.getCount(chanB),
+				pioCounter.takeThreshold(chanA) ? " threshold" : ""
 				);
 
 		flash(5);
@@ -0,0 +1,131 @@
+/**
+ * Scheduled jobs with Deep Sleep on a Raspberry PI Pico
+ *
+ * Samples every minute, reads a slow sensor every 7 minutes, uploads
+ * every 30 minutes and calibrates daily. The scheduler sleeps until the
+ * next job is due and runs all jobs due on the same wake together.
+ * The slow sensor and upload have slack so they join a nearby wake
+ * rather than cost one of their own.
+ * Each sample is a short burst of readings. A PowerManager picks the
+ * sleep mode between readings and for the scheduler's sleeps, from the
+ * measured cost of each mode.
+ * LED is flashed on GPIO 2 for each job run
+ *
+ * RTC DS3231 connected on I2C to GP12 & 13
+ * RTC SQW used for interupt to wake on GP10
+ */
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+#include "SleepScheduler.h"
+#include "PowerManager.h"
+#include "hardware/i2c.h"
+#include <cstdio>
+
+
+#define LED_PAD 2
+#define DELAY 200 // in microseconds
+#define SDA_PAD 12
+#define SCL_PAD 13
+
+#define WAKE_PAD 10
+
+#define SAMPLE_SEC 60
+#define SAMPLE_BURST 4
+#define SAMPLE_GAP_US 250000
+#define SLOW_SEC (7 * 60)
+#define SLOW_SLACK 90
+#define UPLOAD_SEC (30 * 60)
+#define UPLOAD_SLACK (5 * 60)
+#define CALIBRATE_SEC (24 * 60 * 60)
+
+PowerManager power;
+
+
+void flash(uint count=1){
+	const uint LED_PIN = LED_PAD;
+
+	for (uint i=0; i < count; i++){
+		gpio_put(LED_PIN, 1);
+		sleep_ms(DELAY);
+		gpio_put(LED_PIN, 0);
+		sleep_ms(DELAY);
+	}
+}
+
+void sample(void *arg){
+	DS3231 *rtc = (DS3231 *)arg;
+	float temp = 0.0;
+
+	for (uint i = 0; i < SAMPLE_BURST; i++){
+		if (i > 0){
+			power.sleepFor(SAMPLE_GAP_US);
+		}
+		temp += rtc->get_temp_f();
+	}
+	printf("SAMPLE %s temp %.2f\n", rtc->get_time_str(), temp / SAMPLE_BURST);
+	uart_default_tx_wait_blocking();
+	flash(1);
+}
+
+void slow(void *arg){
+	printf("SLOW\n");
+	uart_default_tx_wait_blocking();
+	flash(1);
+}
+
+void upload(void *arg){
+	printf("UPLOAD\n");
+	uart_default_tx_wait_blocking();
+	flash(2);
+}
+
+void calibrate(void *arg){
+	printf("CALIBRATE\n");
+	power.printCosts();
+	uart_default_tx_wait_blocking();
+	flash(3);
+}
+
+
+int main() {
+    stdio_init_all();
+    sleep_ms(2000);
+    printf("GO\n");
+
+    //Setup LED
+    const uint LED_PIN = LED_PAD;
+    gpio_init(LED_PIN);
+    gpio_set_dir(LED_PIN, GPIO_OUT);
+
+    //Set up RTC and get time
+    DS3231 rtc(i2c0,  SDA_PAD,  SCL_PAD);
+    printf("RTC: %s\n", rtc.get_time_str());
+
+    //DeepSleep or Dormant chosen for each sleep, both woken by the RTC
+    power.setRTC(&rtc, WAKE_PAD);
+    power.setWakeSources(POWER_WAKE_TIMER | POWER_WAKE_GPIO);
+
+    //Align jobs to the minute so each wake runs them on time
+    SleepScheduler scheduler(&power, WAKE_PAD);
+    uint32_t now = scheduler.getNow();
+    uint32_t minute = now - (now % 60);
+    scheduler.addPeriodic(SAMPLE_SEC, sample, &rtc, minute + SAMPLE_SEC);
+    scheduler.addPeriodic(SLOW_SEC, slow, NULL, minute + SLOW_SEC, SLOW_SLACK);
+    scheduler.addPeriodic(UPLOAD_SEC, upload, NULL, minute + UPLOAD_SEC,
+    		UPLOAD_SLACK);
+    scheduler.addPeriodic(CALIBRATE_SEC, calibrate, NULL,
+    		now - (now % CALIBRATE_SEC) + CALIBRATE_SEC);
+
+    while (true) { // Loop forever
+    	//Runs jobs due then sleeps until the next
+    	uint n = scheduler.step();
+    	printf("WAKE %lu, ran %u before sleep, %lu runs, %lu wakes saved\n",
+    			(unsigned long)scheduler.getWakes(),
+    			n,
+    			(unsigned long)scheduler.getRuns(),
+    			(unsigned long)scheduler.getWakesSaved());
+    	uart_default_tx_wait_blocking();
+    }
+
+}
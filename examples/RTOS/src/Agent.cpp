@@ -7,6 +7,7 @@
  */
 
 #include "Agent.h"
+#include "SleepCoordinator.h"
 #include <string.h>
 
 /***
@@ -63,7 +64,9 @@ TaskHandle_t Agent::getTask(){
  * @return
  */
 bool Agent::start(const char *name, UBaseType_t priority){
+#if configSUPPORT_DYNAMIC_ALLOCATION
 	BaseType_t res;
+#endif
 
 	if (strlen(name) >= MAX_NAME_LEN){
 		memcpy(pName, name, MAX_NAME_LEN);
@@ -71,6 +74,22 @@ bool Agent::start(const char *name, UBaseType_t priority){
 	} else {
 		strcpy(pName, name);
 	}
+#if configSUPPORT_STATIC_ALLOCATION
+	if ((getStaticStack() != NULL) && (getStaticTCB() != NULL)){
+		xHandle = xTaskCreateStatic(
+			Agent::vTask,
+			pName,
+			getMaxStackSize(),
+			( void * ) this,
+			priority,
+			getStaticStack(),
+			getStaticTCB()
+		);
+		return (xHandle != NULL);
+	}
+#endif
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
 	res = xTaskCreate(
 			Agent::vTask,       /* Function that implements the task. */
 		pName,   /* Text name for the task. */
@@ -80,8 +99,21 @@ bool Agent::start(const char *name, UBaseType_t priority){
 		&xHandle
 	);
 	return (res == pdPASS);
+#else
+	return false;
+#endif
 }
 
+#if configSUPPORT_STATIC_ALLOCATION
+StackType_t * Agent::getStaticStack(){
+	return NULL;
+}
+
+StaticTask_t * Agent::getStaticTCB(){
+	return NULL;
+}
+#endif
+
 
 
 /***
@@ -94,3 +126,79 @@ bool Agent::start(const char *name, UBaseType_t priority){
 		 task->run();
 	 }
  }
+
+void Agent::setCoordinator(SleepCoordinator *coordinator, uint index){
+	pCoordinator = coordinator;
+	xSleepIndex = index;
+}
+
+bool Agent::isQuiescent(){
+	return xQuiescent && !xReleased;
+}
+
+void Agent::released(){
+	xReleased = true;
+}
+
+uint32_t Agent::getDeadlineMs(){
+	if (xDeadlineMs == AGENT_NO_DEADLINE){
+		return AGENT_NO_DEADLINE;
+	}
+	uint32_t elapsed = (xTaskGetTickCount() - xDeadlineSet) * portTICK_PERIOD_MS;
+	if (elapsed >= xDeadlineMs){
+		return 0;
+	}
+	return xDeadlineMs - elapsed;
+}
+
+void Agent::sleptFor(uint32_t ms){
+	if (xDeadlineMs == AGENT_NO_DEADLINE){
+		return;
+	}
+	if (ms >= xDeadlineMs){
+		xDeadlineMs = 0;
+	} else {
+		xDeadlineMs -= ms;
+	}
+}
+
+void Agent::setQuiescent(bool quiescent){
+	xQuiescent = quiescent;
+	if (quiescent && (pCoordinator != NULL)){
+		pCoordinator->agentIdle();
+	}
+}
+
+void Agent::setDeadline(uint32_t ms){
+	xDeadlineSet = xTaskGetTickCount();
+	xDeadlineMs = ms;
+}
+
+bool Agent::sleepPoint(TickType_t ticks){
+	uint32_t bits = 0;
+
+	if (xReleased){
+		//Has run since the last wake, so idle again if it says so
+		xReleased = false;
+		if (xQuiescent && (pCoordinator != NULL)){
+			pCoordinator->agentIdle();
+		}
+	}
+
+	xTaskNotifyWait(0, AGENT_NOTIFY_SLEEP_BITS, &bits, ticks);
+	//Wake with the request means the sleep was abandoned
+	if ((bits & AGENT_NOTIFY_SLEEP) == 0 || (bits & AGENT_NOTIFY_WAKE) != 0){
+		return false;
+	}
+
+	//Parked at a safe point, wait for the system to wake
+	if (pCoordinator != NULL){
+		pCoordinator->agentParked(xSleepIndex);
+	}
+	bits = 0;
+	while ((bits & AGENT_NOTIFY_WAKE) == 0){
+		//Leave any new sleep request for the next sleep point
+		xTaskNotifyWait(0, AGENT_NOTIFY_WAKE, &bits, portMAX_DELAY);
+	}
+	return true;
+}
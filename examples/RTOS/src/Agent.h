@@ -13,9 +13,19 @@
 
 #define MAX_NAME_LEN 20
 
+//Notification bits reserved for the sleep protocol
+#define AGENT_NOTIFY_SLEEP	(1UL << 30)
+#define AGENT_NOTIFY_WAKE	(1UL << 31)
+#define AGENT_NOTIFY_SLEEP_BITS (AGENT_NOTIFY_SLEEP | AGENT_NOTIFY_WAKE)
+
+//No deadline declared, agent can sleep indefinitely
+#define AGENT_NO_DEADLINE	0xFFFFFFFF
+
 #include "FreeRTOS.h"
 #include "task.h"
 
+class SleepCoordinator;
+
 
 class Agent {
 public:
@@ -56,7 +66,61 @@ public:
 	 */
 	virtual TaskHandle_t getTask();
 
+	/***
+	 * Join a sleep coordinator, called by SleepCoordinator::add
+	 * @param coordinator
+	 * @param index - slot in the coordinator
+	 */
+	void setCoordinator(SleepCoordinator *coordinator, uint index);
+
+	/***
+	 * Is the agent idle and happy for the system to sleep
+	 * @return
+	 */
+	bool isQuiescent();
+
+	/***
+	 * Time until the agent next needs to run
+	 * @return ms, AGENT_NO_DEADLINE if none
+	 */
+	uint32_t getDeadlineMs();
+
+	/***
+	 * The system slept, move the deadline on as the tick count does
+	 * not advance while dormant
+	 * @param ms - time slept
+	 */
+	void sleptFor(uint32_t ms);
+
+	/***
+	 * The system woke or the sleep was abandoned. The agent does not
+	 * count as quiescent again until it next reaches a sleep point
+	 */
+	void released();
+
 protected:
+	/***
+	 * Declare idle or busy. Becoming idle tells the coordinator.
+	 * @param quiescent
+	 */
+	void setQuiescent(bool quiescent);
+
+	/***
+	 * Declare when the agent next needs to run
+	 * @param ms - from now, AGENT_NO_DEADLINE if none
+	 */
+	void setDeadline(uint32_t ms);
+
+	/***
+	 * Safe point for the system to sleep. Call from the run loop with no
+	 * resources held in place of vTaskDelay. If a sleep is requested the
+	 * agent parks until the system wakes.
+	 * Task notification bits AGENT_NOTIFY_SLEEP_BITS are reserved.
+	 * @param ticks - time to wait if no sleep is requested
+	 * @return true if the system slept
+	 */
+	bool sleepPoint(TickType_t ticks);
+
 	/***
 	 * Start the task via static function
 	 * @param pvParameters - will be the Agent object
@@ -74,11 +138,32 @@ protected:
 	 */
 	virtual configSTACK_DEPTH_TYPE getMaxStackSize()=0;
 
+#if configSUPPORT_STATIC_ALLOCATION
+	/***
+	 * Storage for xTaskCreateStatic, see StaticAgent
+	 * @return stack of getMaxStackSize words, NULL to use the heap
+	 */
+	virtual StackType_t * getStaticStack();
+
+	/***
+	 * Storage for xTaskCreateStatic, see StaticAgent
+	 * @return TCB, NULL to use the heap
+	 */
+	virtual StaticTask_t * getStaticTCB();
+#endif
+
 	//The task
 	TaskHandle_t xHandle = NULL;
 
 	char pName[MAX_NAME_LEN];
 
+	SleepCoordinator *pCoordinator = NULL;
+	uint xSleepIndex = 0;
+	volatile bool xQuiescent = false;
+	volatile bool xReleased = false;
+	TickType_t xDeadlineSet = 0;
+	uint32_t xDeadlineMs = AGENT_NO_DEADLINE;
+
 
 };
 
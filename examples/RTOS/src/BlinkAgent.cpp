@@ -13,6 +13,9 @@
 //Blink Delay
 #define DELAY			500
 
+//Blinks after each wake before going quiescent
+#define BLINKS			10
+
 /***
  * Constructor
  * @param gp - GPIO Pad number for LED
@@ -42,33 +45,20 @@ BlinkAgent::~BlinkAgent() {
 	gpio_set_dir(xLedPad, GPIO_OUT);
 
 	while (true) { // Loop forever
-		gpio_put(xLedPad, 1);
-		vTaskDelay(DELAY);
-		gpio_put(xLedPad, 0);
-		vTaskDelay(DELAY);
+		setQuiescent(false);
+		for (int i = 0; i < BLINKS; i++){
+			gpio_put(xLedPad, 1);
+			vTaskDelay(DELAY);
+			gpio_put(xLedPad, 0);
+			vTaskDelay(DELAY);
+		}
+
+		//LED is off, nothing held, happy to sleep until woken
+		setDeadline(AGENT_NO_DEADLINE);
+		setQuiescent(true);
+		sleepPoint(portMAX_DELAY);
 	}
 
  }
 
-/***
- * Get the static depth required in words
- * @return - words
- */
-configSTACK_DEPTH_TYPE BlinkAgent::getMaxStackSize(){
-	return 150;
-}
-
-
-void BlinkAgent::notifyDormant(uint minutes){
-	printf("Notify Dormant\n");
-	uart_default_tx_wait_blocking();
-	vTaskSuspend(  getTask() );
-	gpio_put(xLedPad, 0);
-}
-
-void BlinkAgent::notifyWake(uint minutes){
-	printf("Notify Wake\n");
-	uart_default_tx_wait_blocking();
-	vTaskResume(getTask());
-}
 
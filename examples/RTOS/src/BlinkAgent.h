@@ -2,6 +2,8 @@
  * BlinkAgent.h
  *
  * Active agent to run as task and blink and LED on the given GPIO pad
+ * Blinks for a while after each wake then goes quiescent so the
+ * SleepCoordinator can sleep the system
  *
  *  Created on: 15 Aug 2022
  *      Author: jondurrant
@@ -14,11 +16,10 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
-#include "Agent.h"
-#include "DormantNotification.h"
+#include "StaticAgent.h"
 
 
-class BlinkAgent: public Agent, public DormantNotification {
+class BlinkAgent: public StaticAgent<150> {
 public:
 	/***
 	 * Constructor
@@ -32,11 +33,6 @@ public:
 	virtual ~BlinkAgent();
 
 
-	virtual void notifyDormant(uint minutes);
-
-	virtual void notifyWake(uint minutes);
-
-
 protected:
 
 	/***
@@ -45,11 +41,6 @@ protected:
 	virtual void run();
 
 
-	/***
-	 * Get the static depth required in words
-	 * @return - words
-	 */
-	virtual configSTACK_DEPTH_TYPE getMaxStackSize();
 
 	//GPIO PAD for LED
 	uint8_t xLedPad = 0;
@@ -0,0 +1,172 @@
+/*
+ * RunTimeStats.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "RunTimeStats.h"
+#include <stdio.h>
+#include <string.h>
+
+RunTimeStats::RunTimeStats(uint32_t periodMs, bool print) {
+	xPeriodMs = periodMs;
+	xPrint = print;
+}
+
+RunTimeStats::~RunTimeStats() {
+	stop();
+}
+
+void RunTimeStats::setSleepSource(SleepCoordinator *coordinator){
+	pSleepSource = coordinator;
+	if (pSleepSource != NULL){
+		xLastSlept = pSleepSource->getSleptMs();
+	}
+}
+
+bool RunTimeStats::sample(){
+	unsigned long total = 0;
+	UBaseType_t n;
+	uint32_t idle = 0;
+
+	n = uxTaskGetSystemState(xStatus, RUN_TIME_STATS_MAX_TASKS, &total);
+	if (n == 0){
+		return false;
+	}
+
+	//Keep last counters to work out the interval
+	memcpy(xPrev, xTasks, sizeof(RunTimeTask) * xNumTasks);
+	xNumPrev = xNumTasks;
+
+	xIntervalUs = (uint32_t)total - xLastTotal;
+	xLastTotal = (uint32_t)total;
+	xNumTasks = n;
+
+	for (UBaseType_t i = 0; i < n; i++){
+		TaskStatus_t *s = &xStatus[i];
+		RunTimeTask *t = &xTasks[i];
+		uint32_t delta = (uint32_t)s->ulRunTimeCounter - prevRunTime(s->xHandle);
+
+		t->handle = s->xHandle;
+		t->name = s->pcTaskName;
+		t->runTime = (uint32_t)s->ulRunTimeCounter;
+		t->stackHW = s->usStackHighWaterMark;
+		t->number = s->xTaskNumber;
+		t->priority = s->uxCurrentPriority;
+		t->share = 0;
+		if (xIntervalUs > 0){
+			t->share = (uint16_t)(((uint64_t)delta * 1000) / xIntervalUs);
+		}
+		if (s->uxCurrentPriority == tskIDLE_PRIORITY &&
+				strncmp(s->pcTaskName, "IDLE", 4) == 0){
+			idle += t->share;
+		}
+	}
+	xIdleShare = idle;
+
+	xHeapFree = xPortGetFreeHeapSize();
+	xHeapMin = xPortGetMinimumEverFreeHeapSize();
+
+	xSleptMs = 0;
+	if (pSleepSource != NULL){
+		uint32_t slept = pSleepSource->getSleptMs();
+		xSleptMs = slept - xLastSlept;
+		xLastSlept = slept;
+	}
+	return true;
+}
+
+uint32_t RunTimeStats::prevRunTime(TaskHandle_t handle){
+	for (uint i = 0; i < xNumPrev; i++){
+		if (xPrev[i].handle == handle){
+			return xPrev[i].runTime;
+		}
+	}
+	return 0;
+}
+
+void RunTimeStats::printSummary(){
+	printf("RTS %lums idle %u.%u%% sleep %u.%u%% heap %u/%u",
+			(unsigned long)(xIntervalUs / 1000),
+			xIdleShare / 10, xIdleShare % 10,
+			getSleepShare() / 10, getSleepShare() % 10,
+			(unsigned int)xHeapFree, (unsigned int)xHeapMin);
+	for (uint i = 0; i < xNumTasks; i++){
+		printf(" %s:%u.%u/%u",
+				xTasks[i].name,
+				xTasks[i].share / 10, xTasks[i].share % 10,
+				xTasks[i].stackHW);
+	}
+	printf("\n");
+}
+
+size_t RunTimeStats::pack(uint8_t *buf, size_t len){
+	size_t need = RUN_TIME_STATS_HEADER_LEN + xNumTasks * RUN_TIME_STATS_TASK_LEN;
+	uint32_t ms = xIntervalUs / 1000;
+	uint32_t heapFree = xHeapFree;
+	uint32_t heapMin = xHeapMin;
+	uint8_t *p = buf;
+
+	if (len < need){
+		return 0;
+	}
+	*p++ = RUN_TIME_STATS_VERSION;
+	*p++ = xNumTasks;
+	memcpy(p, &ms, 4);
+	p += 4;
+	memcpy(p, &xSleptMs, 4);
+	p += 4;
+	memcpy(p, &heapFree, 4);
+	p += 4;
+	memcpy(p, &heapMin, 4);
+	p += 4;
+	memcpy(p, &xIdleShare, 2);
+	p += 2;
+	for (uint i = 0; i < xNumTasks; i++){
+		*p++ = xTasks[i].number;
+		memcpy(p, &xTasks[i].share, 2);
+		p += 2;
+		memcpy(p, &xTasks[i].stackHW, 2);
+		p += 2;
+	}
+	return need;
+}
+
+uint RunTimeStats::getNumTasks(){
+	return xNumTasks;
+}
+
+const RunTimeTask * RunTimeStats::getTaskStats(uint i){
+	if (i >= xNumTasks){
+		return NULL;
+	}
+	return &xTasks[i];
+}
+
+uint16_t RunTimeStats::getIdleShare(){
+	return xIdleShare;
+}
+
+uint16_t RunTimeStats::getSleepShare(){
+	uint64_t wall = (uint64_t)xIntervalUs / 1000 + xSleptMs;
+	if (wall == 0){
+		return 0;
+	}
+	return (uint16_t)(((uint64_t)xSleptMs * 1000) / wall);
+}
+
+void RunTimeStats::run(){
+	//Always happy for the system to sleep between samples
+	setDeadline(AGENT_NO_DEADLINE);
+	setQuiescent(true);
+
+	sample();
+	for (;;){
+		sleepPoint(pdMS_TO_TICKS(xPeriodMs));
+		if (sample() && xPrint){
+			printSummary();
+		}
+	}
+}
+
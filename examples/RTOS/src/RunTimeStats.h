@@ -0,0 +1,141 @@
+/*
+ * RunTimeStats.h
+ *
+ * Agent that samples task run time, stack high water, heap and sleep
+ * residency into fixed buffers, so sampling does not touch the heap.
+ * Each sample gives the CPU share of every task over the interval, and
+ * can be reported as one line or packed as a compact binary record.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_RUNTIMESTATS_H_
+#define SRC_RUNTIMESTATS_H_
+
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "StaticAgent.h"
+#include "SleepCoordinator.h"
+
+#ifndef RUN_TIME_STATS_MAX_TASKS
+#define RUN_TIME_STATS_MAX_TASKS 16
+#endif
+
+#define RUN_TIME_STATS_VERSION 1
+#define RUN_TIME_STATS_HEADER_LEN 20
+#define RUN_TIME_STATS_TASK_LEN 5
+
+/***
+ * Stats for one task over the last interval
+ */
+struct RunTimeTask {
+	TaskHandle_t	handle;
+	const char *	name;
+	uint32_t		runTime;	// Counter at last sample
+	uint16_t		share;		// Per mille of interval
+	uint16_t		stackHW;	// Words free at high water
+	uint8_t			number;		// FreeRTOS task number
+	uint8_t			priority;
+};
+
+class RunTimeStats : public StaticAgent<300> {
+public:
+	/***
+	 * Constructor
+	 * @param periodMs - time between samples
+	 * @param print - print a summary line on each sample
+	 */
+	RunTimeStats(uint32_t periodMs = 10000, bool print = true);
+	virtual ~RunTimeStats();
+
+	/***
+	 * Count sleep residency from the coordinator
+	 * @param coordinator
+	 */
+	void setSleepSource(SleepCoordinator *coordinator);
+
+	/***
+	 * Take a sample now
+	 * @return false if there were more tasks than RUN_TIME_STATS_MAX_TASKS
+	 */
+	bool sample();
+
+	/***
+	 * Print last sample on one line
+	 */
+	void printSummary();
+
+	/***
+	 * Pack last sample as binary, little endian
+	 * Header: version, tasks, interval ms, slept ms, heap free,
+	 * heap minimum ever free, idle share per mille
+	 * Per task: number, share per mille, stack high water
+	 * @param buf
+	 * @param len - length of buf
+	 * @return bytes used, 0 if buf too small
+	 */
+	size_t pack(uint8_t *buf, size_t len);
+
+	/***
+	 * Number of tasks in last sample
+	 * @return
+	 */
+	uint getNumTasks();
+
+	/***
+	 * Stats for a task in last sample
+	 * @param i
+	 * @return NULL if out of range
+	 */
+	const RunTimeTask * getTaskStats(uint i);
+
+	/***
+	 * Share of the last interval spent in the idle tasks
+	 * @return per mille
+	 */
+	uint16_t getIdleShare();
+
+	/***
+	 * Share of wall time asleep over last interval
+	 * @return per mille
+	 */
+	uint16_t getSleepShare();
+
+protected:
+	/***
+	 * Run loop for the agent.
+	 */
+	virtual void run();
+
+
+private:
+	/***
+	 * Find previous run time counter for a task
+	 * @param handle
+	 * @return counter, 0 if new task
+	 */
+	uint32_t prevRunTime(TaskHandle_t handle);
+
+	uint32_t xPeriodMs;
+	bool xPrint;
+	SleepCoordinator *pSleepSource = NULL;
+
+	TaskStatus_t xStatus[RUN_TIME_STATS_MAX_TASKS];
+	RunTimeTask xTasks[RUN_TIME_STATS_MAX_TASKS];
+	RunTimeTask xPrev[RUN_TIME_STATS_MAX_TASKS];
+	uint xNumTasks = 0;
+	uint xNumPrev = 0;
+
+	uint32_t xLastTotal = 0;
+	uint32_t xLastSlept = 0;
+	uint32_t xIntervalUs = 0;
+	uint32_t xSleptMs = 0;
+	uint16_t xIdleShare = 0;
+	size_t xHeapFree = 0;
+	size_t xHeapMin = 0;
+};
+
+#endif /* SRC_RUNTIMESTATS_H_ */
@@ -0,0 +1,171 @@
+/*
+ * SleepCoordinator.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SleepCoordinator.h"
+#include <stdio.h>
+
+SleepCoordinator::SleepCoordinator() {
+	// NOP
+}
+
+SleepCoordinator::~SleepCoordinator() {
+	stop();
+}
+
+bool SleepCoordinator::add(Agent *agent){
+	if (xNumAgents >= SLEEP_COORDINATOR_MAX_AGENTS){
+		return false;
+	}
+	agent->setCoordinator(this, xNumAgents);
+	pAgents[xNumAgents++] = agent;
+	return true;
+}
+
+void SleepCoordinator::setDormant(Dormant *dormant){
+	pDormant = dormant;
+}
+
+void SleepCoordinator::setDeepSleep(DeepSleep *deepSleep){
+	pDeepSleep = deepSleep;
+}
+
+void SleepCoordinator::setWakePad(uint8_t wakePad){
+	xWakePad = wakePad;
+}
+
+void SleepCoordinator::setMaxSleep(uint minutes){
+	xMaxSleep = minutes;
+}
+
+uint32_t SleepCoordinator::getSleeps(){
+	return xSleeps;
+}
+
+uint32_t SleepCoordinator::getSleptMs(){
+	return xSleptMs;
+}
+
+uint32_t SleepCoordinator::getAborts(){
+	return xAborts;
+}
+
+void SleepCoordinator::agentIdle(){
+	if (xHandle != NULL){
+		xTaskNotify(xHandle, SLEEP_COORDINATOR_IDLE, eSetBits);
+	}
+}
+
+void SleepCoordinator::agentParked(uint index){
+	if (xHandle != NULL){
+		xTaskNotify(xHandle, 1UL << index, eSetBits);
+	}
+}
+
+void SleepCoordinator::run(){
+	uint32_t bits;
+
+	for (;;){
+		//Wait for an agent to become idle, or the next deadline to pass
+		uint32_t ms = minDeadline();
+		if (!allQuiescent()){
+			xTaskNotifyWait(0, SLEEP_COORDINATOR_IDLE, &bits, portMAX_DELAY);
+			continue;
+		}
+
+		//Dormant and DeepSleep count in whole minutes
+		uint minutes = xMaxSleep;
+		if (ms != AGENT_NO_DEADLINE){
+			minutes = ms / 60000;
+			if (minutes > xMaxSleep){
+				minutes = xMaxSleep;
+			}
+		}
+		if (minutes == 0){
+			//Deadline too close to sleep, wait for it to change
+			xTaskNotifyWait(0, SLEEP_COORDINATOR_IDLE, &bits, pdMS_TO_TICKS(ms) + 1);
+			continue;
+		}
+
+		if (!park()){
+			xAborts++;
+			release();
+			continue;
+		}
+
+		printf("SLEEP %u\n", minutes);
+		uart_default_tx_wait_blocking();
+		if (pDeepSleep != NULL){
+			pDeepSleep->sleep(minutes, xWakePad);
+		} else if (pDormant != NULL){
+			pDormant->sleep(minutes, xWakePad);
+		}
+		xSleeps++;
+		xSleptMs += minutes * 60000;
+
+		for (uint i = 0; i < xNumAgents; i++){
+			pAgents[i]->sleptFor(minutes * 60000);
+		}
+		release();
+	}
+}
+
+bool SleepCoordinator::allQuiescent(){
+	for (uint i = 0; i < xNumAgents; i++){
+		if (!pAgents[i]->isQuiescent()){
+			return false;
+		}
+	}
+	return true;
+}
+
+uint32_t SleepCoordinator::minDeadline(){
+	uint32_t ms = AGENT_NO_DEADLINE;
+
+	for (uint i = 0; i < xNumAgents; i++){
+		uint32_t d = pAgents[i]->getDeadlineMs();
+		if (d < ms){
+			ms = d;
+		}
+	}
+	return ms;
+}
+
+bool SleepCoordinator::park(){
+	uint32_t all = (xNumAgents >= 32) ? 0xFFFFFFFF : ((1UL << xNumAgents) - 1);
+	uint32_t parked = 0;
+	uint32_t bits;
+	TickType_t start = xTaskGetTickCount();
+	TickType_t timeout = pdMS_TO_TICKS(SLEEP_COORDINATOR_PARK_TIMEOUT);
+
+	//Clear stale parked bits then ask everyone
+	xTaskNotifyWait(0, all, &bits, 0);
+	for (uint i = 0; i < xNumAgents; i++){
+		xTaskNotify(pAgents[i]->getTask(), AGENT_NOTIFY_SLEEP, eSetBits);
+	}
+
+	while (parked != all){
+		TickType_t elapsed = xTaskGetTickCount() - start;
+		if (elapsed >= timeout){
+			return false;
+		}
+		bits = 0;
+		xTaskNotifyWait(0, all, &bits, timeout - elapsed);
+		parked |= bits & all;
+	}
+
+	//An agent may have become busy before it parked
+	return allQuiescent();
+}
+
+void SleepCoordinator::release(){
+	for (uint i = 0; i < xNumAgents; i++){
+		//Not parked again until the agent has run and is idle once more
+		pAgents[i]->released();
+		xTaskNotify(pAgents[i]->getTask(), AGENT_NOTIFY_WAKE, eSetBits);
+	}
+}
+
@@ -0,0 +1,145 @@
+/*
+ * SleepCoordinator.h
+ *
+ * Puts the system to sleep once every agent is idle. Agents declare
+ * quiescence and their next deadline. When all are idle the coordinator
+ * asks each to park at a safe point, waits for every agent to confirm
+ * by task notification, then sleeps for the shortest deadline using
+ * Dormant or DeepSleep and releases the agents on wake.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SLEEPCOORDINATOR_H_
+#define SRC_SLEEPCOORDINATOR_H_
+
+#include "pico/stdlib.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "StaticAgent.h"
+#include "Dormant.h"
+#include "DeepSleep.h"
+
+#ifndef SLEEP_COORDINATOR_MAX_AGENTS
+#define SLEEP_COORDINATOR_MAX_AGENTS 8
+#endif
+
+//Time allowed for all agents to park
+#ifndef SLEEP_COORDINATOR_PARK_TIMEOUT
+#define SLEEP_COORDINATOR_PARK_TIMEOUT 1000
+#endif
+
+//Notification bit, an agent became idle
+#define SLEEP_COORDINATOR_IDLE (1UL << 31)
+
+class SleepCoordinator : public StaticAgent<300> {
+public:
+	SleepCoordinator();
+	virtual ~SleepCoordinator();
+
+	/***
+	 * Add an agent to the protocol
+	 * @param agent
+	 * @return false if full
+	 */
+	bool add(Agent *agent);
+
+	/***
+	 * Sleep using Dormant
+	 * @param dormant
+	 */
+	void setDormant(Dormant *dormant);
+
+	/***
+	 * Sleep using DeepSleep
+	 * @param deepSleep
+	 */
+	void setDeepSleep(DeepSleep *deepSleep);
+
+	/***
+	 * Set the GPIO that can also wake the system
+	 * @param wakePad - >28 for none
+	 */
+	void setWakePad(uint8_t wakePad);
+
+	/***
+	 * Set the longest sleep, used when no agent has a deadline
+	 * @param minutes
+	 */
+	void setMaxSleep(uint minutes);
+
+	/***
+	 * Number of times the system slept
+	 * @return
+	 */
+	uint32_t getSleeps();
+
+	/***
+	 * Total time asleep. The system timer stops while dormant so this
+	 * is counted from the requested sleeps.
+	 * @return ms
+	 */
+	uint32_t getSleptMs();
+
+	/***
+	 * Number of sleeps abandoned because an agent did not park
+	 * @return
+	 */
+	uint32_t getAborts();
+
+	/***
+	 * Called by an agent when it becomes idle
+	 */
+	void agentIdle();
+
+	/***
+	 * Called by an agent once parked at a safe point
+	 * @param index
+	 */
+	void agentParked(uint index);
+
+protected:
+	/***
+	 * Run loop for the agent.
+	 */
+	virtual void run();
+
+
+private:
+	/***
+	 * Are all agents idle
+	 * @return
+	 */
+	bool allQuiescent();
+
+	/***
+	 * Shortest deadline of all agents
+	 * @return ms
+	 */
+	uint32_t minDeadline();
+
+	/***
+	 * Ask all agents to park
+	 * @return true if all parked in time
+	 */
+	bool park();
+
+	/***
+	 * Release parked agents
+	 */
+	void release();
+
+	Agent *pAgents[SLEEP_COORDINATOR_MAX_AGENTS];
+	uint xNumAgents = 0;
+	Dormant *pDormant = NULL;
+	DeepSleep *pDeepSleep = NULL;
+	uint8_t xWakePad = 0xFF;
+	uint xMaxSleep = 1;
+	uint32_t xSleeps = 0;
+	uint32_t xSleptMs = 0;
+	uint32_t xAborts = 0;
+};
+
+#endif /* SRC_SLEEPCOORDINATOR_H_ */
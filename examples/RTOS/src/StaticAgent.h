@@ -0,0 +1,44 @@
+/*
+ * StaticAgent.h
+ *
+ * Agent holding its own stack and TCB so the task is created with
+ * xTaskCreateStatic and nothing is taken from the FreeRTOS heap.
+ * Declare the agent static or global so the storage is not on
+ * another task's stack.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_STATICAGENT_H_
+#define SRC_STATICAGENT_H_
+
+#include "Agent.h"
+
+template <configSTACK_DEPTH_TYPE Depth>
+class StaticAgent : public Agent {
+protected:
+	/***
+	 * Get the static depth required in words
+	 * @return - words
+	 */
+	virtual configSTACK_DEPTH_TYPE getMaxStackSize(){
+		return Depth;
+	}
+
+#if configSUPPORT_STATIC_ALLOCATION
+	virtual StackType_t * getStaticStack(){
+		return xStack;
+	}
+
+	virtual StaticTask_t * getStaticTCB(){
+		return &xTCB;
+	}
+
+private:
+	StackType_t xStack[Depth];
+	StaticTask_t xTCB;
+#endif
+};
+
+#endif /* SRC_STATICAGENT_H_ */
@@ -1,7 +1,8 @@
 /***
  * Demo program to flash an LED attached to GPIO PAD 2.
  * Uses FreeRTOS Task
- * Then go into a dormant wait for 1 minute controlled by an RTC
+ * Then go into a dormant wait for 1 minute controlled by an RTC once
+ * the SleepCoordinator sees all agents are idle
  * Jon Durrant
  * 15-Aug-2022
  */
@@ -14,13 +15,17 @@
 #include <stdio.h>
 
 #include "BlinkAgent.h"
+#include "SleepCoordinator.h"
+#include "RunTimeStats.h"
 
+#include "I2CBus.h"
 #include "DS3231.hpp"
 #include "Dormant.h"
 
 
 //Standard Task priority
 #define TASK_PRIORITY		( tskIDLE_PRIORITY + 1UL )
+#define MAIN_TASK_STACK		500
 
 //LED PAD to use
 #define LED_PAD				2
@@ -29,91 +34,46 @@
 #define WAKE_PAD 10
 
 
-void runTimeStats(   ){
-	TaskStatus_t *pxTaskStatusArray;
-	volatile UBaseType_t uxArraySize, x;
-	unsigned long ulTotalRunTime;
-
-
-   // Get number of takss
-   uxArraySize = uxTaskGetNumberOfTasks();
-   printf("Number of tasks %d\n", uxArraySize);
-
-   //Allocate a TaskStatus_t structure for each task.
-   pxTaskStatusArray = (TaskStatus_t *)pvPortMalloc( uxArraySize * sizeof( TaskStatus_t ) );
-
-   if( pxTaskStatusArray != NULL ){
-      // Generate raw status information about each task.
-      uxArraySize = uxTaskGetSystemState( pxTaskStatusArray,
-                                 uxArraySize,
-                                 &ulTotalRunTime );
-
-	 // Print stats
-	 for( x = 0; x < uxArraySize; x++ )
-	 {
-		 printf("Task: %d \t cPri:%d \t bPri:%d \t hw:%d \t%s\n",
-				pxTaskStatusArray[ x ].xTaskNumber ,
-				pxTaskStatusArray[ x ].uxCurrentPriority ,
-				pxTaskStatusArray[ x ].uxBasePriority ,
-				pxTaskStatusArray[ x ].usStackHighWaterMark ,
-				pxTaskStatusArray[ x ].pcTaskName
-				);
-	 }
-
-
-      // Free array
-      vPortFree( pxTaskStatusArray );
-   } else {
-	   printf("Failed to allocate space for stats\n");
-   }
-
-   //Get heap allocation information
-   HeapStats_t heapStats;
-   vPortGetHeapStats(&heapStats);
-   printf("HEAP avl: %d, blocks %d, alloc: %d, free: %d\n",
-		   heapStats.xAvailableHeapSpaceInBytes,
-		   heapStats.xNumberOfFreeBlocks,
-		   heapStats.xNumberOfSuccessfulAllocations,
-		   heapStats.xNumberOfSuccessfulFrees
-		   );
-}
-
-
 /***
  * Main task to blink external LED
  * @param params - unused
  */
 void mainTask(void *params){
-	BlinkAgent blink(LED_PAD);
+	//Static as the agents hold their own task stacks
+	static BlinkAgent blink(LED_PAD);
+	static SleepCoordinator coordinator;
+	static RunTimeStats stats(10000);
 
 
 	printf("Main task started\n");
 
 	blink.start("Blink", TASK_PRIORITY);
 
-    //Set up RTC and get time
-    DS3231 rtc(i2c0,  SDA_PAD,  SCL_PAD);
+    //Set up RTC on a bus other sensor tasks can share, and get time
+    I2CBus bus(i2c0, SDA_PAD, SCL_PAD);
+    DS3231 rtc(&bus);
     printf("RTC: %s\n", rtc.get_time_str());
 
-    uint resurrect = 0;
+    uint32_t sleeps = 0;
     Dormant *dormant = Dormant::singleton();
     dormant->setRTC(&rtc);
-    dormant->addObserver(&blink);
-    vTaskDelay(10000);
-
-	while (true) { // Loop forever
-
-		 //Drop into initial sleep for 1 minute
 
-		printf("SLEEP\n");
-		uart_default_tx_wait_blocking();
-		dormant->sleep(1, WAKE_PAD);
+    //Sleep for a minute each time all agents are idle
+    coordinator.setDormant(dormant);
+    coordinator.setWakePad(WAKE_PAD);
+    coordinator.setMaxSleep(1);
+    coordinator.add(&blink);
+    coordinator.add(&stats);
+    stats.setSleepSource(&coordinator);
+    stats.start("Stats", TASK_PRIORITY);
+    coordinator.start("Sleep", TASK_PRIORITY);
 
-		resurrect++;
-		printf("RESSURECT %u\n", resurrect);
-
-		runTimeStats();
+	while (true) { // Loop forever
 		vTaskDelay(10000);
+		if (coordinator.getSleeps() != sleeps){
+			sleeps = coordinator.getSleeps();
+			printf("RESSURECT %u\n", sleeps);
+		}
 	}
 }
 
@@ -125,9 +85,11 @@ void mainTask(void *params){
  */
 void vLaunch( void) {
 
-	//Start blink task
-    TaskHandle_t task;
-    xTaskCreate(mainTask, "MainThread", 500, NULL, TASK_PRIORITY, &task);
+	//Start main task from static storage, nothing is taken from the heap
+    static StackType_t xMainStack[MAIN_TASK_STACK];
+    static StaticTask_t xMainTCB;
+    xTaskCreateStatic(mainTask, "MainThread", MAIN_TASK_STACK, NULL,
+    		TASK_PRIORITY, xMainStack, &xMainTCB);
 
     /* Start the tasks and timer running. */
     vTaskStartScheduler();
@@ -0,0 +1,317 @@
+/*
+ * SNTPClient.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SNTPClient.h"
+#include <cstdio>
+#include <cstring>
+#include "pico/cyw43_arch.h"
+#include "hardware/rtc.h"
+#include "pico/util/datetime.h"
+#include "lwip/dns.h"
+#include "WifiHelper.h"
+
+#define SNTP_MSG_LEN 48
+#define SNTP_UNIX_OFFSET 2208988800UL
+#define SNTP_MAGIC 0x534E5450
+
+//Start the DS3231 write this far ahead of the second for I2C latency
+#ifndef SNTP_WRITE_LEAD_US
+#define SNTP_WRITE_LEAD_US 250
+#endif
+
+struct SNTPRetained {
+	uint32_t magic;
+	uint32_t lastSync;
+};
+
+static SNTPRetained __uninitialized_ram(xRetained);
+
+static uint32_t rd32(const uint8_t *b){
+	return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+			((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+static void wr32(uint8_t *b, uint32_t v){
+	b[0] = v >> 24;
+	b[1] = v >> 16;
+	b[2] = v >> 8;
+	b[3] = v;
+}
+
+/***
+ * NTP timestamp to Unix micro seconds
+ */
+static uint64_t ntpToUs(const uint8_t *b){
+	uint64_t sec = rd32(b) - SNTP_UNIX_OFFSET;
+	uint64_t frac = rd32(&b[4]);
+	return sec * 1000000ULL + ((frac * 1000000ULL) >> 32);
+}
+
+SNTPClient::SNTPClient(const char *server, uint32_t minInterval) {
+	pServer = server;
+	xMinInterval = minInterval;
+	if (xRetained.magic != SNTP_MAGIC){
+		xRetained.magic = SNTP_MAGIC;
+		xRetained.lastSync = 0;
+	}
+}
+
+SNTPClient::~SNTPClient() {
+	// NOP
+}
+
+void SNTPClient::setRTC(DS3231 *rtc){
+	pRTC = rtc;
+}
+
+void SNTPClient::setServer(const char *server){
+	pServer = server;
+}
+
+void SNTPClient::setMinInterval(uint32_t sec){
+	xMinInterval = sec;
+}
+
+bool SNTPClient::isDue(){
+	if ((pRTC == NULL) || (xRetained.lastSync == 0)){
+		return true;
+	}
+	uint32_t now = pRTC->get_epoch();
+	if ((now == 0) || (now < xRetained.lastSync)){
+		return true;
+	}
+	return (now - xRetained.lastSync) >= xMinInterval;
+}
+
+bool SNTPClient::sync(bool force, uint32_t timeoutMs){
+	absolute_time_t timeout = make_timeout_time_ms(timeoutMs);
+
+	if (!force && !isDue()){
+		return false;
+	}
+
+	xResolved = false;
+	xDone = false;
+	xValid = false;
+
+	cyw43_arch_lwip_begin();
+	err_t err = dns_gethostbyname(pServer, &xServerIP, dnsCB, this);
+	cyw43_arch_lwip_end();
+	if (err == ERR_OK){
+		xResolved = true;
+	} else if (err != ERR_INPROGRESS){
+		printf("SNTP DNS failed for %s\n", pServer);
+		return false;
+	}
+	while (!xResolved){
+		if (absolute_time_diff_us(get_absolute_time(), timeout) <= 0){
+			printf("SNTP DNS timeout\n");
+			return false;
+		}
+		cyw43_arch_poll();
+		cyw43_arch_wait_for_work_until(make_timeout_time_ms(10));
+	}
+	if (ip_addr_isany_val(xServerIP)){
+		printf("SNTP DNS failed for %s\n", pServer);
+		return false;
+	}
+
+	cyw43_arch_lwip_begin();
+	pPcb = udp_new();
+	if (pPcb != NULL){
+		udp_recv(pPcb, recvCB, this);
+	}
+	cyw43_arch_lwip_end();
+	if (pPcb == NULL){
+		return false;
+	}
+
+	if (request()){
+		waitDone(timeout);
+	}
+
+	cyw43_arch_lwip_begin();
+	udp_remove(pPcb);
+	cyw43_arch_lwip_end();
+	pPcb = NULL;
+
+	if (!xValid){
+		printf("SNTP no valid response\n");
+		return false;
+	}
+	WifiHelper::recordLatency(xDelayUs);
+	apply();
+	return true;
+}
+
+bool SNTPClient::request(){
+	struct pbuf *p;
+	uint8_t *msg;
+	err_t err;
+
+	cyw43_arch_lwip_begin();
+	p = pbuf_alloc(PBUF_TRANSPORT, SNTP_MSG_LEN, PBUF_RAM);
+	if (p == NULL){
+		cyw43_arch_lwip_end();
+		return false;
+	}
+	msg = (uint8_t *)p->payload;
+	memset(msg, 0, SNTP_MSG_LEN);
+	//LI 0, Version 4, Mode 3 client
+	msg[0] = 0x23;
+
+	//Transmit timestamp is echoed as originate, use as a nonce
+	xNonce = time_us_64();
+	wr32(&msg[40], (uint32_t)(xNonce >> 32));
+	wr32(&msg[44], (uint32_t)xNonce);
+
+	xSendUs = time_us_64();
+	err = udp_sendto(pPcb, p, &xServerIP, SNTP_PORT);
+	pbuf_free(p);
+	cyw43_arch_lwip_end();
+	return (err == ERR_OK);
+}
+
+bool SNTPClient::waitDone(absolute_time_t timeout){
+	while (!xDone){
+		if (absolute_time_diff_us(get_absolute_time(), timeout) <= 0){
+			return false;
+		}
+		cyw43_arch_poll();
+		cyw43_arch_wait_for_work_until(make_timeout_time_ms(10));
+	}
+	return true;
+}
+
+void SNTPClient::dnsCB(const char *name, const ip_addr_t *ip, void *arg){
+	SNTPClient *self = (SNTPClient *)arg;
+
+	if (ip != NULL){
+		self->xServerIP = *ip;
+	} else {
+		ip_addr_set_zero(&self->xServerIP);
+	}
+	self->xResolved = true;
+}
+
+void SNTPClient::recvCB(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+		const ip_addr_t *addr, u16_t port){
+	SNTPClient *self = (SNTPClient *)arg;
+	uint64_t now = time_us_64();
+
+	if ((port == SNTP_PORT) && (p->tot_len >= SNTP_MSG_LEN) && !self->xDone){
+		self->xLocalUs = now;
+		self->handleResponse(p);
+	}
+	pbuf_free(p);
+}
+
+void SNTPClient::handleResponse(struct pbuf *p){
+	uint8_t msg[SNTP_MSG_LEN];
+	uint8_t li, mode, stratum;
+
+	pbuf_copy_partial(p, msg, SNTP_MSG_LEN, 0);
+	li = msg[0] >> 6;
+	mode = msg[0] & 0x07;
+	stratum = msg[1];
+
+	//Must be a server reply to our request from a synchronised server
+	if ((mode != 4) || (li == 3) || (stratum == 0) || (stratum > 15)){
+		return;
+	}
+	if ((rd32(&msg[24]) != (uint32_t)(xNonce >> 32)) ||
+			(rd32(&msg[28]) != (uint32_t)xNonce)){
+		return;
+	}
+
+	uint64_t t2 = ntpToUs(&msg[32]);
+	uint64_t t3 = ntpToUs(&msg[40]);
+	uint64_t rtt = xLocalUs - xSendUs;
+	uint64_t proc = (t3 >= t2) ? (t3 - t2) : 0;
+	uint64_t delay = (rtt > proc) ? (rtt - proc) : 0;
+
+	xDelayUs = (uint32_t)delay;
+	xServerUs = t3 + delay / 2;
+	xValid = true;
+	xDone = true;
+}
+
+void SNTPClient::apply(){
+	datetime_t t;
+	uint64_t now = xServerUs + (time_us_64() - xLocalUs);
+	uint32_t sec = (uint32_t)(now / 1000000ULL) + 1;
+	uint32_t wait = 1000000 - (uint32_t)(now % 1000000ULL);
+	uint32_t old = 0;
+
+	if (pRTC != NULL){
+		old = pRTC->get_epoch();
+		//get_epoch took some time so recompute
+		now = xServerUs + (time_us_64() - xLocalUs);
+		sec = (uint32_t)(now / 1000000ULL) + 1;
+		wait = 1000000 - (uint32_t)(now % 1000000ULL);
+	}
+	toDatetime(sec, &t);
+
+	//Writing the seconds register restarts the DS3231 countdown chain
+	if (wait > SNTP_WRITE_LEAD_US){
+		busy_wait_us_32(wait - SNTP_WRITE_LEAD_US);
+	}
+	if (pRTC != NULL){
+		pRTC->set_time(t.hour, t.min, t.sec, false, false);
+		pRTC->set_date(t.day, t.month, t.year);
+	}
+	if (!rtc_running()){
+		rtc_init();
+	}
+	rtc_set_datetime(&t);
+
+	xRetained.lastSync = sec;
+	if (old != 0){
+		xLastOffset = (int32_t)(sec - old);
+	}
+	printf("SNTP set %04d-%02d-%02d %02d:%02d:%02d delay %luus offset %lds\n",
+			t.year, t.month, t.day, t.hour, t.min, t.sec,
+			(unsigned long)xDelayUs, (long)xLastOffset);
+}
+
+uint32_t SNTPClient::getLastSync(){
+	return xRetained.lastSync;
+}
+
+int32_t SNTPClient::getLastOffset(){
+	return xLastOffset;
+}
+
+uint32_t SNTPClient::getDelayUs(){
+	return xDelayUs;
+}
+
+void SNTPClient::toDatetime(uint32_t epoch, datetime_t *t){
+	uint32_t days = epoch / 86400;
+	uint32_t rem = epoch % 86400;
+
+	t->hour = rem / 3600;
+	t->min = (rem % 3600) / 60;
+	t->sec = rem % 60;
+	//1 Jan 1970 was a Thursday
+	t->dotw = (days + 4) % 7;
+
+	//Civil date from days, years run from March
+	uint32_t z = days + 719468;
+	uint32_t era = z / 146097;
+	uint32_t doe = z - era * 146097;
+	uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	uint32_t mp = (5 * doy + 2) / 153;
+	uint32_t d = doy - (153 * mp + 2) / 5 + 1;
+	uint32_t m = (mp < 10) ? mp + 3 : mp - 9;
+	uint32_t y = yoe + era * 400 + ((m <= 2) ? 1 : 0);
+
+	t->year = y;
+	t->month = m;
+	t->day = d;
+}
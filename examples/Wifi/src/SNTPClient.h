@@ -0,0 +1,153 @@
+/*
+ * SNTPClient.h
+ *
+ * Minimal SNTP client over raw lwIP UDP. Sets the DS3231 and the Pico
+ * RTC, aligning the write to the start of a second so both clocks are
+ * correct to within the round trip uncertainty rather than a second.
+ * Syncs are rate limited using the DS3231 time, and the last sync is
+ * held in RAM that survives Dormant.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SNTPCLIENT_H_
+#define SRC_SNTPCLIENT_H_
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+#include "lwip/ip_addr.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+
+#ifndef SNTP_SERVER
+#define SNTP_SERVER "pool.ntp.org"
+#endif
+
+#define SNTP_PORT 123
+
+//Minimum seconds between syncs
+#ifndef SNTP_MIN_INTERVAL
+#define SNTP_MIN_INTERVAL (6 * 3600)
+#endif
+
+//Time allowed for DNS and the NTP exchange
+#ifndef SNTP_TIMEOUT
+#define SNTP_TIMEOUT 5000
+#endif
+
+class SNTPClient {
+public:
+	/***
+	 * Constructor
+	 * @param server - hostname or dotted IP of the NTP server
+	 * @param minInterval - minimum seconds between syncs
+	 */
+	SNTPClient(const char *server = SNTP_SERVER, uint32_t minInterval = SNTP_MIN_INTERVAL);
+	virtual ~SNTPClient();
+
+	/***
+	 * Set the DS3231 to update, also used for rate limiting
+	 * @param rtc
+	 */
+	void setRTC(DS3231 *rtc);
+
+	/***
+	 * Set the server
+	 * @param server - hostname or dotted IP, for example a local test server
+	 */
+	void setServer(const char *server);
+
+	/***
+	 * Set minimum seconds between syncs
+	 * @param sec
+	 */
+	void setMinInterval(uint32_t sec);
+
+	/***
+	 * Is a sync due
+	 * @return true if never synced or interval has passed
+	 */
+	bool isDue();
+
+	/***
+	 * Query the server and set the clocks. Network must be up.
+	 * @param force - ignore the rate limit
+	 * @param timeoutMs
+	 * @return true if clocks were set
+	 */
+	bool sync(bool force = false, uint32_t timeoutMs = SNTP_TIMEOUT);
+
+	/***
+	 * Epoch of last successful sync
+	 * @return epoch, 0 if none
+	 */
+	uint32_t getLastSync();
+
+	/***
+	 * Correction applied to the DS3231 on the last sync
+	 * @return seconds, positive if the clock was slow
+	 */
+	int32_t getLastOffset();
+
+	/***
+	 * Round trip of the last exchange less server processing
+	 * @return micro seconds
+	 */
+	uint32_t getDelayUs();
+
+private:
+	static void dnsCB(const char *name, const ip_addr_t *ip, void *arg);
+	static void recvCB(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+			const ip_addr_t *addr, u16_t port);
+
+	/***
+	 * Validate response and compute time
+	 * @param p
+	 */
+	void handleResponse(struct pbuf *p);
+
+	/***
+	 * Send the request
+	 * @return true if sent
+	 */
+	bool request();
+
+	/***
+	 * Poll until done or timeout
+	 * @param timeout
+	 * @return true if done
+	 */
+	bool waitDone(absolute_time_t timeout);
+
+	/***
+	 * Set both clocks at the next second boundary
+	 */
+	void apply();
+
+	/***
+	 * Convert epoch to datetime
+	 * @param epoch
+	 * @param t
+	 */
+	static void toDatetime(uint32_t epoch, datetime_t *t);
+
+	const char *pServer;
+	uint32_t xMinInterval;
+	DS3231 *pRTC = NULL;
+
+	struct udp_pcb *pPcb = NULL;
+	ip_addr_t xServerIP;
+	volatile bool xResolved = false;
+	volatile bool xDone = false;
+	bool xValid = false;
+
+	uint64_t xNonce = 0;
+	uint64_t xSendUs = 0;
+	uint64_t xServerUs = 0;		// Unix time in us at xLocalUs
+	uint64_t xLocalUs = 0;
+	uint32_t xDelayUs = 0;
+	int32_t xLastOffset = 0;
+};
+
+#endif /* SRC_SNTPCLIENT_H_ */
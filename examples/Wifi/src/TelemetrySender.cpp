@@ -0,0 +1,236 @@
+/*
+ * TelemetrySender.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "TelemetrySender.h"
+#include "WifiHelper.h"
+#include <cstdio>
+#include <cstring>
+#include "pico/cyw43_arch.h"
+#include "lwip/dns.h"
+
+#define TELEMETRY_MAGIC 'T'
+#define TELEMETRY_ACK_MAGIC 'A'
+#define TELEMETRY_FLAG_LAST 0x01
+
+TelemetrySender::TelemetrySender(const char *host, uint16_t port) {
+	pHost = host;
+	xPort = port;
+	xSeq = (uint16_t)time_us_32();
+}
+
+TelemetrySender::~TelemetrySender() {
+	// NOP
+}
+
+void TelemetrySender::setNodeId(uint32_t id){
+	xNodeId = id;
+}
+
+bool TelemetrySender::send(SampleBuffer *buf, uint32_t timeoutMs){
+	absolute_time_t timeout = make_timeout_time_ms(timeoutMs);
+	uint count = buf->count();
+	uint frames = (count + TELEMETRY_FRAME_RECS - 1) / TELEMETRY_FRAME_RECS;
+	uint base = 0;
+	uint next = 0;
+	uint retries = 0;
+
+	if (count == 0){
+		return true;
+	}
+	if (!resolve(timeout)){
+		return false;
+	}
+
+	cyw43_arch_lwip_begin();
+	pPcb = udp_new();
+	if (pPcb != NULL){
+		udp_recv(pPcb, recvCB, this);
+	}
+	cyw43_arch_lwip_end();
+	if (pPcb == NULL){
+		return false;
+	}
+
+	xAcked = -1;
+	xFrames = frames;
+	while (base < frames){
+		//Fill the window
+		while ((next < frames) && (next - base < TELEMETRY_WINDOW)){
+			if (!sendFrame(buf, next, frames)){
+				break;
+			}
+			next++;
+		}
+
+		//Wait for the window to move
+		absolute_time_t ackTimeout = make_timeout_time_ms(TELEMETRY_ACK_TIMEOUT);
+		while ((xAcked < (int32_t)base) &&
+				(absolute_time_diff_us(get_absolute_time(), ackTimeout) > 0) &&
+				(absolute_time_diff_us(get_absolute_time(), timeout) > 0)){
+			cyw43_arch_poll();
+			cyw43_arch_wait_for_work_until(ackTimeout);
+		}
+
+		if (xAcked >= (int32_t)base){
+			base = xAcked + 1;
+			retries = 0;
+		} else {
+			if ((++retries > TELEMETRY_RETRIES) ||
+					(absolute_time_diff_us(get_absolute_time(), timeout) <= 0)){
+				break;
+			}
+			//Go back to the first unacked frame
+			xResends += next - base;
+			next = base;
+		}
+	}
+
+	cyw43_arch_lwip_begin();
+	udp_remove(pPcb);
+	cyw43_arch_lwip_end();
+	pPcb = NULL;
+
+	uint acked = base * TELEMETRY_FRAME_RECS;
+	if (acked > count){
+		acked = count;
+	}
+	buf->consume(acked);
+	xRecordsAcked += acked;
+	xSeq += frames;
+
+	if (base < frames){
+		printf("Telemetry %u of %u records acked\n", acked, count);
+		return false;
+	}
+	return true;
+}
+
+bool TelemetrySender::sendFrame(SampleBuffer *buf, uint frame, uint frames){
+	uint from = frame * TELEMETRY_FRAME_RECS;
+	uint n = buf->count() - from;
+	uint16_t seq = xSeq + frame;
+	uint32_t dropped = buf->getDropped();
+	struct pbuf *head;
+	uint8_t *h;
+	err_t err;
+
+	if (n > TELEMETRY_FRAME_RECS){
+		n = TELEMETRY_FRAME_RECS;
+	}
+	if (dropped > 0xFFFF){
+		dropped = 0xFFFF;
+	}
+
+	cyw43_arch_lwip_begin();
+	//Room is left for the UDP, IP and link headers in front
+	head = pbuf_alloc(PBUF_TRANSPORT, TELEMETRY_HEADER_LEN, PBUF_RAM);
+	if (head == NULL){
+		cyw43_arch_lwip_end();
+		return false;
+	}
+	h = (uint8_t *)head->payload;
+	h[0] = TELEMETRY_MAGIC;
+	h[1] = TELEMETRY_VERSION;
+	h[2] = (frame == frames - 1) ? TELEMETRY_FLAG_LAST : 0;
+	h[3] = n;
+	h[4] = seq & 0xFF;
+	h[5] = seq >> 8;
+	h[6] = dropped & 0xFF;
+	h[7] = dropped >> 8;
+	memcpy(&h[8], &xNodeId, 4);
+
+	//Reference records in place, two spans if the ring wraps
+	uint sent = 0;
+	while (sent < n){
+		uint len;
+		const SampleRecord *r = buf->span(from + sent, &len);
+		if (len > n - sent){
+			len = n - sent;
+		}
+		struct pbuf *ref = pbuf_alloc(PBUF_RAW, len * sizeof(SampleRecord), PBUF_REF);
+		if (ref == NULL){
+			pbuf_free(head);
+			cyw43_arch_lwip_end();
+			return false;
+		}
+		ref->payload = (void *)r;
+		pbuf_cat(head, ref);
+		sent += len;
+	}
+
+	//Driver copies to the bus on output and ARP clones REF pbufs if queued
+	err = udp_sendto(pPcb, head, &xHostIP, xPort);
+	pbuf_free(head);
+	cyw43_arch_lwip_end();
+
+	xFrameUs[frame % TELEMETRY_WINDOW] = time_us_64();
+	xFramesSent++;
+	return (err == ERR_OK);
+}
+
+bool TelemetrySender::resolve(absolute_time_t timeout){
+	xResolved = false;
+
+	cyw43_arch_lwip_begin();
+	err_t err = dns_gethostbyname(pHost, &xHostIP, dnsCB, this);
+	cyw43_arch_lwip_end();
+	if (err == ERR_OK){
+		return true;
+	}
+	if (err != ERR_INPROGRESS){
+		return false;
+	}
+	while (!xResolved){
+		if (absolute_time_diff_us(get_absolute_time(), timeout) <= 0){
+			return false;
+		}
+		cyw43_arch_poll();
+		cyw43_arch_wait_for_work_until(make_timeout_time_ms(10));
+	}
+	return !ip_addr_isany_val(xHostIP);
+}
+
+void TelemetrySender::dnsCB(const char *name, const ip_addr_t *ip, void *arg){
+	TelemetrySender *self = (TelemetrySender *)arg;
+
+	if (ip != NULL){
+		self->xHostIP = *ip;
+	} else {
+		ip_addr_set_zero(&self->xHostIP);
+	}
+	self->xResolved = true;
+}
+
+void TelemetrySender::recvCB(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+		const ip_addr_t *addr, u16_t port){
+	TelemetrySender *self = (TelemetrySender *)arg;
+	uint8_t ack[4];
+
+	if (pbuf_copy_partial(p, ack, sizeof(ack), 0) == sizeof(ack) &&
+			(ack[0] == TELEMETRY_ACK_MAGIC) && (ack[1] == TELEMETRY_VERSION)){
+		uint16_t seq = ack[2] | (ack[3] << 8);
+		int32_t frame = (uint16_t)(seq - self->xSeq);
+		if ((frame < (int32_t)self->xFrames) && (frame > self->xAcked)){
+			WifiHelper::recordLatency(
+					(uint32_t)(time_us_64() - self->xFrameUs[frame % TELEMETRY_WINDOW]));
+			self->xAcked = frame;
+		}
+	}
+	pbuf_free(p);
+}
+
+uint32_t TelemetrySender::getFramesSent(){
+	return xFramesSent;
+}
+
+uint32_t TelemetrySender::getResends(){
+	return xResends;
+}
+
+uint32_t TelemetrySender::getRecordsAcked(){
+	return xRecordsAcked;
+}
@@ -0,0 +1,153 @@
+/*
+ * TelemetrySender.h
+ *
+ * Send the SampleBuffer over UDP with the lwIP raw API. Records are
+ * referenced in place with PBUF_REF pbufs chained behind a small
+ * PBUF_RAM header, so a batch is sent without copying the samples and
+ * with one small heap allocation per frame.
+ *
+ * Frame, little endian:
+ *   uint8_t  magic 'T'
+ *   uint8_t  version
+ *   uint8_t  flags, bit 0 last frame of batch
+ *   uint8_t  number of records
+ *   uint16_t sequence
+ *   uint16_t records dropped by the buffer, saturating
+ *   uint32_t node id
+ *   SampleRecord[n]
+ * Ack, little endian:
+ *   uint8_t  magic 'A'
+ *   uint8_t  version
+ *   uint16_t highest sequence received in order
+ *
+ * Up to a window of frames are sent before waiting for an ack. Acks are
+ * cumulative, on timeout the unacked frames are sent again. Only
+ * acknowledged records are removed from the buffer.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_TELEMETRYSENDER_H_
+#define SRC_TELEMETRYSENDER_H_
+
+#include "pico/stdlib.h"
+#include "SampleBuffer.h"
+#include "lwip/ip_addr.h"
+#include "lwip/udp.h"
+#include "lwip/pbuf.h"
+
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_LEN 12
+
+//From the dynamic range so no assigned service is on it. Set
+//TELEMETRY_PORT in the environment to build with another
+#ifndef TELEMETRY_PORT
+#define TELEMETRY_PORT 51683
+#endif
+
+//Records per frame, kept within one Ethernet MTU
+#ifndef TELEMETRY_FRAME_RECS
+#define TELEMETRY_FRAME_RECS 40
+#endif
+
+//Frames sent before waiting for an ack
+#ifndef TELEMETRY_WINDOW
+#define TELEMETRY_WINDOW 4
+#endif
+
+#ifndef TELEMETRY_ACK_TIMEOUT
+#define TELEMETRY_ACK_TIMEOUT 500
+#endif
+
+#ifndef TELEMETRY_RETRIES
+#define TELEMETRY_RETRIES 3
+#endif
+
+#ifndef TELEMETRY_TIMEOUT
+#define TELEMETRY_TIMEOUT 5000
+#endif
+
+class TelemetrySender {
+public:
+	/***
+	 * Constructor
+	 * @param host - hostname or dotted IP of the collector
+	 * @param port
+	 */
+	TelemetrySender(const char *host, uint16_t port = TELEMETRY_PORT);
+	virtual ~TelemetrySender();
+
+	/***
+	 * Set the node id sent in each frame
+	 * @param id
+	 */
+	void setNodeId(uint32_t id);
+
+	/***
+	 * Send all records in the buffer and wait for them to be acked.
+	 * Acked records are consumed. Network must be up.
+	 * @param buf
+	 * @param timeoutMs - bound on the whole batch
+	 * @return true if all records were acked
+	 */
+	bool send(SampleBuffer *buf, uint32_t timeoutMs = TELEMETRY_TIMEOUT);
+
+	/***
+	 * Frames sent including resends, since construction
+	 * @return
+	 */
+	uint32_t getFramesSent();
+
+	/***
+	 * Frames sent again after an ack timeout
+	 * @return
+	 */
+	uint32_t getResends();
+
+	/***
+	 * Records acked and consumed
+	 * @return
+	 */
+	uint32_t getRecordsAcked();
+
+private:
+	static void dnsCB(const char *name, const ip_addr_t *ip, void *arg);
+	static void recvCB(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+			const ip_addr_t *addr, u16_t port);
+
+	/***
+	 * Resolve the host
+	 * @param timeout
+	 * @return true if resolved
+	 */
+	bool resolve(absolute_time_t timeout);
+
+	/***
+	 * Send one frame referencing the records in the buffer
+	 * @param buf
+	 * @param frame - index in batch
+	 * @param frames - number in batch
+	 * @return true if sent
+	 */
+	bool sendFrame(SampleBuffer *buf, uint frame, uint frames);
+
+	const char *pHost;
+	uint16_t xPort;
+	uint32_t xNodeId = 0;
+
+	struct udp_pcb *pPcb = NULL;
+	ip_addr_t xHostIP;
+	volatile bool xResolved = false;
+
+	uint16_t xSeq = 0;			// Sequence of first frame in batch
+	uint xFrames = 0;			// Frames in batch
+	volatile int32_t xAcked = -1;	// Highest frame in batch acked
+	uint64_t xFrameUs[TELEMETRY_WINDOW];
+
+	uint32_t xFramesSent = 0;
+	uint32_t xResends = 0;
+	uint32_t xRecordsAcked = 0;
+};
+
+#endif /* SRC_TELEMETRYSENDER_H_ */
@@ -0,0 +1,129 @@
+/*
+ * WifiCache.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "WifiCache.h"
+#include <string.h>
+#include <new>
+
+#define WIFI_CACHE_MAGIC 0x57494643
+
+//Not zeroed at boot so survives a watchdog reset
+static WifiCacheData __uninitialized_ram(xData);
+
+alignas(WifiCache) static uint8_t xSingletonStore[sizeof(WifiCache)];
+WifiCache * WifiCache::pSingleton = NULL;
+
+WifiCache::WifiCache() {
+	xLastUs = time_us_64();
+	if ((xData.magic != WIFI_CACHE_MAGIC) || (xData.crc != crc(&xData))){
+		invalidate();
+	}
+}
+
+WifiCache::~WifiCache() {
+	// NOP
+}
+
+WifiCache * WifiCache::singleton(){
+	if (pSingleton == NULL){
+		pSingleton = new (xSingletonStore) WifiCache;
+	}
+	return pSingleton;
+}
+
+bool WifiCache::isValid(){
+	return (xData.magic == WIFI_CACHE_MAGIC);
+}
+
+bool WifiCache::isLeaseValid(){
+	if (!isValid() || !xData.hasLease){
+		return false;
+	}
+	updateAge();
+	return ((xData.ageSec + WIFI_CACHE_LEASE_MARGIN) < xData.leaseSec);
+}
+
+bool WifiCache::setAP(const uint8_t *bssid, uint32_t channel){
+	bool changed = isValid() && (memcmp(xData.bssid, bssid, 6) != 0);
+
+	updateAge();
+	if (changed){
+		xData.hasLease = false;
+		xData.hasGwMac = false;
+	}
+	memcpy(xData.bssid, bssid, 6);
+	xData.channel = channel;
+	xData.magic = WIFI_CACHE_MAGIC;
+	seal();
+	return changed;
+}
+
+void WifiCache::setLease(uint32_t ip, uint32_t mask, uint32_t gw, uint32_t dns, uint32_t leaseSec){
+	xData.ip = ip;
+	xData.mask = mask;
+	xData.gw = gw;
+	xData.dns = dns;
+	xData.leaseSec = leaseSec;
+	xData.ageSec = 0;
+	xData.hasLease = true;
+	xLastUs = time_us_64();
+	seal();
+}
+
+void WifiCache::setGwMac(const uint8_t *mac){
+	memcpy(xData.gwMac, mac, 6);
+	xData.hasGwMac = true;
+	seal();
+}
+
+void WifiCache::clearLease(){
+	xData.hasLease = false;
+	xData.hasGwMac = false;
+	seal();
+}
+
+void WifiCache::invalidate(){
+	memset(&xData, 0, sizeof(xData));
+	seal();
+}
+
+const WifiCacheData * WifiCache::getData(){
+	return &xData;
+}
+
+void WifiCache::notifyWake(uint minutes){
+	//Timer does not run asleep so count the planned sleep
+	updateAge();
+	xData.ageSec += minutes * 60;
+	seal();
+}
+
+void WifiCache::updateAge(){
+	uint64_t now = time_us_64();
+
+	xData.ageSec += (uint32_t)((now - xLastUs) / 1000000);
+	xLastUs = now - ((now - xLastUs) % 1000000);
+	seal();
+}
+
+void WifiCache::seal(){
+	xData.crc = crc(&xData);
+}
+
+uint32_t WifiCache::crc(const WifiCacheData *data){
+	const uint8_t *p = (const uint8_t *)data;
+	uint32_t c = 0xFFFFFFFF;
+
+	//CRC32 over everything before the crc field
+	for (size_t i = 0; i < offsetof(WifiCacheData, crc); i++){
+		c ^= p[i];
+		for (int b = 0; b < 8; b++){
+			c = (c >> 1) ^ (0xEDB88320 & (-(c & 1)));
+		}
+	}
+	return ~c;
+}
@@ -0,0 +1,127 @@
+/*
+ * WifiCache.h
+ *
+ * Rejoin cache for the Wifi. Holds the AP BSSID and channel, the DHCP
+ * lease and the gateway MAC in RAM that is not initialised at boot, so
+ * it survives Dormant, DeepSleep and watchdog resets.
+ * Observes sleeps to age the lease while asleep.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_WIFICACHE_H_
+#define SRC_WIFICACHE_H_
+
+#include "pico/stdlib.h"
+#include "DormantNotification.h"
+
+//Renew lease by DHCP once less than this remains
+#ifndef WIFI_CACHE_LEASE_MARGIN
+#define WIFI_CACHE_LEASE_MARGIN 300
+#endif
+
+struct WifiCacheData {
+	uint32_t	magic;
+	uint8_t		bssid[6];
+	uint8_t		gwMac[6];
+	uint32_t	channel;
+	uint32_t	ip;
+	uint32_t	mask;
+	uint32_t	gw;
+	uint32_t	dns;
+	uint32_t	leaseSec;
+	uint32_t	ageSec;
+	bool		hasLease;
+	bool		hasGwMac;
+	uint32_t	crc;
+};
+
+class WifiCache : public DormantNotification {
+public:
+	WifiCache();
+	virtual ~WifiCache();
+
+	/***
+	 * Get the cache held in retained memory
+	 * @return cache
+	 */
+	static WifiCache * singleton();
+
+	/***
+	 * Is there a BSSID and channel to join on
+	 * @return true if valid
+	 */
+	bool isValid();
+
+	/***
+	 * Is there a lease with more than the margin left
+	 * @return true if the lease can be reused
+	 */
+	bool isLeaseValid();
+
+	/***
+	 * Store association details. If the BSSID has changed the lease
+	 * and gateway MAC are dropped as they may belong to another network.
+	 * @param bssid - uint8_t[6]
+	 * @param channel
+	 * @return true if the BSSID changed
+	 */
+	bool setAP(const uint8_t *bssid, uint32_t channel);
+
+	/***
+	 * Store a new lease, age starts at zero
+	 * @param ip - network byte order
+	 * @param mask
+	 * @param gw
+	 * @param dns - DNS server, 0 if none
+	 * @param leaseSec - lease time granted by server
+	 */
+	void setLease(uint32_t ip, uint32_t mask, uint32_t gw, uint32_t dns, uint32_t leaseSec);
+
+	/***
+	 * Store the gateway MAC from the ARP table
+	 * @param mac - uint8_t[6]
+	 */
+	void setGwMac(const uint8_t *mac);
+
+	/***
+	 * Drop the lease, keep the AP
+	 */
+	void clearLease();
+
+	/***
+	 * Drop everything
+	 */
+	void invalidate();
+
+	/***
+	 * Get the cached data, only meaningful if isValid
+	 * @return data
+	 */
+	const WifiCacheData * getData();
+
+	/***
+	 * Age the lease by time slept
+	 * @param minutes
+	 */
+	virtual void notifyWake(uint minutes);
+
+private:
+	/***
+	 * Add awake time since last update to lease age
+	 */
+	void updateAge();
+
+	/***
+	 * Seal data with CRC after change
+	 */
+	void seal();
+
+	uint32_t crc(const WifiCacheData *data);
+
+	static WifiCache * pSingleton;
+	uint64_t xLastUs = 0;
+};
+
+#endif /* SRC_WIFICACHE_H_ */
@@ -6,10 +6,49 @@
  */
 
 #include "WifiHelper.h"
+#include "WifiCache.h"
 
 #include "pico/cyw43_arch.h"
 #include "pico/util/datetime.h"
+#include "lwip/dhcp.h"
+#include "lwip/etharp.h"
+#include "lwip/dns.h"
 
+#ifndef CYW43_IOCTL_GET_CHANNEL
+#define CYW43_IOCTL_GET_CHANNEL (0x3a)
+#endif
+
+static const uint32_t xPMValues[WIFI_PM_MODES] = {
+		CYW43_PERFORMANCE_PM,
+		CYW43_AGGRESSIVE_PM,
+		CYW43_NO_POWERSAVE_MODE
+};
+
+static const char *xPMNames[WIFI_PM_MODES] = {
+		"PERFORMANCE",
+		"AGGRESSIVE",
+		"NONE"
+};
+
+WifiJoinState WifiHelper::xJoinState = WIFI_JOIN_IDLE;
+const char *WifiHelper::pJoinSID = NULL;
+const char *WifiHelper::pJoinPassword = NULL;
+uint8_t WifiHelper::xJoinRetries = WIFI_RETRIES;
+uint8_t WifiHelper::xJoinAttempts = 0;
+absolute_time_t WifiHelper::xJoinNext;
+uint32_t WifiHelper::xOutages = 0;
+
+WifiAddrMode WifiHelper::xAddrMode = WIFI_ADDR_LEASE;
+ip4_addr_t WifiHelper::xStaticIP;
+ip4_addr_t WifiHelper::xStaticMask;
+ip4_addr_t WifiHelper::xStaticGW;
+ip4_addr_t WifiHelper::xStaticDNS;
+
+WifiPowerMode WifiHelper::xPowerMode = WIFI_PM_PERFORMANCE;
+WifiPowerStats WifiHelper::xPowerStats[WIFI_PM_MODES];
+uint64_t WifiHelper::xMarkUs = 0;
+netif_linkoutput_fn WifiHelper::pLinkOutput = NULL;
+netif_input_fn WifiHelper::pInput = NULL;
 
 
 WifiHelper::WifiHelper() {
@@ -32,39 +71,147 @@ bool WifiHelper::init(){
 		return false;
 	}
 
-	//cyw43_wifi_pm(&cyw43_state ,CYW43_AGGRESSIVE_PM);
-	cyw43_wifi_pm(&cyw43_state ,CYW43_PERFORMANCE_PM);
+	cyw43_wifi_pm(&cyw43_state, xPMValues[xPowerMode]);
 
 	return true;
 
 }
 
 bool WifiHelper::deInit(){
+	radioDown();
 	cyw43_arch_deinit();
 	return true;
 }
 
+void WifiHelper::radioDown(){
+	if (xMarkUs != 0){
+		markTime();
+		xMarkUs = 0;
+	}
+	if (xJoinState != WIFI_JOIN_FAILED){
+		xJoinState = WIFI_JOIN_IDLE;
+	}
+}
+
 bool WifiHelper::join(const char *sid, const char *password,  uint8_t retries){
+	printf("Connecting to WiFi... %s \n", sid);
+
+	if (!joinStart(sid, password, retries)){
+		return false;
+	}
+	for (;;){
+		switch (joinPoll()){
+		case WIFI_JOIN_UP:
+			return true;
+		case WIFI_JOIN_FAILED:
+		case WIFI_JOIN_IDLE:
+			return false;
+		default:
+			joinWait();
+		}
+	}
+}
+
+bool WifiHelper::joinStart(const char *sid, const char *password, uint8_t retries){
+	pJoinSID = sid;
+	pJoinPassword = password;
+	xJoinRetries = retries;
+	xJoinAttempts = 1;
+
 	cyw43_arch_enable_sta_mode();
-	printf("Connecting to WiFi... %s \n", WIFI_SSID);
+	staUp();
+	if (cyw43_arch_wifi_connect_async(sid, password, CYW43_AUTH_WPA2_AES_PSK) != 0){
+		xJoinState = WIFI_JOIN_IDLE;
+		return false;
+	}
+	xJoinState = WIFI_JOIN_CONNECTING;
+	xJoinNext = make_timeout_time_ms(WIFI_JOIN_ATTEMPT_TIMEOUT);
+	return true;
+}
 
-	//Loop trying to connect to Wifi
-	int r =-1;
-	uint8_t attempts = 0;
-	while (r < 0){
-		attempts++;
-		r = cyw43_arch_wifi_connect_timeout_ms(sid, password, CYW43_AUTH_WPA2_AES_PSK, 60000);
+WifiJoinState WifiHelper::joinPoll(){
+	int status;
+	bool expired = (absolute_time_diff_us(get_absolute_time(), xJoinNext) <= 0);
 
-		if (r){
+	cyw43_arch_poll();
+	switch (xJoinState){
+	case WIFI_JOIN_CONNECTING:
+		status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+		if (status == CYW43_LINK_UP){
+			xJoinState = WIFI_JOIN_UP;
+			xOutages = 0;
+		} else if ((status < 0) || expired){
 			printf("Failed to join AP.\n");
-			if (attempts >= retries){
-				return false;
+			//Stop the firmware retrying on its own
+			cyw43_wifi_leave(&cyw43_state, CYW43_ITF_STA);
+			if (xJoinAttempts >= xJoinRetries){
+				xJoinState = WIFI_JOIN_FAILED;
+				xOutages++;
+			} else {
+				//Cap the doubling before it can overflow the shift
+				uint shift = xJoinAttempts - 1;
+				if (shift > WIFI_JOIN_BACKOFF_MAX_SHIFT){
+					shift = WIFI_JOIN_BACKOFF_MAX_SHIFT;
+				}
+				uint32_t ms = WIFI_JOIN_BACKOFF_MS << shift;
+				if (ms > WIFI_JOIN_BACKOFF_MAX_MS){
+					ms = WIFI_JOIN_BACKOFF_MAX_MS;
+				}
+				xJoinState = WIFI_JOIN_BACKOFF;
+				xJoinNext = make_timeout_time_ms(ms);
+			}
+		}
+		break;
+	case WIFI_JOIN_BACKOFF:
+		if (expired){
+			xJoinAttempts++;
+			if (cyw43_arch_wifi_connect_async(pJoinSID, pJoinPassword,
+					CYW43_AUTH_WPA2_AES_PSK) == 0){
+				xJoinState = WIFI_JOIN_CONNECTING;
+				xJoinNext = make_timeout_time_ms(WIFI_JOIN_ATTEMPT_TIMEOUT);
+			} else {
+				xJoinState = WIFI_JOIN_FAILED;
+				xOutages++;
 			}
-			sleep_ms(2000);
 		}
+		break;
+	default:
+		break;
 	}
-	return true;
+	return xJoinState;
+}
+
+absolute_time_t WifiHelper::joinNextPoll(){
+	//Link status changes are only seen by polling the driver
+	absolute_time_t t = make_timeout_time_ms(100);
+	if ((xJoinState == WIFI_JOIN_BACKOFF) &&
+			(absolute_time_diff_us(t, xJoinNext) > 0)){
+		return xJoinNext;
+	}
+	return t;
+}
+
+void WifiHelper::joinWait(){
+	cyw43_arch_wait_for_work_until(joinNextPoll());
+}
+
+WifiJoinState WifiHelper::getJoinState(){
+	return xJoinState;
+}
+
+uint WifiHelper::getOutageSleep(){
+	uint minutes = 1;
 
+	if (xOutages == 0){
+		return 0;
+	}
+	for (uint32_t i = 1; (i < xOutages) && (minutes < WIFI_OUTAGE_SLEEP_MAX); i++){
+		minutes *= 2;
+	}
+	if (minutes > WIFI_OUTAGE_SLEEP_MAX){
+		minutes = WIFI_OUTAGE_SLEEP_MAX;
+	}
+	return minutes;
 }
 
 
@@ -163,3 +310,275 @@ bool WifiHelper::isJoined(){
 }
 
 
+bool WifiHelper::rejoin(const char *sid, const char *password,  uint8_t retries){
+	WifiCache *cache = WifiCache::singleton();
+
+	if (cache->isValid()){
+		const WifiCacheData *d = cache->getData();
+		bool lease = (xAddrMode == WIFI_ADDR_LEASE) && cache->isLeaseValid();
+
+		cyw43_arch_enable_sta_mode();
+		staUp();
+		if (lease){
+			fixAddr(d->ip, d->mask, d->gw, d->dns);
+		}
+		if (d->hasGwMac && (lease || (xAddrMode == WIFI_ADDR_STATIC))){
+			ip4_addr_t gw;
+			gw.addr = (xAddrMode == WIFI_ADDR_STATIC) ? xStaticGW.addr : d->gw;
+			cyw43_arch_lwip_begin();
+			etharp_add_static_entry(&gw, (struct eth_addr *)d->gwMac);
+			cyw43_arch_lwip_end();
+		}
+
+		int r = cyw43_wifi_join(&cyw43_state,
+				strlen(sid), (const uint8_t *)sid,
+				strlen(password), (const uint8_t *)password,
+				CYW43_AUTH_WPA2_AES_PSK,
+				d->bssid, d->channel);
+		if ((r == 0) && waitForLink(WIFI_REJOIN_TIMEOUT)){
+			xJoinState = WIFI_JOIN_UP;
+			xOutages = 0;
+			if (!lease){
+				updateCache();
+			}
+			return true;
+		}
+
+		printf("Rejoin failed, full join\n");
+		cache->invalidate();
+		deInit();
+		if (!init()){
+			return false;
+		}
+	}
+
+	if (!join(sid, password, retries)){
+		return false;
+	}
+	updateCache();
+	return true;
+}
+
+void WifiHelper::updateCache(){
+	WifiCache *cache = WifiCache::singleton();
+	struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+	uint8_t bssid[6];
+	uint32_t channel;
+	struct eth_addr *mac;
+	const ip4_addr_t *ip;
+
+	if (!isJoined()){
+		return;
+	}
+	if ((cyw43_wifi_get_bssid(&cyw43_state, bssid) == 0) && getChannel(&channel)){
+		if (cache->setAP(bssid, channel) &&
+				(xAddrMode == WIFI_ADDR_LEASE) && !dhcp_supplied_address(n)){
+			//Restored lease belongs to the old AP, get a new one
+			printf("BSSID changed, restarting DHCP\n");
+			cyw43_arch_lwip_begin();
+			dhcp_start(n);
+			cyw43_arch_lwip_end();
+			return;
+		}
+	}
+
+	cyw43_arch_lwip_begin();
+	if (dhcp_supplied_address(n)){
+		const ip_addr_t *dns = dns_getserver(0);
+		cache->setLease(
+				ip4_addr_get_u32(netif_ip4_addr(n)),
+				ip4_addr_get_u32(netif_ip4_netmask(n)),
+				ip4_addr_get_u32(netif_ip4_gw(n)),
+				ip_addr_get_ip4_u32(dns),
+				netif_dhcp_data(n)->offered_t0_lease);
+	}
+	if (etharp_find_addr(n, netif_ip4_gw(n), &mac, &ip) >= 0){
+		cache->setGwMac(mac->addr);
+	}
+	cyw43_arch_lwip_end();
+}
+
+bool WifiHelper::waitForLink(uint32_t timeoutMs){
+	absolute_time_t timeout = make_timeout_time_ms(timeoutMs);
+	int status;
+
+	while (absolute_time_diff_us(get_absolute_time(), timeout) > 0){
+		cyw43_arch_poll();
+		status = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+		if (status == CYW43_LINK_UP){
+			return true;
+		}
+		if (status < 0){
+			return false;
+		}
+		cyw43_arch_wait_for_work_until(make_timeout_time_ms(10));
+	}
+	return false;
+}
+
+bool WifiHelper::getChannel(uint32_t *channel){
+	//channel_info_t, first word is the hardware channel
+	uint32_t info[3] = {0, 0, 0};
+
+	if (cyw43_ioctl(&cyw43_state, CYW43_IOCTL_GET_CHANNEL,
+			sizeof(info), (uint8_t *)info, CYW43_ITF_STA) != 0){
+		return false;
+	}
+	*channel = info[0];
+	return true;
+}
+
+void WifiHelper::setAddrMode(WifiAddrMode mode){
+	xAddrMode = mode;
+}
+
+WifiAddrMode WifiHelper::getAddrMode(){
+	return xAddrMode;
+}
+
+bool WifiHelper::setStaticAddr(const char *ip, const char *mask,
+		const char *gw, const char *dns){
+	if (!ip4addr_aton(ip, &xStaticIP) ||
+			!ip4addr_aton(mask, &xStaticMask) ||
+			!ip4addr_aton(gw, &xStaticGW)){
+		return false;
+	}
+	if (dns == NULL){
+		xStaticDNS = xStaticGW;
+	} else if (!ip4addr_aton(dns, &xStaticDNS)){
+		return false;
+	}
+	xAddrMode = WIFI_ADDR_STATIC;
+	return true;
+}
+
+void WifiHelper::fixAddr(uint32_t ip, uint32_t mask, uint32_t gw, uint32_t dns){
+	struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+	ip4_addr_t i, m, g;
+	ip_addr_t d;
+
+	i.addr = ip;
+	m.addr = mask;
+	g.addr = gw;
+	cyw43_arch_lwip_begin();
+	//DHCP is not bound yet so stopping sends no release
+	dhcp_stop(n);
+	netif_set_addr(n, &i, &m, &g);
+	if (dns != 0){
+		ip_addr_set_ip4_u32(&d, dns);
+		dns_setserver(0, &d);
+	}
+	cyw43_arch_lwip_end();
+}
+
+bool WifiHelper::setPowerMode(WifiPowerMode mode){
+	if (mode >= WIFI_PM_MODES){
+		return false;
+	}
+	if (xMarkUs != 0){
+		markTime();
+		xPowerMode = mode;
+		return (cyw43_wifi_pm(&cyw43_state, xPMValues[mode]) == 0);
+	}
+	xPowerMode = mode;
+	return true;
+}
+
+WifiPowerMode WifiHelper::getPowerMode(){
+	return xPowerMode;
+}
+
+void WifiHelper::recordLatency(uint32_t us){
+	WifiPowerStats *s = &xPowerStats[xPowerMode];
+
+	s->latencyCount++;
+	s->latencySumUs += us;
+	if (us > s->latencyMaxUs){
+		s->latencyMaxUs = us;
+	}
+}
+
+const WifiPowerStats * WifiHelper::getPowerStats(WifiPowerMode mode){
+	if (xMarkUs != 0){
+		markTime();
+	}
+	return &xPowerStats[mode];
+}
+
+void WifiHelper::resetPowerStats(){
+	memset(xPowerStats, 0, sizeof(xPowerStats));
+	if (xMarkUs != 0){
+		xMarkUs = time_us_64();
+	}
+}
+
+void WifiHelper::printPowerStats(){
+	if (xMarkUs != 0){
+		markTime();
+	}
+	for (int i = 0; i < WIFI_PM_MODES; i++){
+		WifiPowerStats *s = &xPowerStats[i];
+		uint32_t ms = (uint32_t)(s->timeUs / 1000);
+		uint32_t bps = 0;
+		uint32_t lat = 0;
+		if (ms > 0){
+			bps = (uint32_t)(((uint64_t)(s->txBytes + s->rxBytes) * 1000) / ms);
+		}
+		if (s->latencyCount > 0){
+			lat = s->latencySumUs / s->latencyCount;
+		}
+		printf("PM %-11s %lums tx %lu/%lu rx %lu/%lu %luB/s lat avg %luus max %luus\n",
+				xPMNames[i],
+				(unsigned long)ms,
+				(unsigned long)s->txPackets, (unsigned long)s->txBytes,
+				(unsigned long)s->rxPackets, (unsigned long)s->rxBytes,
+				(unsigned long)bps,
+				(unsigned long)lat, (unsigned long)s->latencyMaxUs);
+	}
+}
+
+void WifiHelper::staUp(){
+	struct netif *n = &cyw43_state.netif[CYW43_ITF_STA];
+
+	if (xAddrMode == WIFI_ADDR_STATIC){
+		fixAddr(xStaticIP.addr, xStaticMask.addr, xStaticGW.addr, xStaticDNS.addr);
+	}
+
+	cyw43_wifi_pm(&cyw43_state, xPMValues[xPowerMode]);
+	xMarkUs = time_us_64();
+
+	//Netif is recreated on each init so hook again
+	cyw43_arch_lwip_begin();
+	if (n->linkoutput != countOutput){
+		pLinkOutput = n->linkoutput;
+		n->linkoutput = countOutput;
+	}
+	if (n->input != countInput){
+		pInput = n->input;
+		n->input = countInput;
+	}
+	cyw43_arch_lwip_end();
+}
+
+void WifiHelper::markTime(){
+	uint64_t now = time_us_64();
+
+	xPowerStats[xPowerMode].timeUs += now - xMarkUs;
+	xMarkUs = now;
+}
+
+err_t WifiHelper::countOutput(struct netif *netif, struct pbuf *p){
+	WifiPowerStats *s = &xPowerStats[xPowerMode];
+
+	s->txPackets++;
+	s->txBytes += p->tot_len;
+	return pLinkOutput(netif, p);
+}
+
+err_t WifiHelper::countInput(struct pbuf *p, struct netif *netif){
+	WifiPowerStats *s = &xPowerStats[xPowerMode];
+
+	s->rxPackets++;
+	s->rxBytes += p->tot_len;
+	return pInput(p, netif);
+}
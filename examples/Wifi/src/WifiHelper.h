@@ -10,11 +10,85 @@
 
 #include <stdlib.h>
 #include "pico/stdlib.h"
+#include "lwip/netif.h"
 
 #ifndef WIFI_RETRIES
 #define WIFI_RETRIES 3
 #endif
 
+//Time allowed for a cached rejoin before falling back to full join
+#ifndef WIFI_REJOIN_TIMEOUT
+#define WIFI_REJOIN_TIMEOUT 5000
+#endif
+
+/***
+ * CYW43 power management modes. Radio off for sleep is deInit.
+ */
+enum WifiPowerMode {
+	WIFI_PM_PERFORMANCE = 0,	// Power save with short sleep, for bulk transfer
+	WIFI_PM_AGGRESSIVE = 1,		// Deep power save, for idle connected windows
+	WIFI_PM_NONE = 2,			// No power save, lowest latency
+	WIFI_PM_MODES = 3
+};
+
+//Time allowed for each join attempt
+#ifndef WIFI_JOIN_ATTEMPT_TIMEOUT
+#define WIFI_JOIN_ATTEMPT_TIMEOUT 15000
+#endif
+
+//Back-off after first failed attempt, doubles on each failure
+#ifndef WIFI_JOIN_BACKOFF_MS
+#define WIFI_JOIN_BACKOFF_MS 2000
+#endif
+
+#ifndef WIFI_JOIN_BACKOFF_MAX_MS
+#define WIFI_JOIN_BACKOFF_MAX_MS 30000
+#endif
+
+//Doublings of the back-off, 2s << 4 already passes the 30s cap
+#ifndef WIFI_JOIN_BACKOFF_MAX_SHIFT
+#define WIFI_JOIN_BACKOFF_MAX_SHIFT 4
+#endif
+
+//Longest sleep suggested after the AP is unreachable
+#ifndef WIFI_OUTAGE_SLEEP_MAX
+#define WIFI_OUTAGE_SLEEP_MAX 60
+#endif
+
+/***
+ * State of an asynchronous join
+ */
+enum WifiJoinState {
+	WIFI_JOIN_IDLE = 0,
+	WIFI_JOIN_CONNECTING,	// Waiting for link and address
+	WIFI_JOIN_BACKOFF,		// Waiting before next attempt
+	WIFI_JOIN_UP,			// Joined with an address
+	WIFI_JOIN_FAILED		// Retries used up, AP unreachable
+};
+
+/***
+ * How the station gets its address
+ */
+enum WifiAddrMode {
+	WIFI_ADDR_DHCP = 0,		// DHCP on every join
+	WIFI_ADDR_LEASE = 1,	// Reuse cached lease, DHCP when expired or AP changed
+	WIFI_ADDR_STATIC = 2	// Configured address, no DHCP
+};
+
+/***
+ * Traffic and time counted per power mode
+ */
+struct WifiPowerStats {
+	uint64_t	timeUs;			// Time connected in this mode
+	uint32_t	txBytes;
+	uint32_t	rxBytes;
+	uint32_t	txPackets;
+	uint32_t	rxPackets;
+	uint32_t	latencyCount;	// Round trips recorded by the application
+	uint32_t	latencySumUs;
+	uint32_t	latencyMaxUs;
+};
+
 
 class WifiHelper {
 public:
@@ -34,6 +108,13 @@ public:
 	 */
 	static bool deInit();
 
+	/***
+	 * Radio is about to be de-initialised elsewhere, for example by
+	 * CYW43Power. Stops timing the power mode and leaves it unapplied
+	 * until the next join
+	 */
+	static void radioDown();
+
 	/***
 	 * Get IP address of unit
 	 * @param ip - output uint8_t[4]
@@ -82,7 +163,8 @@ public:
 	static bool getMACAddressStr(char *macStr);
 
 	/***
-	 *  Join a Wifi Network
+	 *  Join a Wifi Network. Blocks using joinStart and joinPoll with
+	 *  the core in WFE between polls and back-off between attempts.
 	 * @param sid - string of the SID
 	 * @param password - Password for network
 	 * @param retries - Number of times to retry, defalts to 3.
@@ -90,6 +172,128 @@ public:
 	 */
 	static bool join(const char *sid, const char *password, uint8_t retries = WIFI_RETRIES);
 
+	/***
+	 * Start joining a network without blocking. Call joinPoll until
+	 * UP or FAILED, sleeping until joinNextPoll in between.
+	 * Strings must stay valid until the join completes.
+	 * @param sid - string of the SID
+	 * @param password - Password for network
+	 * @param retries - Number of attempts before FAILED
+	 * @return false if the attempt could not be started
+	 */
+	static bool joinStart(const char *sid, const char *password, uint8_t retries = WIFI_RETRIES);
+
+	/***
+	 * Advance the join, cheap to call
+	 * @return state
+	 */
+	static WifiJoinState joinPoll();
+
+	/***
+	 * Time the join next needs polling, the caller may sleep until then
+	 * @return time
+	 */
+	static absolute_time_t joinNextPoll();
+
+	/***
+	 * Sleep with the core in WFE until the join next needs polling or
+	 * the driver has work
+	 */
+	static void joinWait();
+
+	/***
+	 * Get state of the join
+	 * @return state
+	 */
+	static WifiJoinState getJoinState();
+
+	/***
+	 * Minutes to sleep before trying again after joins have failed.
+	 * Doubles with each consecutive failure up to WIFI_OUTAGE_SLEEP_MAX
+	 * and resets on a successful join.
+	 * @return minutes, 0 if last join succeeded
+	 */
+	static uint getOutageSleep();
+
+	/***
+	 * Rejoin using the Wifi Cache. Associates on the cached BSSID and
+	 * channel, reusing the cached lease and gateway ARP entry so no
+	 * scan or DHCP exchange is needed. Falls back to join if the cache
+	 * is empty or the rejoin fails, and fills the cache on success.
+	 * @param sid - string of the SID
+	 * @param password - Password for network
+	 * @param retries - Number of times to retry full join, defalts to 3.
+	 * @return true if successful
+	 */
+	static bool rejoin(const char *sid, const char *password, uint8_t retries = WIFI_RETRIES);
+
+	/***
+	 * Update the Wifi Cache from the current connection. Call before
+	 * sleeping so the gateway MAC is captured once traffic has flowed.
+	 */
+	static void updateCache();
+
+	/***
+	 * Select how the address is obtained, defaults to lease reuse
+	 * @param mode
+	 */
+	static void setAddrMode(WifiAddrMode mode);
+
+	/***
+	 * Get how the address is obtained
+	 * @return mode
+	 */
+	static WifiAddrMode getAddrMode();
+
+	/***
+	 * Configure a static address and select static mode
+	 * @param ip - dotted string
+	 * @param mask - dotted string
+	 * @param gw - dotted string
+	 * @param dns - dotted string, NULL to use the gateway
+	 * @return false if an address does not parse
+	 */
+	static bool setStaticAddr(const char *ip, const char *mask,
+			const char *gw, const char *dns = NULL);
+
+	/***
+	 * Select the power management mode, applied now if the radio is up
+	 * and on each join.
+	 * @param mode
+	 * @return true if applied or radio is down
+	 */
+	static bool setPowerMode(WifiPowerMode mode);
+
+	/***
+	 * Get the power management mode
+	 * @return mode
+	 */
+	static WifiPowerMode getPowerMode();
+
+	/***
+	 * Record an application round trip against the current mode,
+	 * for example an SNTP exchange or a telemetry ack
+	 * @param us - round trip in micro seconds
+	 */
+	static void recordLatency(uint32_t us);
+
+	/***
+	 * Get counters for a mode
+	 * @param mode
+	 * @return stats
+	 */
+	static const WifiPowerStats * getPowerStats(WifiPowerMode mode);
+
+	/***
+	 * Clear counters for all modes
+	 */
+	static void resetPowerStats();
+
+	/***
+	 * Print throughput and latency for each mode
+	 */
+	static void printPowerStats();
+
 	/***
 	 * Returns if joined to the network and we have a link
 	 * @return true if joined.
@@ -97,7 +301,61 @@ public:
 	static bool isJoined();
 
 private:
+	/***
+	 * Poll until link up with an IP address
+	 * @param timeoutMs
+	 * @return true if up, false on failure or timeout
+	 */
+	static bool waitForLink(uint32_t timeoutMs);
+
+	/***
+	 * Get the channel of the associated AP
+	 * @param channel - output
+	 * @return true if successful
+	 */
+	static bool getChannel(uint32_t *channel);
+
+	/***
+	 * Station interface is up, apply power mode and count traffic
+	 */
+	static void staUp();
+
+	/***
+	 * Add time since last mark to the current mode
+	 */
+	static void markTime();
+
+	/***
+	 * Stop DHCP and set a fixed address
+	 * @param ip
+	 * @param mask
+	 * @param gw
+	 * @param dns - 0 for none
+	 */
+	static void fixAddr(uint32_t ip, uint32_t mask, uint32_t gw, uint32_t dns);
+
+	static err_t countOutput(struct netif *netif, struct pbuf *p);
+	static err_t countInput(struct pbuf *p, struct netif *netif);
+
+	static WifiJoinState xJoinState;
+	static const char *pJoinSID;
+	static const char *pJoinPassword;
+	static uint8_t xJoinRetries;
+	static uint8_t xJoinAttempts;
+	static absolute_time_t xJoinNext;
+	static uint32_t xOutages;
+
+	static WifiAddrMode xAddrMode;
+	static ip4_addr_t xStaticIP;
+	static ip4_addr_t xStaticMask;
+	static ip4_addr_t xStaticGW;
+	static ip4_addr_t xStaticDNS;
 
+	static WifiPowerMode xPowerMode;
+	static WifiPowerStats xPowerStats[WIFI_PM_MODES];
+	static uint64_t xMarkUs;
+	static netif_linkoutput_fn pLinkOutput;
+	static netif_input_fn pInput;
 
 };
 
@@ -1,8 +1,10 @@
 /**
  * Simple Hibernate and Recovery on a Raspberry PI Pico
  * LED is flashed on GPIO 2 while a wake
- * Connects to WIFI and prints IP Address
- * Will deinit the Wifi when sleeping
+ * Records the RTC temperature on every wake into a SampleBuffer
+ * Connects to WIFI and uplinks the batch when the UplinkPolicy is due,
+ * or every NET_EVERY wakes, syncing the clocks by SNTP when due
+ * CYW43Power powers the radio down when sleeping
  *
  * RTC DS3231 connected on I2C to GP12 & 13
  * RTC SQW used for interupt to wake on GP10
@@ -14,6 +16,12 @@
 #include <cstdio>
 #include "pico/cyw43_arch.h"
 #include "WifiHelper.h"
+#include "WifiCache.h"
+#include "CYW43Power.h"
+#include "SampleBuffer.h"
+#include "UplinkPolicy.h"
+#include "SNTPClient.h"
+#include "TelemetrySender.h"
 
 
 #define LED_PAD 2
@@ -23,39 +31,83 @@
 
 #define WAKE_PAD 10
 
+//Use the network on every Nth wake
+#define NET_EVERY 60
+
+//Flashes spent connected and idle after an uplink
+#define IDLE_FLASHES 10
+
+//Sample channel for RTC temperature in 1/100 C
+#define TEMP_CHANNEL 1
+
+CYW43Power radio(NET_EVERY);
+UplinkPolicy policy(15, 3600);
+SNTPClient sntp;
+TelemetrySender telemetry(TELEMETRY_HOST);
+
+//No network attempts before this epoch after the AP was unreachable
+uint32_t netHoldUntil = 0;
+
 
 void flash(uint count=1){
 	const uint LED_PIN = LED_PAD;
 
 	for (uint i=0; i < count; i++){
 		gpio_put(LED_PIN, 1);
-		cyw43_arch_poll();
+		if (radio.isUp()){
+			cyw43_arch_poll();
+		}
 		sleep_ms(DELAY);
 		gpio_put(LED_PIN, 0);
-		cyw43_arch_poll();
+		if (radio.isUp()){
+			cyw43_arch_poll();
+		}
 		sleep_ms(DELAY);
 	}
 }
 
-void wifiConnect(){
-	 //Connect to WIFI
-	if (WifiHelper::init()){
-		printf("Wifi Controller Initialised\n");
-	} else {
-		printf("Failed to initialise controller\n");
-		return ;
-	}
+bool wifiConnect(){
+#ifdef WIFI_STATIC_IP
+	WifiHelper::setStaticAddr(WIFI_STATIC_IP, WIFI_STATIC_MASK, WIFI_STATIC_GW);
+#endif
 	printf("Connecting to WiFi... %s \n", WIFI_SSID);
-	if (WifiHelper::join(WIFI_SSID, WIFI_PASSWORD)){
+	if (WifiHelper::rejoin(WIFI_SSID, WIFI_PASSWORD)){
 		printf("Connect to Wifi\n");
 	} else {
 		printf("Failed to connect to Wifi \n");
+		return false;
 	}
 
 	//Print IP Address
 	char ipStr[20];
 	WifiHelper::getIPAddressStr(ipStr);
 	printf("IP ADDRESS: %s\n", ipStr);
+	return true;
+}
+
+void netUse(DS3231 *rtc){
+	if (!radio.up()){
+		//AP unreachable, keep sampling but leave the radio off for a while
+		netHoldUntil = rtc->get_epoch() + WifiHelper::getOutageSleep() * 60;
+		printf("Network held for %u minutes\n", WifiHelper::getOutageSleep());
+		radio.down();
+		return;
+	}
+
+	flash(20);
+	if (sntp.isDue()){
+		sntp.sync();
+	}
+	SampleBuffer *buf = SampleBuffer::singleton();
+	WifiHelper::setPowerMode(WIFI_PM_PERFORMANCE);
+	printf("Uplink %u samples (%s)\n", buf->count(), policy.getReason());
+	telemetry.send(buf);
+
+	//Stay connected but idle for commands
+	WifiHelper::setPowerMode(WIFI_PM_AGGRESSIVE);
+	flash(IDLE_FLASHES);
+	WifiHelper::updateCache();
+	WifiHelper::printPowerStats();
 }
 
 
@@ -73,23 +125,26 @@ int main() {
     //Set up RTC and get time
     DS3231 rtc(i2c0,  SDA_PAD,  SCL_PAD);
     printf("RTC: %s\n", rtc.get_time_str());
+    SampleBuffer *samples = SampleBuffer::singleton();
+    samples->setRTC(&rtc);
+    sntp.setRTC(&rtc);
 
 
-    wifiConnect();
-    flash(20);
+    radio.setConnect(wifiConnect);
+    radio.setDown(WifiHelper::radioDown);
+    netUse(&rtc);
 
     //Drop into initial sleep for 1 minute
-    WifiHelper::deInit();
     Dormant *dormant = Dormant::singleton();
     dormant->setRTC(&rtc);
+    dormant->addObserver(WifiCache::singleton());
+    dormant->addObserver(&radio);
     printf("SLEEP\n");
     uart_default_tx_wait_blocking();
     dormant->sleep(1, WAKE_PAD);
 
 
     while (true) { // Loop forever
-    	 wifiConnect();
-
     	//Print GPIO of Wake Pin
     	uint8_t pad = gpio_get(WAKE_PAD);
 
@@ -99,10 +154,20 @@ int main() {
 
 		flash(5);
 
+		samples->add(TEMP_CHANNEL, (int32_t)(rtc.get_temp_f() * 100.0));
+
+		//Radio only powered on wakes that need it
+		uint32_t now = rtc.get_epoch();
+		if (policy.isDue(samples, now)){
+			radio.requestNetwork();
+		}
+		if (radio.isNetworkDue() && (now >= netHoldUntil)){
+			netUse(&rtc);
+		}
+
 		//Sleep again
 		printf("SLEEP\n");
 		uart_default_tx_wait_blocking();
-		WifiHelper::deInit();
 		dormant->sleep(1, WAKE_PAD);
 
     	sleep_ms(DELAY);
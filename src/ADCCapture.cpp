@@ -0,0 +1,223 @@
+/*
+ * ADCCapture.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "ADCCapture.h"
+#include "DeepSleep.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+ADCCapture * ADCCapture::pInstance = NULL;
+bool ADCCapture::xIRQAdded = false;
+
+ADCCapture::ADCCapture() {
+	// NOP
+}
+
+ADCCapture::~ADCCapture() {
+	stop();
+}
+
+bool ADCCapture::start(uint input, uint32_t rateHz){
+	DeepSleep *deepSleep = DeepSleep::singleton();
+
+	if (xRunning || (pInstance != NULL) || (rateHz == 0)){
+		return false;
+	}
+
+	xDMA[0] = dma_claim_unused_channel(false);
+	xDMA[1] = dma_claim_unused_channel(false);
+	if ((xDMA[0] < 0) || (xDMA[1] < 0)){
+		stop();
+		return false;
+	}
+
+	adc_init();
+	if (input < 4){
+		adc_gpio_init(26 + input);
+	}
+	adc_select_input(input);
+	//FIFO with DREQ on each sample, no error bit, full 12 bits
+	adc_fifo_setup(true, true, 1, false, false);
+	xRate = rateHz;
+	setDivider();
+
+	//Each half chains to the other so the capture never stops
+	for (uint i = 0; i < 2; i++){
+		dma_channel_config c = dma_channel_get_default_config(xDMA[i]);
+		channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+		channel_config_set_read_increment(&c, false);
+		channel_config_set_write_increment(&c, true);
+		channel_config_set_dreq(&c, DREQ_ADC);
+		channel_config_set_chain_to(&c, xDMA[i ^ 1]);
+		dma_channel_configure(xDMA[i], &c, xBuffer[i], &adc_hw->fifo,
+				ADC_CAPTURE_HALF, false);
+		dma_channel_set_irq0_enabled(xDMA[i], true);
+	}
+
+	pInstance = this;
+	xHalves = 0;
+	xReady = 0;
+	xNextTake = 0;
+	xCrossed = false;
+	if (!xIRQAdded){
+		irq_add_shared_handler(DMA_IRQ_0, ADCCapture::dmaIRQ,
+				PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+		irq_set_enabled(DMA_IRQ_0, true);
+		xIRQAdded = true;
+	}
+
+	deepSleep->enableADC();
+	deepSleep->enableDMA();
+	deepSleep->enableSRAM();
+	deepSleep->addObserver(this);
+
+	xRunning = true;
+	dma_channel_start(xDMA[0]);
+	adc_run(true);
+	return true;
+}
+
+void ADCCapture::stop(){
+	if (xRunning){
+		DeepSleep *deepSleep = DeepSleep::singleton();
+		adc_run(false);
+		deepSleep->delObserver(this);
+		deepSleep->disableADC();
+		deepSleep->disableDMA();
+		deepSleep->disableSRAM();
+	}
+	for (uint i = 0; i < 2; i++){
+		if (xDMA[i] >= 0){
+			dma_channel_set_irq0_enabled(xDMA[i], false);
+			dma_channel_abort(xDMA[i]);
+			dma_channel_acknowledge_irq0(xDMA[i]);
+			dma_channel_unclaim(xDMA[i]);
+			xDMA[i] = -1;
+		}
+	}
+	if (xRunning){
+		adc_fifo_drain();
+		pInstance = NULL;
+		xRunning = false;
+	}
+}
+
+void ADCCapture::setThreshold(uint16_t low, uint16_t high){
+	xLow = low;
+	xHigh = high;
+}
+
+void ADCCapture::setWakeHalves(uint halves){
+	xWakeHalves = halves;
+}
+
+const uint16_t * ADCCapture::takeHalf(){
+	uint32_t irq = save_and_disable_interrupts();
+	const uint16_t *half = NULL;
+
+	if (xReady & (1 << xNextTake)){
+		xReady = xReady & ~(1 << xNextTake);
+		half = xBuffer[xNextTake];
+		xNextTake = xNextTake ^ 1;
+	}
+	restore_interrupts(irq);
+	return half;
+}
+
+bool ADCCapture::takeThreshold(){
+	bool crossed = xCrossed;
+	xCrossed = false;
+	return crossed;
+}
+
+uint32_t ADCCapture::getOverruns(){
+	return xOverruns;
+}
+
+uint32_t ADCCapture::getRate(){
+	return xActualRate;
+}
+
+void ADCCapture::notifyClocksChanged(){
+	if (!xRunning){
+		return;
+	}
+	//Sleep stops clk_adc with the PLLs, so run it from the XOSC
+	if (clock_get_hz(clk_adc) == 0){
+		clock_configure(clk_adc,
+				0,
+				CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC,
+				XOSC_HZ,
+				XOSC_HZ);
+	}
+	setDivider();
+}
+
+void ADCCapture::setDivider(){
+	uint32_t hz = clock_get_hz(clk_adc);
+	float div = ((float)hz / (float)xRate) - 1.0;
+
+	if (div < (float)(ADC_CAPTURE_MIN_DIV - 1)){
+		div = 0.0;		// Back to back conversions
+	} else if (div > 65535.0){
+		div = 65535.0;
+	}
+	adc_set_clkdiv(div);
+
+	if (div == 0.0){
+		xActualRate = hz / ADC_CAPTURE_MIN_DIV;
+	} else {
+		xActualRate = (uint32_t)((float)hz / (div + 1.0));
+	}
+}
+
+void ADCCapture::halfDone(uint half){
+	//Rearm for when the other half chains back
+	dma_channel_set_write_addr(xDMA[half], xBuffer[half], false);
+
+	if (xReady & (1 << half)){
+		xOverruns = xOverruns + 1;
+	}
+	xReady = xReady | (1 << half);
+	xHalves = xHalves + 1;
+
+	bool crossed = false;
+	if ((xLow != 0) || (xHigh < 0x0FFF)){
+		const uint16_t *s = xBuffer[half];
+		for (uint i = 0; i < ADC_CAPTURE_HALF; i++){
+			if ((s[i] < xLow) || (s[i] > xHigh)){
+				crossed = true;
+				break;
+			}
+		}
+	}
+
+	if (crossed){
+		xCrossed = true;
+		DeepSleep::singleton()->wake();
+	} else if ((xWakeHalves != 0) && ((xHalves % xWakeHalves) == 0)){
+		DeepSleep::singleton()->wake();
+	} else {
+		DeepSleep::singleton()->sleepOn();
+	}
+}
+
+void ADCCapture::dmaIRQ(){
+	if (pInstance == NULL){
+		return;
+	}
+	for (uint i = 0; i < 2; i++){
+		uint ch = pInstance->xDMA[i];
+		if (dma_channel_get_irq0_status(ch)){
+			dma_channel_acknowledge_irq0(ch);
+			pInstance->halfDone(i);
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*
+ * ADCCapture.h
+ *
+ * Free running ADC sampled by DMA into two halves of a buffer while the
+ * core is in DeepSleep. Each half raises a DMA IRQ. The IRQ checks the
+ * half against the threshold window and only ends the sleep once the
+ * burst is captured or a sample is outside the window, otherwise the
+ * core goes straight back to sleep.
+ *
+ * For sleep clk_adc is run from the XOSC, as DeepSleep stops the PLLs,
+ * and the divider is rescaled on each clock change to keep the rate.
+ * Does not capture in Dormant.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_ADCCAPTURE_H_
+#define SRC_ADCCAPTURE_H_
+
+#include "pico/stdlib.h"
+#include "DormantNotification.h"
+
+//Samples in each half of the buffer
+#ifndef ADC_CAPTURE_HALF
+#define ADC_CAPTURE_HALF 256
+#endif
+
+//ADC takes 96 clk_adc cycles per conversion
+#define ADC_CAPTURE_MIN_DIV 96
+
+class ADCCapture : public DormantNotification {
+public:
+	ADCCapture();
+	virtual ~ADCCapture();
+
+	/***
+	 * Start capturing and keep ADC, DMA and SRAM clocked in DeepSleep
+	 * @param input - ADC input 0..3 for GPIO 26..29, 4 for temperature
+	 * @param rateHz - samples per second. Slowest is clk_adc / 65536,
+	 * 183Hz on the XOSC. Fastest is clk_adc / 96.
+	 * @return false if DMA channels are not available
+	 */
+	bool start(uint input, uint32_t rateHz);
+
+	/***
+	 * Stop capturing, release the DMA channels and the DeepSleep clocks
+	 */
+	void stop();
+
+	/***
+	 * End the sleep if a sample is outside this window.
+	 * Default is the full range, so never.
+	 * @param low - lowest sample allowed
+	 * @param high - highest sample allowed
+	 */
+	void setThreshold(uint16_t low, uint16_t high);
+
+	/***
+	 * End the sleep after this many halves have been captured
+	 * @param halves - 0 to wake only on threshold
+	 */
+	void setWakeHalves(uint halves);
+
+	/***
+	 * Take the oldest captured half not yet taken. Must be processed
+	 * before the DMA returns to it, one half period.
+	 * @return samples, ADC_CAPTURE_HALF long, or NULL if none
+	 */
+	const uint16_t * takeHalf();
+
+	/***
+	 * Did a sample leave the threshold window since last asked
+	 * @return true if crossed
+	 */
+	bool takeThreshold();
+
+	/***
+	 * Halves overwritten before they were taken
+	 * @return count
+	 */
+	uint32_t getOverruns();
+
+	/***
+	 * Rate actually set, limited by the divider
+	 * @return samples per second
+	 */
+	uint32_t getRate();
+
+	/***
+	 * Restart clk_adc from the XOSC if sleep stopped it and rescale
+	 * the divider for the new clock
+	 */
+	virtual void notifyClocksChanged();
+
+private:
+	/***
+	 * DMA IRQ for both halves
+	 */
+	static void dmaIRQ();
+
+	/***
+	 * Half completed, from IRQ
+	 * @param half
+	 */
+	void halfDone(uint half);
+
+	/***
+	 * Set the ADC divider for xRate from the current clk_adc
+	 */
+	void setDivider();
+
+	static ADCCapture * pInstance;
+	static bool xIRQAdded;
+
+	uint16_t xBuffer[2][ADC_CAPTURE_HALF];
+	int xDMA[2] = {-1, -1};
+	bool xRunning = false;
+	uint32_t xRate = 0;
+	uint32_t xActualRate = 0;
+	uint16_t xLow = 0;
+	uint16_t xHigh = 0xFFFF;
+	uint xWakeHalves = 1;
+	volatile uint xHalves = 0;
+	volatile uint8_t xReady = 0;	// Bit per half captured, not taken
+	uint xNextTake = 0;
+	volatile bool xCrossed = false;
+	volatile uint32_t xOverruns = 0;
+};
+
+#endif /* SRC_ADCCAPTURE_H_ */
@@ -0,0 +1,113 @@
+/*
+ * CYW43Power.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "CYW43Power.h"
+#include "pico/cyw43_arch.h"
+
+CYW43Power::CYW43Power(uint every) {
+	xEvery = every;
+}
+
+CYW43Power::~CYW43Power() {
+	down();
+}
+
+void CYW43Power::setCredentials(const char *ssid, const char *password, uint32_t auth){
+	pSSID = ssid;
+	pPassword = password;
+	xAuth = auth;
+}
+
+void CYW43Power::setConnect(CYW43ConnectFn fn){
+	pConnectFn = fn;
+}
+
+void CYW43Power::setDown(CYW43DownFn fn){
+	pDownFn = fn;
+}
+
+void CYW43Power::setConnectEvery(uint every){
+	xEvery = every;
+}
+
+bool CYW43Power::isNetworkDue(){
+	if (xRequested){
+		return true;
+	}
+	if (xEvery == 0){
+		return false;
+	}
+	return (xWakes % xEvery) == 0;
+}
+
+void CYW43Power::requestNetwork(){
+	xRequested = true;
+}
+
+bool CYW43Power::up(){
+	if (!xInit){
+		if (cyw43_arch_init() != 0){
+			return false;
+		}
+		xInit = true;
+		xPowerUps++;
+		cyw43_arch_enable_sta_mode();
+	}
+	if (!xJoined){
+		if (pConnectFn != NULL){
+			xJoined = pConnectFn();
+		} else {
+			xJoined = connect();
+		}
+	}
+	return xJoined;
+}
+
+void CYW43Power::down(){
+	if (xInit){
+		if (pDownFn != NULL){
+			pDownFn();
+		}
+		cyw43_arch_deinit();
+	}
+	xInit = false;
+	xJoined = false;
+}
+
+bool CYW43Power::isUp(){
+	return xInit;
+}
+
+uint32_t CYW43Power::getWakes(){
+	return xWakes;
+}
+
+uint32_t CYW43Power::getPowerUps(){
+	return xPowerUps;
+}
+
+void CYW43Power::notifyDormant(uint minutes){
+	down();
+	xRequested = false;
+}
+
+void CYW43Power::notifyWake(uint minutes){
+	xWakes++;
+}
+
+bool CYW43Power::connect(){
+	if (pSSID == NULL){
+		return false;
+	}
+	uint32_t auth = xAuth;
+	if (auth == 0){
+		auth = CYW43_AUTH_WPA2_AES_PSK;
+	}
+	int r = cyw43_arch_wifi_connect_timeout_ms(
+			pSSID, pPassword, auth, CYW43_POWER_CONNECT_TIMEOUT);
+	return (r == 0);
+}
@@ -0,0 +1,144 @@
+/*
+ * CYW43Power.h
+ *
+ * Dormant observer that manages the CYW43 radio around sleeps.
+ * Powers the radio down before each sleep and only brings it back up
+ * when the application first asks for the network, so sample only
+ * wakes never touch the radio. The network can be marked as due every
+ * Nth wake.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_CYW43POWER_H_
+#define SRC_CYW43POWER_H_
+
+#include "pico/stdlib.h"
+#include "DormantNotification.h"
+
+#ifndef CYW43_POWER_CONNECT_TIMEOUT
+#define CYW43_POWER_CONNECT_TIMEOUT 30000
+#endif
+
+/***
+ * Connect function, called with the radio initialised
+ * @return true if joined
+ */
+typedef bool (*CYW43ConnectFn)(void);
+
+/***
+ * Called before the radio is de-initialised
+ */
+typedef void (*CYW43DownFn)(void);
+
+class CYW43Power : public DormantNotification {
+public:
+	/***
+	 * Constructor
+	 * @param every - network is due every Nth wake, 1 for every wake
+	 */
+	CYW43Power(uint every = 1);
+	virtual ~CYW43Power();
+
+	/***
+	 * Credentials used by the default connect
+	 * @param ssid
+	 * @param password
+	 * @param auth - CYW43 auth type, 0 selects WPA2 AES PSK
+	 */
+	void setCredentials(const char *ssid, const char *password, uint32_t auth = 0);
+
+	/***
+	 * Replace the default connect, for example to rejoin from a cache
+	 * @param fn - connect function, NULL for default
+	 */
+	void setConnect(CYW43ConnectFn fn);
+
+	/***
+	 * Tell the network code the radio is going down, for example to
+	 * stop timing it
+	 * @param fn - NULL for none
+	 */
+	void setDown(CYW43DownFn fn);
+
+	/***
+	 * Set how often the network is due
+	 * @param every - every Nth wake, 0 never
+	 */
+	void setConnectEvery(uint every);
+
+	/***
+	 * Does this wake need the network
+	 * @return true if due or requested
+	 */
+	bool isNetworkDue();
+
+	/***
+	 * Mark the network as needed for this wake, e.g. on an alert
+	 */
+	void requestNetwork();
+
+	/***
+	 * Bring the radio up and join if not already. Safe to call often.
+	 * @return true if joined
+	 */
+	bool up();
+
+	/***
+	 * Power the radio down
+	 */
+	void down();
+
+	/***
+	 * Is the radio initialised
+	 * @return
+	 */
+	bool isUp();
+
+	/***
+	 * Number of wakes seen
+	 * @return
+	 */
+	uint32_t getWakes();
+
+	/***
+	 * Number of times radio was powered up
+	 * @return
+	 */
+	uint32_t getPowerUps();
+
+	/***
+	 * Radio powered down before sleeping
+	 * @param minutes
+	 */
+	virtual void notifyDormant(uint minutes);
+
+	/***
+	 * Count the wake, radio stays down until up is called
+	 * @param minutes
+	 */
+	virtual void notifyWake(uint minutes);
+
+private:
+	/***
+	 * Default connect using the credentials
+	 * @return true if joined
+	 */
+	bool connect();
+
+	const char *pSSID = NULL;
+	const char *pPassword = NULL;
+	uint32_t xAuth = 0;
+	CYW43ConnectFn pConnectFn = NULL;
+	CYW43DownFn pDownFn = NULL;
+
+	uint xEvery = 1;
+	uint32_t xWakes = 0;
+	uint32_t xPowerUps = 0;
+	bool xRequested = false;
+	bool xInit = false;
+	bool xJoined = false;
+};
+
+#endif /* SRC_CYW43POWER_H_ */
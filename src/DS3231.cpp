@@ -117,34 +117,215 @@
 
 #define ASCII_OFFSET        48
 
-DS3231::DS3231(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin){
-	init(i2c,  sdaPin,  sclPin);
+DS3231::DS3231(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin, uint baud){
+	init(i2c,  sdaPin,  sclPin, baud);
 }
 
 DS3231::DS3231(){
-	init(i2c_default, PICO_DEFAULT_I2C_SDA_PIN , PICO_DEFAULT_I2C_SCL_PIN );
+	init(i2c_default, PICO_DEFAULT_I2C_SDA_PIN , PICO_DEFAULT_I2C_SCL_PIN,
+			DS3231_DEFAULT_BAUD);
 
 }
 
-void DS3231::init(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin){
+DS3231::DS3231(I2CBus *bus, uint baud){
+	_bus = bus;
+	_i2c = bus->getI2C();
+	_baud = baud;
+	_config_baud = baud;
+	_bus->init();
+}
+
+void DS3231::init(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin, uint baud){
 	_i2c = i2c;
-    i2c_init(_i2c, 400000);
+	_baud = baud;
+	_config_baud = baud;
+    i2c_init(_i2c, _baud);
     gpio_set_function(sdaPin, GPIO_FUNC_I2C);
     gpio_set_function(sclPin, GPIO_FUNC_I2C);
     gpio_pull_up(sdaPin);
     gpio_pull_up(sclPin);
     _sdaGP = sdaPin;
-    _sclGP = sdaPin;
+    _sclGP = sclPin;
+}
+
+int DS3231::_i2c_write(const uint8_t *src, size_t len)
+{
+    return _i2c_xfer(src, len, NULL, 0);
+}
+
+int DS3231::_i2c_write_read(const uint8_t *tx, size_t tx_len,
+                            uint8_t *rx, size_t rx_len)
+{
+    return _i2c_xfer(tx, tx_len, rx, rx_len);
+}
+
+int DS3231::_i2c_xfer(const uint8_t *tx, size_t tx_len,
+                      uint8_t *rx, size_t rx_len)
+{
+    int res;
+    uint32_t start;
+    uint32_t us;
+    uint nacks = 0;
+    uint slow = 0;
+
+    //Try the set speed again now and then, the fallback holds otherwise
+    if (_baud != _config_baud && _since_fallback >= DS3231_REPROBE_XFERS) {
+        _since_fallback = 0;
+        slow = _baud;
+        _apply_baud(_config_baud);
+    }
+
+    for (;;) {
+        start = time_us_32();
+        if (_bus != NULL) {
+            res = _bus->writeRead(DS3231_ADDR, tx, tx_len, rx, rx_len, _baud);
+        } else {
+            res = i2c_write_timeout_us(_i2c, DS3231_ADDR, tx, tx_len,
+                    (rx_len > 0), DS3231_I2C_TIMEOUT_US);
+            if (res >= 0 && rx_len > 0)
+                res = i2c_read_timeout_us(_i2c, DS3231_ADDR, rx, rx_len,
+                        false, DS3231_I2C_TIMEOUT_US);
+        }
+        us = time_us_32() - start;
+
+        _timing.transactions++;
+        _timing.total_us += us;
+        if (us > _timing.max_us)
+            _timing.max_us = us;
+        if (_trace != NULL)
+            _trace->record(DS3231_ADDR, tx, tx_len, rx, rx_len, res, start, us);
+
+        if (res != PICO_ERROR_GENERIC)
+            break;
+        _timing.failed++;
+        //Repeated NACKs may be the device not keeping up, retry slower.
+        //An unpowered device NACKs at any speed
+        if (!_powered)
+            break;
+        if (slow != 0) {
+            //Set speed still fails, straight back to the fallback
+            _apply_baud(slow);
+            slow = 0;
+            continue;
+        }
+        if (++nacks < DS3231_NACK_RETRIES)
+            continue;
+        if (!_fallback_baud())
+            break;
+        nacks = 0;
+    }
+
+    if (res >= 0 && _baud != _config_baud)
+        _since_fallback++;
+
+    if (res < 0) {
+        _errors++;
+        _last_error = res;
+    }
+    return res;
+}
+
+int DS3231::get_last_error()
+{
+    return _last_error;
+}
+
+uint32_t DS3231::get_error_count()
+{
+    return _errors;
+}
+
+void DS3231::clear_errors()
+{
+    _errors = 0;
+    _last_error = PICO_OK;
+}
+
+bool DS3231::_fallback_baud()
+{
+    uint baud = get_baud();
+
+    if (!_fallback)
+        return false;
+
+    if (baud > DS3231_DEFAULT_BAUD)
+        baud = DS3231_DEFAULT_BAUD;
+    else if (baud > DS3231_SLOW_BAUD)
+        baud = DS3231_SLOW_BAUD;
+    else
+        return false;
+
+    _timing.fallbacks++;
+    _since_fallback = 0;
+    _apply_baud(baud);
+    return true;
+}
+
+void DS3231::_apply_baud(uint baud)
+{
+    _baud = baud;
+    //On a shared bus the speed is switched per transaction
+    if (_bus == NULL)
+        i2c_set_baudrate(_i2c, _baud);
+}
+
+void DS3231::set_baud(uint baud, bool fallback)
+{
+    _config_baud = baud;
+    _fallback = fallback;
+    _since_fallback = 0;
+    _apply_baud(baud);
+}
+
+uint DS3231::get_baud()
+{
+    if (_baud == 0 && _bus != NULL)
+        return _bus->getBaud();
+    return _baud;
+}
+
+const DS3231_timing * DS3231::get_timing()
+{
+    return &_timing;
+}
+
+void DS3231::reset_timing()
+{
+    _timing.transactions = 0;
+    _timing.total_us = 0;
+    _timing.max_us = 0;
+    _timing.fallbacks = 0;
+    _timing.failed = 0;
+}
+
+void DS3231::print_timing()
+{
+    uint32_t avg = 0;
+
+    if (_timing.transactions > 0)
+        avg = _timing.total_us / _timing.transactions;
+    printf("DS3231 %u baud: %lu trans, %lu us total, %lu avg, %lu max, %lu fallback, %lu failed\n",
+            get_baud(),
+            (unsigned long)_timing.transactions,
+            (unsigned long)_timing.total_us,
+            (unsigned long)avg,
+            (unsigned long)_timing.max_us,
+            (unsigned long)_timing.fallbacks,
+            (unsigned long)_timing.failed);
+}
+
+void DS3231::set_trace(I2CTrace *trace)
+{
+    _trace = trace;
 }
 
-void DS3231::_read_data_reg(uint8_t reg, uint8_t n_regs)
+bool DS3231::_read_data_reg(uint8_t reg, uint8_t n_regs)
 {
     _data_buffer[0] = reg;
-    i2c_write_blocking(_i2c, DS3231_ADDR, _data_buffer, 1, true);
-    i2c_read_blocking(_i2c, DS3231_ADDR, _data_buffer + reg + 1, n_regs, false);
+    return (_i2c_write_read(_data_buffer, 1, _data_buffer + reg + 1, n_regs) >= 0);
 }
 
-void DS3231::_write_data_reg(uint8_t reg, uint8_t n_regs)
+bool DS3231::_write_data_reg(uint8_t reg, uint8_t n_regs)
 {
     uint8_t buffer[8];
 
@@ -153,7 +334,7 @@ void DS3231::_write_data_reg(uint8_t reg, uint8_t n_regs)
         buffer[i] = _data_buffer[reg + i];
     }
 
-    i2c_write_blocking(_i2c, DS3231_ADDR, buffer, n_regs + 1, false);
+    return (_i2c_write(buffer, n_regs + 1) >= 0);
 }
 
 inline void DS3231::_format_time_string()
@@ -270,8 +451,7 @@ uint8_t DS3231::get_temp()
     uint8_t frac;
 
     _data_buffer[0] = DS3231_MSB_TMP_REG;
-    i2c_write_blocking(_i2c, DS3231_ADDR, _data_buffer, 1, true);
-    i2c_read_blocking(_i2c, DS3231_ADDR, &temp, 1, false);
+    _i2c_write_read(_data_buffer, 1, &temp, 1);
 
     return temp;
 }
@@ -279,16 +459,13 @@ uint8_t DS3231::get_temp()
 float DS3231::get_temp_f(){
 	uint8_t temp;
 	uint8_t frac;
+	uint8_t regs[2];
 
+	//MSB and LSB are adjacent so read both in one transaction
 	_data_buffer[0] = DS3231_MSB_TMP_REG;
-	i2c_write_blocking(_i2c, DS3231_ADDR, _data_buffer, 1, true);
-	i2c_read_blocking(_i2c, DS3231_ADDR, &temp, 1, false);
-
-	_data_buffer[0] = DS3231_LSB_TMP_REG;
-	i2c_write_blocking(_i2c, DS3231_ADDR, _data_buffer, 1, true);
-	i2c_read_blocking(_i2c, DS3231_ADDR, &frac, 1, false);
-
-	frac = frac >> 6;
+	_i2c_write_read(_data_buffer, 1, regs, 2);
+	temp = regs[0];
+	frac = regs[1] >> 6;
 
 	return ((float)temp + (0.25 * (float)frac));
 
@@ -329,45 +506,45 @@ const char* DS3231::get_time_str()
     return _time_str_buffer;
 }
 
-void DS3231::set_hou(uint8_t hou, bool am_pm_format, bool is_pm)
+bool DS3231::set_hou(uint8_t hou, bool am_pm_format, bool is_pm)
 {
     if (am_pm_format && (hou < 1 || hou > 12) ||
         hou > 23)
-        return;
+        return false;
 
     ENCODE_HOU(hou, am_pm_format, is_pm);
-    WRITE_HOU_DATA();
+    return WRITE_HOU_DATA();
 }
 
-void DS3231::set_min(uint8_t min)
+bool DS3231::set_min(uint8_t min)
 {
     if (min > 59)
-        return;
+        return false;
 
     ENCODE_MIN(min);
-    WRITE_MIN_DATA();
+    return WRITE_MIN_DATA();
 }
 
-void DS3231::set_sec(uint8_t sec)
+bool DS3231::set_sec(uint8_t sec)
 {
     if (sec > 59)
-        return;
+        return false;
 
     ENCODE_SEC(sec);
-    WRITE_SEC_DATA();
+    return WRITE_SEC_DATA();
 }
 
-void DS3231::set_time(uint8_t hou, uint8_t min, uint8_t sec,
+bool DS3231::set_time(uint8_t hou, uint8_t min, uint8_t sec,
                             bool am_pm_format, bool is_pm)
 {
     if (am_pm_format && (hou < 1 || hou > 12) ||
         hou > 23 || min > 59 || sec > 59)
-        return;
+        return false;
 
     ENCODE_HOU(hou, am_pm_format, is_pm);
     ENCODE_MIN(min);
     ENCODE_SEC(sec);
-    WRITE_TIME_DATA();
+    return WRITE_TIME_DATA();
 }
 
 uint8_t DS3231::get_day()
@@ -405,53 +582,91 @@ const char* DS3231::get_date_str()
     return _date_str_buffer;
 }
 
-void DS3231::set_day(uint8_t day)
+uint32_t DS3231::get_epoch()
+{
+    int y;
+    uint32_t m;
+    uint32_t days;
+    uint32_t hou;
+
+    if (!_read_data_reg(DS3231_SEC_REG, DS3231_NO_DATA_REG))
+        return 0;
+    DECODE_SEC();
+    DECODE_MIN();
+    DECODE_HOU();
+    DECODE_DAY();
+    DECODE_YEAR();
+    //Century bit shares the month register
+    _mon = _decode_gen(_data_buffer[DATA_MON] & 0x1F);
+
+    hou = _hou;
+    if (_12_format) {
+        hou = hou % 12;
+        if (_is_pm)
+            hou += 12;
+    }
+
+    //Days since 1970 from the civil date, years run from March
+    y = _year;
+    m = _mon;
+    if (m <= 2)
+        y--;
+    m = (m > 2) ? m - 3 : m + 9;
+    days = (uint32_t)(y * 365 + y / 4 - y / 100 + y / 400) +
+           (153 * m + 2) / 5 + _day - 1 - 719468;
+
+    return days * 86400 + hou * 3600 + _min * 60 + _sec;
+}
+
+bool DS3231::set_day(uint8_t day)
 {
     if (day < 1 || day > 31)
-        return;
+        return false;
 
     ENCODE_DAY(day);
-    WRITE_DAY_DATA();
+    return WRITE_DAY_DATA();
 }
 
-void DS3231::set_mon(uint8_t mon)
+bool DS3231::set_mon(uint8_t mon)
 {
     if (mon < 1 || mon > 12)
-        return;
+        return false;
 
     ENCODE_MON(mon);
-    WRITE_MON_DATA();
+    return WRITE_MON_DATA();
 }
 
-void DS3231::set_year(int year)
+bool DS3231::set_year(int year)
 {
     if (year < 2000 || year > 2099)
-        return;
+        return false;
 
     ENCODE_YEAR(year - 2000);
-    WRITE_YEAR_DATA();
+    return WRITE_YEAR_DATA();
 }
 
-void DS3231::set_date(uint8_t day, uint8_t mon, int year)
+bool DS3231::set_date(uint8_t day, uint8_t mon, int year)
 {
     if (day < 1 || day > 31 ||
         mon < 1 || mon > 12 ||
         year < 2000 || year > 2099)
-        return;
+        return false;
 
     ENCODE_DAY(day);
     ENCODE_MON(mon);
     ENCODE_YEAR(year - 2000);
-    WRITE_DATE_DATA();
+    return WRITE_DATE_DATA();
 }
 
-void DS3231::set_delay(uint sleep_mins)
+bool DS3231::set_delay(uint sleep_mins)
 {
+	uint32_t errors = _errors;
 	uint8_t wakeup_min;
 	uint8_t reg;
 	uint8_t send_t[3];
 
-	send_t[0] = 0;
+	//Clear flags but leave the 32kHz output as configured
+	send_t[0] = get_addr(DS3231_STATUS_ADDR) & DS3231_STATUS_EN32KHZ;
     reg = DS3231_STATUS_ADDR;
 	write_bytes(reg, send_t, 1);
 
@@ -460,17 +675,16 @@ void DS3231::set_delay(uint sleep_mins)
     write_bytes(reg, send_t, 1);
 
 
+	uint8_t now_min;
+
 	//wakeup_min = (get_min() / sleep_mins + 1) * sleep_mins;
-    wakeup_min = get_min() + sleep_mins ;
+    now_min = get_min();
+    wakeup_min = now_min + sleep_mins ;
 	if (wakeup_min > 59) {
 		//wakeup_min -= 60;
 		wakeup_min = wakeup_min % 60;
 	}
 
-	//DEBUG
-	printf("RTC %d Wake %d\n", get_min(), wakeup_min);
-	uart_default_tx_wait_blocking();
-
 
 	 uint8_t t[3] = { wakeup_min, 0,  0 };
 	 uint8_t i;
@@ -490,31 +704,67 @@ void DS3231::set_delay(uint sleep_mins)
 	 reg = DS3231_CONTROL_ADDR;
 	 write_bytes(reg, send_t, 1);
 
+	 //Any failure means the alarm may not be armed
+	 return (_errors == errors);
+
 }
 
-void DS3231::clear_alarm(void){
+bool DS3231::clear_alarm(void){
     uint8_t reg_val;
+    uint32_t errors = _errors;
 
     reg_val = get_addr(DS3231_STATUS_ADDR) & ~DS3231_STATUS_A2F;
-    set_addr(DS3231_STATUS_ADDR,  reg_val);
+    if (_errors != errors)
+        return false;
+    return set_addr(DS3231_STATUS_ADDR,  reg_val);
 }
 
-uint8_t DS3231::get_addr(const uint8_t addr){
-    uint8_t rv;
+bool DS3231::set_sqw(DS3231_SQW rate, bool battery){
+    uint8_t reg_val = 0;
+
+    if (rate & 0x1)
+        reg_val |= DS3231_CONTROL_RS1;
+    if (rate & 0x2)
+        reg_val |= DS3231_CONTROL_RS2;
+    if (battery)
+        reg_val |= DS3231_CONTROL_BBSQW;
 
-    i2c_write_blocking(_i2c, DS3231_ADDR, &addr, 1, true);
+    //INTCN clear routes the oscillator to the pin, alarm interrupts are off
+    return set_addr(DS3231_CONTROL_ADDR, reg_val);
+}
+
+bool DS3231::clear_sqw(){
+    return set_addr(DS3231_CONTROL_ADDR, DS3231_CONTROL_INTCN);
+}
+
+bool DS3231::set_32khz(bool on){
+    uint8_t reg_val;
+    uint32_t errors = _errors;
+
+    //Keep alarm flags as they are, OSF cleared
+    reg_val = get_addr(DS3231_STATUS_ADDR) &
+    		(DS3231_STATUS_A1F | DS3231_STATUS_A2F);
+    if (_errors != errors)
+        return false;
+    if (on)
+        reg_val |= DS3231_STATUS_EN32KHZ;
+    return set_addr(DS3231_STATUS_ADDR,  reg_val);
+}
+
+uint8_t DS3231::get_addr(const uint8_t addr){
+    uint8_t rv = 0;
 
-    i2c_read_blocking(_i2c, DS3231_ADDR, &rv, 1, false);
+    _i2c_write_read(&addr, 1, &rv, 1);
 
     return rv;
 }
 
-void DS3231::set_addr(const uint8_t addr, const uint8_t val){
-    write_bytes(addr, (uint8_t*) &val, 1);
+bool DS3231::set_addr(const uint8_t addr, const uint8_t val){
+    return write_bytes(addr, (uint8_t*) &val, 1);
 }
 
 
-void DS3231::write_bytes(uint8_t reg, uint8_t *buf, int len) {
+bool DS3231::write_bytes(uint8_t reg, uint8_t *buf, int len) {
     uint8_t buffer[len + 1];
 
    //printf("Write %X, ", reg);
@@ -524,11 +774,11 @@ void DS3231::write_bytes(uint8_t reg, uint8_t *buf, int len) {
       //printf("%X, ",  buffer[x + 1]);
     }
     //printf("\n");
-    i2c_write_blocking(_i2c,DS3231_ADDR, buffer, len + 1, false);
+    return (_i2c_write(buffer, len + 1) >= 0);
 };
 
 void DS3231::set_power_gp(uint8_t gp){
-	 _pwrGP = _pwrGP;
+	 _pwrGP = gp;
 	 gpio_init(_pwrGP);
 	 gpio_set_dir(_pwrGP, GPIO_OUT);
 	 gpio_put(_pwrGP, true);
@@ -539,6 +789,7 @@ void	DS3231::on(){
 	if (_pwrGP <= 28){
 		gpio_put(_pwrGP, true);
 	}
+	_powered = true;
 	if (_sdaGP <= 28){
 		gpio_pull_up(_sdaGP);
 	}
@@ -550,6 +801,7 @@ void	DS3231::on(){
 void	DS3231::off(){
 	if (_pwrGP <= 28){
 		gpio_put(_pwrGP, false);
+		_powered = false;
 	}
 	if (_sdaGP <= 28){
 		gpio_disable_pulls(_sdaGP);
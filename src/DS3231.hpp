@@ -13,6 +13,58 @@
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "I2CBus.h"
+#include "I2CTrace.h"
+
+#ifndef DS3231_DEFAULT_BAUD
+#define DS3231_DEFAULT_BAUD     400000
+#endif
+#define DS3231_FMPLUS_BAUD      1000000
+#define DS3231_SLOW_BAUD        100000
+
+/*
+ * Bound on each I2C transfer so a missing or unpowered device
+ * cannot hang the caller
+ */
+#ifndef DS3231_I2C_TIMEOUT_US
+#define DS3231_I2C_TIMEOUT_US   10000
+#endif
+
+/*
+ * NACKs in a row at one speed before falling back to a slower one
+ */
+#ifndef DS3231_NACK_RETRIES
+#define DS3231_NACK_RETRIES     3
+#endif
+
+/*
+ * Successful transactions at a fallback speed before the set speed is
+ * tried again. A single NACK ends the try
+ */
+#ifndef DS3231_REPROBE_XFERS
+#define DS3231_REPROBE_XFERS    64
+#endif
+
+/*
+ * Transaction timing, all I2C accesses since last reset
+ */
+struct DS3231_timing {
+    uint32_t            transactions;
+    uint32_t            total_us;
+    uint32_t            max_us;
+    uint32_t            fallbacks;
+    uint32_t            failed;
+};
+
+/*
+ * Square-wave output rates on the INT/SQW pin (RS2:RS1)
+ */
+enum DS3231_SQW {
+    DS3231_SQW_1HZ      = 0,
+    DS3231_SQW_1024HZ   = 1,
+    DS3231_SQW_4096HZ   = 2,
+    DS3231_SQW_8192HZ   = 3
+};
 
 class DS3231 {
 private:
@@ -31,12 +83,29 @@ private:
     char                _date_str_buffer[11];
 
     i2c_inst_t *		_i2c;
+    I2CBus *			_bus = NULL;
+    uint				_baud = 0;
+    uint				_config_baud = 0;
+    bool				_fallback = true;
+    bool				_powered = true;
+    uint32_t			_since_fallback = 0;
+    DS3231_timing		_timing = {0, 0, 0, 0, 0};
+    I2CTrace *			_trace = NULL;
+    uint32_t			_errors = 0;
+    int					_last_error = PICO_OK;
     uint8_t				_sdaGP =0xFF;
     uint8_t				_sclGP =0xFF;
     uint8_t				_pwrGP =0xFF;
 
-    void                _read_data_reg(uint8_t reg, uint8_t n_regs);
-    void                _write_data_reg(uint8_t reg, uint8_t n_regs);
+    int                 _i2c_write(const uint8_t *src, size_t len);
+    int                 _i2c_write_read(const uint8_t *tx, size_t tx_len,
+                                        uint8_t *rx, size_t rx_len);
+    int                 _i2c_xfer(const uint8_t *tx, size_t tx_len,
+                                  uint8_t *rx, size_t rx_len);
+    bool                _fallback_baud();
+    void                _apply_baud(uint baud);
+    bool                _read_data_reg(uint8_t reg, uint8_t n_regs);
+    bool                _write_data_reg(uint8_t reg, uint8_t n_regs);
 
     void                _format_time_string();
     void                _format_date_string();
@@ -47,15 +116,77 @@ private:
     uint8_t             _encode_gen(uint8_t data);
     uint8_t             _encode_hou(uint8_t hou, bool am_pm_format, bool is_pm);
 
-    void				init(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin);
+    void				init(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin, uint baud);
 
-    void 				write_bytes(uint8_t reg, uint8_t *buf, int len);
+    bool 				write_bytes(uint8_t reg, uint8_t *buf, int len);
     uint8_t 			get_addr(const uint8_t addr);
-    void 				set_addr(const uint8_t addr, const uint8_t val);
+    bool 				set_addr(const uint8_t addr, const uint8_t val);
 
 public:
     DS3231();
-    DS3231(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin);
+
+    /***
+     * Constructor owning the I2C controller
+     * @param i2c - I2C controller
+     * @param sdaPin
+     * @param sclPin
+     * @param baud - bus speed, DS3231_FMPLUS_BAUD for 1MHz Fast-mode Plus
+     */
+    DS3231(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin,
+           uint baud = DS3231_DEFAULT_BAUD);
+
+    /***
+     * Attach to a shared I2C bus. The bus is only initialised if no
+     * other device has done so, and each access locks the bus.
+     * on/off only switch power, the bus pull ups are left alone.
+     * @param bus
+     * @param baud - speed for the DS3231, 0 for bus default
+     */
+    DS3231(I2CBus *bus, uint baud = 0);
+
+    /***
+     * Set the bus speed.
+     * With fallback DS3231_NACK_RETRIES NACKs in a row drop the speed
+     * to 400kHz then 100kHz and the transaction is retried. The lower
+     * speed is kept, the set speed being tried again after every
+     * DS3231_REPROBE_XFERS successful transactions.
+     * @param baud
+     * @param fallback - allow fallback to lower speed
+     */
+    void				set_baud(uint baud, bool fallback=true);
+
+    /***
+     * Get the bus speed in use, which may be a fallback speed
+     * @return baud
+     */
+    uint				get_baud();
+
+    /***
+     * Timing of I2C transactions since last reset
+     * @return timing
+     */
+    const DS3231_timing * get_timing();
+    void				reset_timing();
+
+    /***
+     * Print a one line timing report
+     */
+    void				print_timing();
+
+    /***
+     * Record every I2C transaction into a trace
+     * @param trace - NULL to stop tracing
+     */
+    void				set_trace(I2CTrace *trace);
+
+    /***
+     * I2C errors. Getters return stale values after an error and
+     * setters return false.
+     * @return last PICO_ERROR code, PICO_OK if none
+     */
+    int					get_last_error();
+    uint32_t			get_error_count();
+    void				clear_errors();
 
     uint8_t             get_temp();
     float				get_temp_f();
@@ -65,10 +196,10 @@ public:
     uint8_t             get_sec();
     const char*         get_time_str();
 
-    void                set_sec(uint8_t sec);
-    void                set_min(uint8_t min);
-    void                set_hou(uint8_t hou, bool am_pm_format, bool is_pm);
-    void                set_time(uint8_t hou, uint8_t min, uint8_t sec,
+    bool                set_sec(uint8_t sec);
+    bool                set_min(uint8_t min);
+    bool                set_hou(uint8_t hou, bool am_pm_format, bool is_pm);
+    bool                set_time(uint8_t hou, uint8_t min, uint8_t sec,
                                  bool am_pm_format, bool is_pm);
 
     uint8_t             get_day();
@@ -76,13 +207,45 @@ public:
     int                 get_year();
     const char*         get_date_str();
 
-    void                set_day(uint8_t day);
-    void                set_mon(uint8_t mon);
-    void                set_year(int year);
-    void                set_date(uint8_t day, uint8_t mon, int year);
-
-    void 				set_delay(uint sleep_mins);
-    void 				clear_alarm(void);
+    bool                set_day(uint8_t day);
+    bool                set_mon(uint8_t mon);
+    bool                set_year(int year);
+    bool                set_date(uint8_t day, uint8_t mon, int year);
+
+    /***
+     * Read time and date in one transaction as seconds since 1970 UTC
+     * @return epoch, 0 if the I2C read failed
+     */
+    uint32_t            get_epoch();
+
+    /***
+     * Arm alarm 2 on INT/SQW for sleep_mins ahead
+     * @param sleep_mins
+     * @return false if any I2C access failed, alarm may not be armed
+     */
+    bool 				set_delay(uint sleep_mins);
+    bool 				clear_alarm(void);
+
+    /***
+     * Drive INT/SQW with a square wave instead of the alarm interrupt.
+     * Any following set_delay returns the pin to alarm mode.
+     * @param rate - output frequency
+     * @param battery - keep running when on battery backup (BBSQW)
+     */
+    bool				set_sqw(DS3231_SQW rate, bool battery=false);
+
+    /***
+     * Stop the square wave and return INT/SQW to alarm interrupt mode
+     */
+    bool				clear_sqw();
+
+    /***
+     * Enable or disable the 32.768kHz output pin.
+     * Left untouched by set_delay, so can clock the RP2040 RTC while
+     * the alarm is armed.
+     * @param on
+     */
+    bool				set_32khz(bool on=true);
     void				set_power_gp(uint8_t gp);
     void				on();
     void				off();
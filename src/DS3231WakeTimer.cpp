@@ -0,0 +1,81 @@
+/*
+ * DS3231WakeTimer.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "DS3231WakeTimer.h"
+
+DS3231WakeTimer::DS3231WakeTimer(DS3231 *rtc) {
+	pRTC = rtc;
+}
+
+DS3231WakeTimer::~DS3231WakeTimer() {
+	// NOP
+}
+
+void DS3231WakeTimer::setRTC(DS3231 *rtc){
+	pRTC = rtc;
+}
+
+DS3231 * DS3231WakeTimer::getRTC(){
+	return pRTC;
+}
+
+void DS3231WakeTimer::setPowerDown(bool on){
+	xPowerDown = on;
+}
+
+void DS3231WakeTimer::setWakePad(uint8_t pad){
+	xWakePad = pad;
+}
+
+bool DS3231WakeTimer::needsWakePad(){
+	//Alarm only asserts INT/SQW
+	return true;
+}
+
+uint8_t DS3231WakeTimer::getWakePad(){
+	return xWakePad;
+}
+
+bool DS3231WakeTimer::setAlarm(uint32_t minutes, WakeTimerCallback cb){
+	if (pRTC == NULL){
+		return false;
+	}
+	//Any I2C failure means the alarm may never fire
+	if (!pRTC->clear_alarm()){
+		return false;
+	}
+	return pRTC->set_delay(minutes);
+}
+
+void DS3231WakeTimer::clearAlarm(){
+	if (pRTC != NULL){
+		pRTC->clear_alarm();
+	}
+}
+
+bool DS3231WakeTimer::canWakeDormant(){
+	return (pRTC != NULL);
+}
+
+void DS3231WakeTimer::sleepPrepare(){
+	if ((pRTC != NULL) && xPowerDown){
+		pRTC->off();
+	}
+}
+
+uint32_t DS3231WakeTimer::getEpoch(){
+	if (pRTC == NULL){
+		return 0;
+	}
+	return pRTC->get_epoch();
+}
+
+void DS3231WakeTimer::wakeRecover(){
+	if ((pRTC != NULL) && xPowerDown){
+		pRTC->on();
+	}
+}
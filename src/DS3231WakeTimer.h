@@ -0,0 +1,72 @@
+/*
+ * DS3231WakeTimer.h
+ *
+ * Wake Timer using the DS3231 alarm 2 on the SQW pin.
+ * SQW must be wired to the wake pad given to the sleep call.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_DS3231WAKETIMER_H_
+#define SRC_DS3231WAKETIMER_H_
+
+#include "WakeTimer.h"
+#include "DS3231.hpp"
+
+class DS3231WakeTimer : public WakeTimer {
+public:
+	/***
+	 * Constructor
+	 * @param rtc - DS3231 object. Can be NULL and set later
+	 */
+	DS3231WakeTimer(DS3231 *rtc = NULL);
+	virtual ~DS3231WakeTimer();
+
+	/***
+	 * Set the DS3231 to use
+	 * @param rtc
+	 */
+	void setRTC(DS3231 *rtc);
+
+	/***
+	 * Get the DS3231 in use
+	 * @return DS3231 object or NULL
+	 */
+	DS3231 * getRTC();
+
+	/***
+	 * Power off the DS3231 VCC while asleep, running on battery backup
+	 * @param on
+	 */
+	void setPowerDown(bool on = true);
+
+	/***
+	 * Pad the DS3231 INT/SQW is wired to
+	 * @param pad - >28 if not known, the sleep must then be given it
+	 */
+	void setWakePad(uint8_t pad);
+
+	virtual bool setAlarm(uint32_t minutes, WakeTimerCallback cb = NULL);
+
+	virtual void clearAlarm();
+
+	virtual bool canWakeDormant();
+
+	virtual void sleepPrepare();
+
+	virtual void wakeRecover();
+
+	virtual uint32_t getEpoch();
+
+	virtual bool needsWakePad();
+
+	virtual uint8_t getWakePad();
+
+private:
+	DS3231 *pRTC = NULL;
+	bool xPowerDown = false;
+	uint8_t xWakePad = 0xFF;
+};
+
+#endif /* SRC_DS3231WAKETIMER_H_ */
@@ -9,36 +9,95 @@
 #include "pico/sleep.h"
 #include "pico/stdlib.h"
 #include <stdio.h>
-#include "hardware/rtc.h"
+#include <new>
 #include "hardware/rosc.h"
 #include "hardware/structs/scb.h"
 #include "hardware/sync.h"
-#include "hardware/rtc.h"
-#include "pico/util/datetime.h"
+#include "hardware/timer.h"
 #include "pico/runtime_init.h"
 
 
+/*
+ * sleep_en0 and sleep_en1 bits of each clock group
+ */
+static const uint32_t xClockBits[DeepSleep::CLK_GROUPS][2] = {
+	{CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_ADC_ADC_BITS |
+			CLOCKS_SLEEP_EN0_CLK_SYS_ADC_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_SYS_SRAM0_BITS |
+			CLOCKS_SLEEP_EN0_CLK_SYS_SRAM1_BITS |
+			CLOCKS_SLEEP_EN0_CLK_SYS_SRAM2_BITS |
+			CLOCKS_SLEEP_EN0_CLK_SYS_SRAM3_BITS |
+			CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_SYS_JTAG_BITS, 0},
+	{0, CLOCKS_SLEEP_EN1_CLK_SYS_UART0_BITS |
+			CLOCKS_SLEEP_EN1_CLK_PERI_UART0_BITS},
+	{0, CLOCKS_SLEEP_EN1_CLK_SYS_UART1_BITS |
+			CLOCKS_SLEEP_EN1_CLK_PERI_UART1_BITS},
+	{0, CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS},
+	{0, CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS |
+			CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS},
+	{CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_SYS_PIO1_BITS, 0},
+	{CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS, 0}
+};
+
 DeepSleep::DeepSleep() {
 	 storeClocks();
-
+	 xDS3231Timer.setPowerDown(true);
+	 pWakeTimer = &xRTCTimer;
+	 pTimerInUse = pWakeTimer;
 }
 
 DeepSleep::~DeepSleep() {
 	// TODO Auto-generated destructor stub
 }
 
-void DeepSleep::setRTC(DS3231 *rtc){
-	pRTC = rtc;
+void DeepSleep::setRTC(DS3231 *rtc, uint8_t intPad){
+	if (rtc == NULL){
+		setWakeTimer(NULL);
+	} else {
+		xDS3231Timer.setRTC(rtc);
+		xDS3231Timer.setWakePad(intPad);
+		setWakeTimer(&xDS3231Timer);
+	}
+}
+
+void DeepSleep::setWakeTimer(WakeTimer *timer){
+	if (timer == NULL){
+		pWakeTimer = &xRTCTimer;
+	} else {
+		pWakeTimer = timer;
+	}
+	pTimerInUse = pWakeTimer;
+}
+
+WakeTimer * DeepSleep::getWakeTimer(){
+	return pWakeTimer;
 }
 
 void DeepSleep::gpio_callback(uint gpio, uint32_t events) {
 	DeepSleep::singleton()->recover();
+	DeepSleep::singleton()->wake();
 
 	//DEBUG
 	//printf("GPIO Triggered Wake %d\n", gpio);
 }
 
 void DeepSleep::sleep(uint8_t wakePad){
+	prepareWake(true);
+	sleepGated(wakePad);
+}
+
+void DeepSleep::prepareWake(bool lowClock){
+	xRecovered = false;
+	xWake = false;
+	xAlarmFired = false;
+	xLowClock = lowClock;
+}
+
+void DeepSleep::sleepGated(uint8_t wakePad){
 	if (wakePad <= 28){
 		gpio_init(wakePad);
 		gpio_pull_up(wakePad);
@@ -62,11 +121,22 @@ void DeepSleep::sleep(uint8_t wakePad){
 		}
 	}
 
-	sleep_run_from_xosc();
-	sleep_until_interupt();
+	//Masked so a wake IRQ cannot recover half way through the switch
+	uint32_t irq = save_and_disable_interrupts();
+	if (!xWake){
+		if (xLowClock){
+			sleep_run_from_xosc();
+			clocksChanged();
+		}
+		restore_interrupts(irq);
+		sleep_until_interupt();
 
-	if (pRTC != NULL){
-		recover_from_sleep(scb_orig, clock0_orig, clock1_orig);
+		//Recover here unless already done from the wake IRQ
+		if (!xRecovered){
+			recover();
+		}
+	} else {
+		restore_interrupts(irq);
 	}
 
 	if (wakePad <= 28){
@@ -84,76 +154,107 @@ void DeepSleep::rtcCB(void) {
 	//gpio_put(5, true);
 
 	DeepSleep::singleton()->recover();
+	DeepSleep::singleton()->wake();
 	//DEBUG
 	//printf("Int RTC Triggered Waked\n");
 }
 
+void DeepSleep::alarmCB(uint alarm) {
+	DeepSleep::singleton()->xAlarmFired = true;
+	DeepSleep::singleton()->recover();
+	DeepSleep::singleton()->wake();
+}
+
 void DeepSleep::recover(){
-	recover_from_sleep(scb_orig, clock0_orig, clock1_orig);
+	if (xLowClock){
+		recover_from_sleep(scb_orig, clock0_orig, clock1_orig);
+	} else {
+		//Clocks never stopped, only the gating to undo
+		scb_hw->scr = scb_orig;
+		clocks_hw->sleep_en0 = clock0_orig;
+		clocks_hw->sleep_en1 = clock1_orig;
+		xRecovered = true;
+	}
+}
+
+bool DeepSleep::sleepUs(uint64_t us, uint8_t wakePad){
+	return sleepUs(us, wakePad, (us >= DEEPSLEEP_US_XOSC_MIN));
+}
+
+bool DeepSleep::sleepUs(uint64_t us, uint8_t wakePad, bool lowClock){
+	absolute_time_t until;
+
+	if (us < DEEPSLEEP_US_MIN){
+		busy_wait_us(us);
+		return true;
+	}
+	if (xAlarm < 0){
+		xAlarm = hardware_alarm_claim_unused(false);
+		if (xAlarm < 0){
+			//All alarms in use, wait awake rather than not at all
+			sleep_us(us);
+			return true;
+		}
+		hardware_alarm_set_callback(xAlarm, DeepSleep::alarmCB);
+	}
+
+	//Only the system timer is needed, not the wake timer's clocks
+	pTimerInUse = NULL;
+	xAlarmClocks1 = CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS;
+
+	prepareWake(lowClock);
+	until = delayed_by_us(get_absolute_time(), us);
+	if (hardware_alarm_set_target(xAlarm, until)){
+		//Already passed
+		xAlarmClocks1 = 0;
+		pTimerInUse = pWakeTimer;
+		return true;
+	}
+	sleepGated(wakePad);
+	xAlarmClocks1 = 0;
+	pTimerInUse = pWakeTimer;
+
+	hardware_alarm_cancel(xAlarm);
+	return xAlarmFired;
 }
 
 
 void DeepSleep::sleep(uint minutes, uint8_t wakePad){
+	WakeTimer *timer = pWakeTimer;
+	bool timed;
+
 	notifyObservers(minutes, false);
-	if (pRTC != NULL){
-		pRTC->clear_alarm();
-		pRTC->set_delay(minutes);
-		pRTC->off();
-	} else {
-		if (!rtc_running()){
-			rtc_init();
-			 datetime_t t = {
-			            .year  = 2020,
-			            .month = 06,
-			            .day   = 05,
-			            .dotw  = 5, // 0 is Sunday, so 5 is Friday
-			            .hour  = 15,
-			            .min   = 45,
-			            .sec   = 00
-			    };
-			 if(!rtc_set_datetime(&t)){
-				 printf("RTC Set Failed\n");
-				 uart_default_tx_wait_blocking();
-			 }
-			 //Wait for RTC to update
-			 sleep_ms(250);
-		}
-		datetime_t t;
-		if (!rtc_get_datetime (&t)){
-			printf("RTC Broken\n");
-			uart_default_tx_wait_blocking();
+	prepareWake(true);
+	//An alarm with no pad to wake on would never end the sleep
+	timed = timer->canReach(wakePad) &&
+			timer->setAlarm(minutes, DeepSleep::rtcCB);
+	if (!timed && (timer != &xRTCTimer)){
+		//External timer failed, Pico RTC keeps the sleep bounded
+		xTimerFailures++;
+		timer = &xRTCTimer;
+		timed = timer->setAlarm(minutes, DeepSleep::rtcCB);
+	}
+	if (timed){
+		pTimerInUse = timer;
+		timer->sleepPrepare();
+		//Timer may only wake through its own pad
+		if ((wakePad > 28) && timer->needsWakePad()){
+			wakePad = timer->getWakePad();
 		}
-		//printf("Current Time %d:%d:%d \n", t.hour, t.min, t.sec);
-
-		t.year = -1;
-		t.month = -1;
-		t.day = -1;
-		t.hour = -1;
-		t.dotw = -1;
-		t.min = (t.min + minutes) %60;
-		/*Debug
-		t.min = -1;
-		t.sec = (t.sec + 10) % 60;
-		printf("Sleep %u min until %d-%d-%d (%d) %d:%d:%d \n", minutes,
-				t.year,
-				t.month,
-				t.day,
-				t.dotw,
-				t.hour,
-				t.min,
-				t.sec);
-	    uart_default_tx_wait_blocking();
-	    */
-		rtc_set_alarm ( &t,  DeepSleep::rtcCB);
 	}
-	sleep(wakePad);
-	if (pRTC != NULL){
-		pRTC->on();
-		pRTC->clear_alarm();
+	sleepGated(wakePad);
+	if (timed){
+		timer->wakeRecover();
+		timer->clearAlarm();
 	}
+	pTimerInUse = pWakeTimer;
 	notifyObservers(minutes, true);
 }
 
+uint32_t DeepSleep::getTimerFailures(){
+	return xTimerFailures;
+}
+
 void DeepSleep::sleepMin(uint minutes){
 	sleep(minutes, 0xFF);
 }
@@ -171,58 +272,96 @@ void DeepSleep::recover_from_sleep(uint scb_orig, uint clock0_orig, uint clock1_
 
     //reset clocks
     clocks_init();
+    clocksChanged();
    stdio_init_all();
 
+   xRecovered = true;
+
    return;
 }
 
 void DeepSleep::sleep_until_interupt( ) {
-    // Turn off all clocks when in sleep mode except for RTC
-	if (pRTC == NULL){
-		clocks_hw->sleep_en0 =
-				xClocks |
-				CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS;
-	} else {
-		clocks_hw->sleep_en0 = xClocks;
+	uint32_t irq = save_and_disable_interrupts();
+	if (xWake){
+		//Woken and recovered already, nothing gated to undo
+		restore_interrupts(irq);
+		return;
+	}
+
+    // Turn off all clocks when in sleep mode except those the timer needs
+	uint32_t clocks0 = xClocks;
+	if (pTimerInUse != NULL){
+		clocks0 |= pTimerInUse->getSleepClocks();
 	}
-    clocks_hw->sleep_en1 = 0x0;
+	clocks_hw->sleep_en0 = clocks0;
+    clocks_hw->sleep_en1 = xClocks1 | xAlarmClocks1;
 
     uint save = scb_hw->scr;
     // Enable deep sleep at the proc
     scb_hw->scr = save | M0PLUS_SCR_SLEEPDEEP_BITS;
 
-    // Go to sleep
-    __wfi();
+    // Go to sleep. Background IRQs call sleepOn to send the core back
+    // to sleep. Interrupts are masked around the test so a wake arriving
+    // before the WFI is seen, or still pends and ends the WFI
+    while (!xWake) {
+    	xSleepOn = false;
+    	__wfi();
+    	restore_interrupts(irq);
+    	irq = save_and_disable_interrupts();
+    	if (!xSleepOn) {
+    		break;
+    	}
+    }
+    restore_interrupts(irq);
+}
+
+void DeepSleep::wake(){
+	xWake = true;
+}
+
+void DeepSleep::sleepOn(){
+	xSleepOn = true;
 }
 
 
 
 
+alignas(DeepSleep) static uint8_t xSingletonStore[sizeof(DeepSleep)];
+
 DeepSleep * DeepSleep::pSingleton  = NULL;
 DeepSleep * DeepSleep::singleton(){
 	if (pSingleton == NULL){
-		pSingleton = new DeepSleep;
+		pSingleton = new (xSingletonStore) DeepSleep;
 	}
 	return pSingleton;
 }
 
-void DeepSleep::addObserver(DormantNotification *obs){
-	xObservers.push_back(obs);
+bool DeepSleep::addObserver(DormantNotification *obs){
+	if (xNumObservers >= DORMANT_MAX_OBSERVERS){
+		return false;
+	}
+	pObservers[xNumObservers++] = obs;
+	return true;
 }
 
 void DeepSleep::delObserver(DormantNotification *obs){
-	xObservers.remove(obs);
+	uint j = 0;
+	for (uint i = 0; i < xNumObservers; i++){
+		if (pObservers[i] != obs){
+			pObservers[j++] = pObservers[i];
+		}
+	}
+	xNumObservers = j;
 }
 
 void DeepSleep::notifyObservers(uint minutes, bool wake){
-	for (auto itr = xObservers.begin();
-	        itr != xObservers.end(); itr++) {
-			if (!wake) {
-				(*itr)->notifyDormant(minutes);
-			} else {
-				(*itr)->notifyWake(minutes);
-			}
-	    }
+	for (uint i = 0; i < xNumObservers; i++){
+		if (!wake) {
+			pObservers[i]->notifyDormant(minutes);
+		} else {
+			pObservers[i]->notifyWake(minutes);
+		}
+	}
 }
 
 void DeepSleep::storeClocks(){
@@ -232,46 +371,135 @@ void DeepSleep::storeClocks(){
 }
 
 
+void DeepSleep::keepClocks(ClockGroup group){
+	if (xClockUsers[group] < UINT8_MAX){
+		xClockUsers[group]++;
+	}
+	xClocks = xClocks | xClockBits[group][0];
+	xClocks1 = xClocks1 | xClockBits[group][1];
+}
+
+void DeepSleep::dropClocks(ClockGroup group){
+	if (xClockUsers[group] == 0){
+		return;
+	}
+	xClockUsers[group]--;
+	if (xClockUsers[group] == 0){
+		xClocks = xClocks & ~xClockBits[group][0];
+		xClocks1 = xClocks1 & ~xClockBits[group][1];
+	}
+}
+
 void DeepSleep::enablePWM(){
-	xClocks = xClocks | CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS;
+	keepClocks(CLK_PWM);
+}
+
+void DeepSleep::disablePWM(){
+	dropClocks(CLK_PWM);
 }
 
 void DeepSleep::enableRTC(){
-	xClocks = xClocks |  CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS;
+	keepClocks(CLK_RTC);
+}
+
+void DeepSleep::disableRTC(){
+	dropClocks(CLK_RTC);
+}
+
+void DeepSleep::enableADC(){
+	keepClocks(CLK_ADC);
+}
+
+void DeepSleep::disableADC(){
+	dropClocks(CLK_ADC);
+}
+
+void DeepSleep::enableSRAM(){
+	keepClocks(CLK_SRAM);
+}
+
+void DeepSleep::disableSRAM(){
+	dropClocks(CLK_SRAM);
 }
 
 void DeepSleep::enableJTAG(){
-	xClocks = xClocks |  CLOCKS_SLEEP_EN0_CLK_SYS_JTAG_BITS;
+	keepClocks(CLK_JTAG);
+}
+
+void DeepSleep::disableJTAG(){
+	dropClocks(CLK_JTAG);
 }
 
 void DeepSleep::enableUart0(){
-	xClocks = xClocks |  CLOCKS_SLEEP_EN1_CLK_SYS_UART0_BITS;
+	keepClocks(CLK_UART0);
 }
 
+void DeepSleep::disableUart0(){
+	dropClocks(CLK_UART0);
+}
 
 void DeepSleep::enableUart1(){
-	xClocks = xClocks |  CLOCKS_SLEEP_EN1_CLK_PERI_UART0_BITS;
+	keepClocks(CLK_UART1);
+}
+
+void DeepSleep::disableUart1(){
+	dropClocks(CLK_UART1);
 }
 
 void DeepSleep::enableTimer(){
-	xClocks = xClocks |  CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS;
+	keepClocks(CLK_TIMER);
+}
+
+void DeepSleep::disableTimer(){
+	dropClocks(CLK_TIMER);
 }
 
 void DeepSleep::enableUSB(){
-	xClocks = xClocks |  CLOCKS_ENABLED0_CLK_SYS_PLL_USB_BITS;
+	keepClocks(CLK_USB);
+}
+
+void DeepSleep::disableUSB(){
+	dropClocks(CLK_USB);
 }
 
 void DeepSleep::enablePIO0(){
-	xClocks = xClocks |  CLOCKS_ENABLED0_CLK_SYS_PADS_BITS;
+	keepClocks(CLK_PIO0);
+}
+
+void DeepSleep::disablePIO0(){
+	dropClocks(CLK_PIO0);
 }
 
 void DeepSleep::enablePIO1(){
-	xClocks = xClocks |  CLOCKS_ENABLED0_CLK_SYS_PIO1_BITS;
+	keepClocks(CLK_PIO1);
 }
 
+void DeepSleep::disablePIO1(){
+	dropClocks(CLK_PIO1);
+}
 
 void DeepSleep::enableDMA(){
-	xClocks = xClocks |  CLOCKS_ENABLED0_CLK_SYS_DMA_BITS;
+	keepClocks(CLK_DMA);
+}
+
+void DeepSleep::disableDMA(){
+	dropClocks(CLK_DMA);
+}
+
+void DeepSleep::setRTCClockPad(uint8_t gp, uint32_t hz){
+	xRTCTimer.setClockPad(gp, hz);
+}
+
+void DeepSleep::clocksChanged(){
+	//Pico RTC may be on an external clock even when not the wake timer
+	xRTCTimer.clocksChanged();
+	if (pWakeTimer != &xRTCTimer){
+		pWakeTimer->clocksChanged();
+	}
+
+	for (uint i = 0; i < xNumObservers; i++){
+		pObservers[i]->notifyClocksChanged();
+	}
 }
 
 void DeepSleep::setOwnGPIOCallbacks(bool on){
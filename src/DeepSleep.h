@@ -10,11 +10,26 @@
 
 #include "pico/stdlib.h"
 #include "DS3231.hpp"
+#include "WakeTimer.h"
+#include "DS3231WakeTimer.h"
+#include "RTCWakeTimer.h"
 #include "DormantNotification.h"
-#include <list>
+#include "SleepController.h"
 #include "hardware/clocks.h"
 
-class DeepSleep {
+//Below this sleepUs waits awake, the wake IRQ costs more
+#ifndef DEEPSLEEP_US_MIN
+#define DEEPSLEEP_US_MIN 100
+#endif
+
+//From this sleepUs also drops to the XOSC and stops the PLLs. Shorter
+//sleeps keep the clocks running and only gate them, as restarting the
+//PLLs and stdio would cost more than it saves
+#ifndef DEEPSLEEP_US_XOSC_MIN
+#define DEEPSLEEP_US_XOSC_MIN 20000
+#endif
+
+class DeepSleep : public SleepController {
 public:
 	virtual ~DeepSleep();
 
@@ -22,9 +37,33 @@ public:
 	 * Set the RTC
 	 * If no RTC will just ignore RTC comms
 	 * @param rtc - pointer to the RTC object. Can be NULL
+	 * @param intPad - GPIO Pad the DS3231 INT/SQW is wired to, used for
+	 * timed sleeps given no pad. >28 if not known, such sleeps then
+	 * count as a timer failure and use the fallback
+	 */
+	void setRTC(DS3231 *rtc, uint8_t intPad = 0xFF);
+
+	/***
+	 * Set the timer used to wake from a timed sleep
+	 * @param timer - Wake Timer. NULL to use the Pico RTC
+	 */
+	void setWakeTimer(WakeTimer *timer);
+
+	/***
+	 * Get the timer used to wake from a timed sleep
+	 * @return Wake Timer
 	 */
-	void setRTC(DS3231 *rtc);
+	virtual WakeTimer * getWakeTimer();
 
+	/***
+	 * Clock the Pico RTC from an external reference on a GPIN pad,
+	 * such as the DS3231 32kHz output. The RTC then keeps the accuracy
+	 * of the external source and is not disturbed by clock changes
+	 * around sleep.
+	 * @param gp - GPIO Pad, must be 20 (GPIN0) or 22 (GPIN1). >28 disables
+	 * @param hz - frequency of the reference
+	 */
+	void setRTCClockPad(uint8_t gp, uint32_t hz = 32768);
 
 	/***
 	 * Own GPIO Callbacks, meaning any existing GPIO callback on the
@@ -42,11 +81,12 @@ public:
 
 	/***
 	 * Sleep for number of minutes and wake by GPIO pad
-	 * If no RTC then it will just do sleep(wakePad)
+	 * or by the wake timer.
+	 * If the wake timer fails to arm the Pico RTC is used instead
 	 * @param minutes - Minutes to sleep for (<=60)
 	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
 	 */
-	void sleep(uint minutes, uint8_t wakePad=0xFF);
+	virtual void sleep(uint minutes, uint8_t wakePad=0xFF);
 
 	/***
 	 * Sleep for a number of minutes.
@@ -55,6 +95,28 @@ public:
 	 */
 	void sleepMin(uint minutes);
 
+	/***
+	 * Sleep for micro seconds, woken by a hardware timer alarm, for
+	 * gaps such as between samples in a burst. Only the timer and the
+	 * clocks enabled here run while asleep. The system timer keeps
+	 * counting so time_us_64 stays correct.
+	 * Observers are not told, so radios and leases are left alone.
+	 * @param us - time to sleep
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 * @return false if woken early by the pad or another wake source
+	 */
+	bool sleepUs(uint64_t us, uint8_t wakePad = 0xFF);
+
+	/***
+	 * Sleep for micro seconds, woken by a hardware timer alarm, with
+	 * the clocks chosen by the caller, such as a PowerManager
+	 * @param us - time to sleep
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 * @param lowClock - also run from the XOSC with the PLLs stopped
+	 * @return false if woken early by the pad or another wake source
+	 */
+	bool sleepUs(uint64_t us, uint8_t wakePad, bool lowClock);
+
 
 	/***
 	 * Get the Deep Sleep control object
@@ -62,11 +124,33 @@ public:
 	 */
 	static DeepSleep * singleton();
 
+	/***
+	 * End the current sleep. Call from the IRQ of an application wake
+	 * source, such as a counter reaching its threshold.
+	 * The timer and wake pad call this themselves.
+	 */
+	void wake();
+
+	/***
+	 * Called from the IRQ of a background source, such as a counter
+	 * wrap, so the core returns to sleep once the IRQ is handled
+	 * instead of ending the sleep. Ignored if wake is also called.
+	 */
+	void sleepOn();
+
+	/***
+	 * Number of times the wake timer failed to arm, or had no pad to
+	 * wake on, and the Pico RTC was used instead
+	 * @return count
+	 */
+	uint32_t getTimerFailures();
+
 	/***
 	 * Add observer for sleep and wakeup
 	 * @param obs
+	 * @return false if DORMANT_MAX_OBSERVERS already added
 	 */
-	void addObserver(DormantNotification *obs);
+	bool addObserver(DormantNotification *obs);
 
 	/***
 	 * Delete observer for sleep and wakeup
@@ -75,39 +159,111 @@ public:
 	void delObserver(DormantNotification *obs);
 
 
+	/*
+	 * Clocks kept running during Deep Sleep. Each enable is counted and
+	 * the clocks stop in sleep again once every enable has had its
+	 * disable, so drivers sharing a clock can each release it.
+	 */
+	enum ClockGroup {
+		CLK_PWM = 0,
+		CLK_RTC,
+		CLK_ADC,
+		CLK_SRAM,
+		CLK_JTAG,
+		CLK_UART0,
+		CLK_UART1,
+		CLK_TIMER,
+		CLK_USB,
+		CLK_PIO0,
+		CLK_PIO1,
+		CLK_DMA,
+		CLK_GROUPS
+	};
+
 	/***
 	 * Enable PWM to function during Deep Sleep
 	 */
 	void enablePWM();
 
+	/***
+	 * Release an enablePWM
+	 */
+	void disablePWM();
+
 	/***
 	 * Enable Pico RTC to function during Deep Sleep
 	 */
 	void enableRTC();
 
+	/***
+	 * Release an enableRTC
+	 */
+	void disableRTC();
+
+	/***
+	 * Enable the ADC to function during Deep Sleep, see ADCCapture
+	 */
+	void enableADC();
+
+	/***
+	 * Release an enableADC
+	 */
+	void disableADC();
+
+	/***
+	 * Keep the striped SRAM banks and bus fabric clocked during Deep
+	 * Sleep, for DMA into RAM
+	 */
+	void enableSRAM();
+
+	/***
+	 * Release an enableSRAM
+	 */
+	void disableSRAM();
+
 	/***
 	 * Untested. Enable JTAG and therefore SWD during deepsleep?
 	 */
 	void enableJTAG();
 
+	/***
+	 * Release an enableJTAG
+	 */
+	void disableJTAG();
+
 	/***
 	 * UnTested
 	 * Enable Uart0 receive  during deep sleep
 	 */
 	void enableUart0();
 
+	/***
+	 * Release an enableUart0
+	 */
+	void disableUart0();
+
 	/***
 	 * UnTested
 	 * Enable Uart1 receive  during deep sleep
 	 */
 	void enableUart1();
 
+	/***
+	 * Release an enableUart1
+	 */
+	void disableUart1();
+
 	/***
 	 * UnTested
 	 * Enable Timers  during deep sleep
 	 */
 	void enableTimer();
 
+	/***
+	 * Release an enableTimer
+	 */
+	void disableTimer();
+
 	/***
 	 * UnTested
 	 * Enable USB receive  during deep sleep
@@ -115,29 +271,60 @@ public:
 	void enableUSB();
 
 	/***
-	 * UnTested
-	 * Enable PIO0   during deep sleep
+	 * Release an enableUSB
+	 */
+	void disableUSB();
+
+	/***
+	 * Enable PIO0 during deep sleep, see PIOCounter
 	 */
 	void enablePIO0();
 
 	/***
-	 * UnTested
-	 * Enable PIO1   during deep sleep
+	 * Release an enablePIO0
+	 */
+	void disablePIO0();
+
+	/***
+	 * Enable PIO1 during deep sleep, see PIOCounter
 	 */
 	void enablePIO1();
 
+	/***
+	 * Release an enablePIO1
+	 */
+	void disablePIO1();
+
 	/***
 	 * UnTested
 	 * Enable DMA   during deep sleep
 	 */
 	void enableDMA();
 
+	/***
+	 * Release an enableDMA
+	 */
+	void disableDMA();
+
 
 private:
 	static DeepSleep * pSingleton ;
 	DeepSleep();
 
+	/***
+	 * Count a user of a clock group and keep it running in sleep
+	 * @param group
+	 */
+	void keepClocks(ClockGroup group);
+
+	/***
+	 * Release a user of a clock group, stopped in sleep after the last
+	 * @param group
+	 */
+	void dropClocks(ClockGroup group);
+
 	static void rtcCB(void);
+	static void alarmCB(uint alarm);
 	static void gpio_callback(uint gpio, uint32_t events);
 
 	void recover();
@@ -160,6 +347,26 @@ private:
 
 	void sleep_until_interupt( ) ;
 
+	/***
+	 * Clear the wake state before any wake source is armed, so a wake
+	 * that comes before the sleep is not lost
+	 * @param lowClock - run from the XOSC with the PLLs stopped
+	 */
+	void prepareWake(bool lowClock);
+
+	/***
+	 * Gate the clocks and sleep until woken, then recover.
+	 * Returns at once if woken since prepareWake
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 */
+	void sleepGated(uint8_t wakePad);
+
+	/***
+	 * Tell the timers and observers the system clocks have been
+	 * reconfigured
+	 */
+	void clocksChanged();
+
 	/***
 	 * Notify observers of going dormant
 	 * @param minutes
@@ -167,14 +374,28 @@ private:
 	 */
 	void notifyObservers(uint minutes, bool wake=false);
 
-	std::list<DormantNotification *> xObservers;
+	DormantNotification *pObservers[DORMANT_MAX_OBSERVERS];
+	uint xNumObservers = 0;
 
     volatile bool xOwnGPIOCallbacks = true;
-	DS3231 *pRTC = NULL;
+	WakeTimer *pWakeTimer = NULL;
+	WakeTimer *pTimerInUse = NULL;
+	DS3231WakeTimer xDS3231Timer;
+	RTCWakeTimer xRTCTimer;
+	uint32_t xTimerFailures = 0;
+	volatile bool xRecovered = false;
+	volatile bool xWake = false;
+	volatile bool xSleepOn = false;
+	volatile bool xLowClock = true;
+	volatile bool xAlarmFired = false;
+	int xAlarm = -1;
 	volatile uint scb_orig;
 	volatile uint clock0_orig;
 	volatile uint clock1_orig;
-	volatile io_rw_32 xClocks = 0;
+	volatile io_rw_32 xClocks = 0;	// Kept running in sleep, sleep_en0
+	volatile io_rw_32 xClocks1 = 0;	// Kept running in sleep, sleep_en1
+	volatile io_rw_32 xAlarmClocks1 = 0;	// Added for sleepUs, sleep_en1
+	uint8_t xClockUsers[CLK_GROUPS] = {0};
 };
 
 #endif /* SRC_DEEPSLEEP_H_ */
@@ -9,10 +9,12 @@
 #include "pico/sleep.h"
 #include "pico/stdlib.h"
 #include <stdio.h>
-#include "hardware/rtc.h"
+#include <new>
 #include "hardware/clocks.h"
 #include "hardware/rosc.h"
+#include "hardware/xosc.h"
 #include "hardware/structs/scb.h"
+#include "hardware/sync.h"
 #include "pico/runtime_init.h"
 
 Dormant::Dormant() {
@@ -20,12 +22,26 @@ Dormant::Dormant() {
 }
 
 Dormant::Dormant(DS3231 *rtc) {
-	pRTC = rtc;
+	setRTC(rtc);
 	storeClocks();
 }
 
-void Dormant::setRTC(DS3231 *rtc){
-	pRTC = rtc;
+void Dormant::setRTC(DS3231 *rtc, uint8_t intPad){
+	if (rtc == NULL){
+		setWakeTimer(NULL);
+	} else {
+		xDS3231Timer.setRTC(rtc);
+		xDS3231Timer.setWakePad(intPad);
+		setWakeTimer(&xDS3231Timer);
+	}
+}
+
+void Dormant::setWakeTimer(WakeTimer *timer){
+	pWakeTimer = timer;
+}
+
+WakeTimer * Dormant::getWakeTimer(){
+	return pWakeTimer;
 }
 
 void Dormant::storeClocks(){
@@ -39,31 +55,141 @@ Dormant::~Dormant() {
 }
 
 
+void Dormant::setRTCClockPad(uint8_t gp, uint32_t hz){
+	xRTCTimer.setClockPad(gp, hz);
+	if (pWakeTimer == NULL){
+		setWakeTimer(&xRTCTimer);
+	}
+}
+
+void Dormant::clocksChanged(){
+	//Pico RTC may be on an external clock even when not the wake timer
+	xRTCTimer.clocksChanged();
+	if ((pWakeTimer != NULL) && (pWakeTimer != &xRTCTimer)){
+		pWakeTimer->clocksChanged();
+	}
+
+	for (uint i = 0; i < xNumObservers; i++){
+		pObservers[i]->notifyClocksChanged();
+	}
+}
+
 void Dormant::sleep(uint8_t wakePad){
-	gpio_init(wakePad);
-	gpio_pull_up(wakePad);
-	gpio_set_dir(wakePad, GPIO_IN);
+	if ((wakePad > 28) && !xTimerArmed){
+		//Nothing could wake the core from dormant
+		return;
+	}
+	if (wakePad <= 28){
+		gpio_init(wakePad);
+		gpio_pull_up(wakePad);
+		gpio_set_dir(wakePad, GPIO_IN);
+	}
 
 	sleep_run_from_xosc();
-	sleep_goto_dormant_until_pin(wakePad, true, false);
+	clocksChanged();
+	if (wakePad <= 28){
+		sleep_goto_dormant_until_pin(wakePad, true, false);
+	} else {
+		//Only the RTC alarm can wake us
+		xosc_dormant();
+	}
 	recover_from_sleep(scb_orig, clock0_orig, clock1_orig);
 
-	gpio_disable_pulls(wakePad);
+	if (wakePad <= 28){
+		gpio_disable_pulls(wakePad);
+	}
 }
 
 void Dormant::sleep(uint minutes, uint8_t wakePad){
+	WakeTimer *timer = NULL;
+	bool timed = false;
+
 	notifyObservers(minutes, false);
-	if (pRTC != NULL){
-		pRTC->clear_alarm();
-		pRTC->set_delay(minutes);
+	if ((pWakeTimer != NULL) && pWakeTimer->canWakeDormant()){
+		timer = pWakeTimer;
+		//An alarm with no pad to wake on would never end the sleep
+		timed = timer->canReach(wakePad) &&
+				timer->setAlarm(minutes, Dormant::rtcCB);
+		if (!timed){
+			xTimerFailures++;
+			if ((timer != &xRTCTimer) && xRTCTimer.canWakeDormant()){
+				timer = &xRTCTimer;
+				timed = timer->setAlarm(minutes, Dormant::rtcCB);
+			}
+		}
 	}
-	sleep(wakePad);
-	if (pRTC != NULL){
-		pRTC->clear_alarm();
+	if (!timed){
+		//Never go dormant without an armed timer
+		sleepBounded(minutes, wakePad);
+		notifyObservers(minutes, true);
+		return;
 	}
+
+	timer->sleepPrepare();
+	//Timer may only wake through its own pad
+	if ((wakePad > 28) && timer->needsWakePad()){
+		wakePad = timer->getWakePad();
+	}
+	xTimerArmed = true;
+	sleep(wakePad);
+	xTimerArmed = false;
+	timer->wakeRecover();
+	timer->clearAlarm();
 	notifyObservers(minutes, true);
 }
 
+void Dormant::sleepBounded(uint minutes, uint8_t wakePad){
+	if (wakePad <= 28){
+		gpio_init(wakePad);
+		gpio_pull_up(wakePad);
+		gpio_set_dir(wakePad, GPIO_IN);
+		if (!xOwnGPIOCallbacks) {
+			//Have callback function so just enable
+			gpio_set_irq_enabled(wakePad, GPIO_IRQ_EDGE_FALL, true);
+		} else {
+			gpio_set_irq_enabled_with_callback(
+					wakePad,
+					GPIO_IRQ_EDGE_FALL,
+					true,
+					Dormant::gpioCB);
+		}
+	}
+
+	xRTCTimer.setAlarm(minutes, Dormant::rtcCB);
+	sleep_run_from_xosc();
+	clocksChanged();
+
+	//Only the Pico RTC is clocked while asleep
+	clocks_hw->sleep_en0 = CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS;
+	clocks_hw->sleep_en1 = 0x0;
+	scb_hw->scr = scb_orig | M0PLUS_SCR_SLEEPDEEP_BITS;
+	__wfi();
+
+	recover_from_sleep(scb_orig, clock0_orig, clock1_orig);
+	xRTCTimer.clearAlarm();
+
+	if (wakePad <= 28){
+		gpio_set_irq_enabled(wakePad, GPIO_IRQ_EDGE_FALL, false);
+		gpio_disable_pulls(wakePad);
+	}
+}
+
+void Dormant::setOwnGPIOCallbacks(bool on){
+	xOwnGPIOCallbacks = on;
+}
+
+uint32_t Dormant::getTimerFailures(){
+	return xTimerFailures;
+}
+
+void Dormant::gpioCB(uint gpio, uint32_t events) {
+	//Recovery is done once out of sleep
+}
+
+void Dormant::rtcCB(void) {
+	//Recovery is done once out of dormant
+}
+
 void Dormant::recover_from_sleep(uint scb_orig, uint clock0_orig, uint clock1_orig){
 
     //Re-enable ring Oscillator control
@@ -76,37 +202,49 @@ void Dormant::recover_from_sleep(uint scb_orig, uint clock0_orig, uint clock1_or
 
     //reset clocks
     clocks_init();
+    clocksChanged();
     stdio_init_all();
 
     return;
 }
 
 
+alignas(Dormant) static uint8_t xSingletonStore[sizeof(Dormant)];
+
 Dormant * Dormant::pSingleton  = NULL;
 Dormant * Dormant::singleton(){
 	if (pSingleton == NULL){
-		pSingleton = new Dormant;
+		pSingleton = new (xSingletonStore) Dormant;
 	}
 	return pSingleton;
 }
 
-void Dormant::addObserver(DormantNotification *obs){
-	xObservers.push_back(obs);
+bool Dormant::addObserver(DormantNotification *obs){
+	if (xNumObservers >= DORMANT_MAX_OBSERVERS){
+		return false;
+	}
+	pObservers[xNumObservers++] = obs;
+	return true;
 }
 
 void Dormant::delObserver(DormantNotification *obs){
-	xObservers.remove(obs);
+	uint j = 0;
+	for (uint i = 0; i < xNumObservers; i++){
+		if (pObservers[i] != obs){
+			pObservers[j++] = pObservers[i];
+		}
+	}
+	xNumObservers = j;
 }
 
 void Dormant::notifyObservers(uint minutes, bool wake){
-	for (auto itr = xObservers.begin();
-	        itr != xObservers.end(); itr++) {
-			if (!wake) {
-				(*itr)->notifyDormant(minutes);
-			} else {
-				(*itr)->notifyWake(minutes);
-			}
-	    }
+	for (uint i = 0; i < xNumObservers; i++){
+		if (!wake) {
+			pObservers[i]->notifyDormant(minutes);
+		} else {
+			pObservers[i]->notifyWake(minutes);
+		}
+	}
 }
 
 
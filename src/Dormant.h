@@ -14,11 +14,14 @@
 
 #include "pico/stdlib.h"
 #include "DS3231.hpp"
+#include "WakeTimer.h"
+#include "DS3231WakeTimer.h"
+#include "RTCWakeTimer.h"
 #include "DormantNotification.h"
-#include <list>
+#include "SleepController.h"
 
 
-class Dormant {
+class Dormant : public SleepController {
 public:
 
 
@@ -27,22 +30,59 @@ public:
 	 * Set the RTC
 	 * If no RTC will just ignore RTC comms
 	 * @param rtc - pointer to the RTC object. Can be NULL
+	 * @param intPad - GPIO Pad the DS3231 INT/SQW is wired to, used for
+	 * timed sleeps given no pad. >28 if not known, such sleeps then
+	 * count as a timer failure and use the fallback
 	 */
-	void setRTC(DS3231 *rtc);
+	void setRTC(DS3231 *rtc, uint8_t intPad = 0xFF);
+
+	/***
+	 * Set the timer used to wake from a timed sleep
+	 * @param timer - Wake Timer. NULL for GPIO wake only
+	 */
+	void setWakeTimer(WakeTimer *timer);
+
+	/***
+	 * Get the timer used to wake from a timed sleep
+	 * @return Wake Timer or NULL
+	 */
+	virtual WakeTimer * getWakeTimer();
+
+	/***
+	 * Clock the Pico RTC from an external reference on a GPIN pad,
+	 * normally the DS3231 32kHz output. As the RTC no longer needs the
+	 * XOSC it keeps running while dormant and its alarm can wake the core.
+	 * If no wake timer is set the Pico RTC becomes the wake timer.
+	 * @param gp - GPIO Pad, must be 20 (GPIN0) or 22 (GPIN1). >28 disables
+	 * @param hz - frequency of the reference
+	 */
+	void setRTCClockPad(uint8_t gp, uint32_t hz = 32768);
+
+	/***
+	 * Own GPIO Callbacks, meaning any existing GPIO callback on the
+	 * core will no longer function while in a bounded sleep.
+	 * If the application already has a GPIO callback this can be disabled
+	 * @param on
+	 */
+	void setOwnGPIOCallbacks(bool on=true);
 
 	/***
 	 * Sleep until pad pulled to ground
-	 * @param wakePad - GPIO Pad for wake
+	 * Returns at once if no pad is given and no timer is armed, as
+	 * nothing could wake the core
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
 	 */
 	void sleep(uint8_t wakePad);
 
 	/***
 	 * Sleep for number of minutes and wake by GPIO pad
-	 * If no RTC then it will just do sleep(wakePad)
+	 * If the wake timer fails to arm the Pico RTC is used instead.
+	 * If no timer able to wake from dormant can be armed it does a clock
+	 * gated sleep on the Pico RTC, so the sleep always stays bounded
 	 * @param minutes - Minutes to sleep for
-	 * @param wakePad - GPIO Pad for wake
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
 	 */
-	void sleep(uint minutes, uint8_t wakePad);
+	virtual void sleep(uint minutes, uint8_t wakePad);
 
 
 	virtual ~Dormant();
@@ -53,7 +93,24 @@ public:
 	 */
 	static Dormant * singleton();
 
-	void addObserver(DormantNotification *obs);
+	/***
+	 * Number of times the wake timer failed to arm, or had no pad to wake
+	 * on, and a fallback was used
+	 * @return count
+	 */
+	uint32_t getTimerFailures();
+
+	/***
+	 * Add observer for sleep and wakeup
+	 * @param obs
+	 * @return false if DORMANT_MAX_OBSERVERS already added
+	 */
+	bool addObserver(DormantNotification *obs);
+
+	/***
+	 * Delete observer for sleep and wakeup
+	 * @param obs
+	 */
 	void delObserver(DormantNotification *obs);
 
 
@@ -84,6 +141,23 @@ private:
 	 */
 	void storeClocks();
 
+	/***
+	 * Tell the timers and observers the system clocks have been
+	 * reconfigured
+	 */
+	void clocksChanged();
+
+	/***
+	 * Clock gated sleep with XOSC running, woken by the Pico RTC.
+	 * Used when no timer can wake from dormant
+	 * @param minutes
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 */
+	void sleepBounded(uint minutes, uint8_t wakePad);
+
+	static void rtcCB(void);
+	static void gpioCB(uint gpio, uint32_t events);
+
 	/***
 	 * Notify observers of going dormant
 	 * @param minutes
@@ -91,9 +165,15 @@ private:
 	 */
 	void notifyObservers(uint minutes, bool wake=false);
 
-	std::list<DormantNotification *> xObservers;
+	DormantNotification *pObservers[DORMANT_MAX_OBSERVERS];
+	uint xNumObservers = 0;
 
-	DS3231 *pRTC = NULL;
+	WakeTimer *pWakeTimer = NULL;
+	DS3231WakeTimer xDS3231Timer;
+	RTCWakeTimer xRTCTimer;
+	uint32_t xTimerFailures = 0;
+	bool xTimerArmed = false;
+	volatile bool xOwnGPIOCallbacks = true;
 	 uint scb_orig;
 	 uint clock0_orig;
 	 uint clock1_orig;
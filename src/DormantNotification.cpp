@@ -23,3 +23,7 @@ void DormantNotification::notifyDormant(uint minutes){
 void DormantNotification::notifyWake(uint minutes){
 
 }
+
+void DormantNotification::notifyClocksChanged(){
+
+}
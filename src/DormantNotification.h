@@ -12,6 +12,16 @@
 
 #include "pico/stdlib.h"
 
+/*
+ * Nothing on the sleep and wake path uses the heap. Dormant and DeepSleep
+ * hold their observers in a fixed table, and the singletons of this
+ * library are built on first use with placement new into static storage
+ * sized for the class, so they need no malloc and never move.
+ */
+#ifndef DORMANT_MAX_OBSERVERS
+#define DORMANT_MAX_OBSERVERS 8
+#endif
+
 
 class DormantNotification {
 public:
@@ -21,6 +31,13 @@ public:
 	virtual void notifyDormant(uint minutes);
 
 	virtual void notifyWake(uint minutes);
+
+	/***
+	 * System clocks have been reconfigured, on entering sleep and on
+	 * recovery. Peripherals clocked from clk_adc or clk_peri should
+	 * restart or rescale here. May be called from IRQ.
+	 */
+	virtual void notifyClocksChanged();
 };
 
 #endif /* SRC_DORMANTNOTIFICATION_H_ */
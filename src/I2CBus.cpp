@@ -0,0 +1,175 @@
+/*
+ * I2CBus.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "I2CBus.h"
+
+I2CBus::I2CBus(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin, uint baud) {
+	pI2C = i2c;
+	xSdaPin = sdaPin;
+	xSclPin = sclPin;
+	xBaud = baud;
+#if I2C_BUS_FREERTOS
+	xMutex = xSemaphoreCreateRecursiveMutexStatic(&xMutexBuffer);
+#else
+	recursive_mutex_init(&xMutex);
+#endif
+}
+
+I2CBus::~I2CBus() {
+	// NOP
+}
+
+void I2CBus::init(){
+	lock();
+	if (!xInit){
+		xCurrentBaud = xBaud;
+		i2c_init(pI2C, xBaud);
+		gpio_set_function(xSdaPin, GPIO_FUNC_I2C);
+		gpio_set_function(xSclPin, GPIO_FUNC_I2C);
+		gpio_pull_up(xSdaPin);
+		gpio_pull_up(xSclPin);
+		xInit = true;
+	}
+	unlock();
+}
+
+void I2CBus::lock(){
+#if I2C_BUS_FREERTOS
+	xSemaphoreTakeRecursive(xMutex, portMAX_DELAY);
+#else
+	recursive_mutex_enter_blocking(&xMutex);
+#endif
+}
+
+bool I2CBus::tryLock(){
+#if I2C_BUS_FREERTOS
+	return (xSemaphoreTakeRecursive(xMutex,
+			pdMS_TO_TICKS(I2C_BUS_LOCK_TIMEOUT_MS)) == pdTRUE);
+#else
+	return recursive_mutex_enter_timeout_ms(&xMutex, I2C_BUS_LOCK_TIMEOUT_MS);
+#endif
+}
+
+void I2CBus::unlock(){
+#if I2C_BUS_FREERTOS
+	xSemaphoreGiveRecursive(xMutex);
+#else
+	recursive_mutex_exit(&xMutex);
+#endif
+}
+
+void I2CBus::selectBaud(uint baud){
+	if (baud == 0){
+		baud = xBaud;
+	}
+	if (baud != xCurrentBaud){
+		i2c_set_baudrate(pI2C, baud);
+		xCurrentBaud = baud;
+	}
+}
+
+int I2CBus::write(uint8_t addr, const uint8_t *src, size_t len,
+		bool nostop, uint baud){
+	int res;
+
+	if (!tryLock()){
+		return PICO_ERROR_TIMEOUT;
+	}
+	selectBaud(baud);
+	res = i2c_write_timeout_us(pI2C, addr, src, len, nostop,
+			I2C_BUS_TIMEOUT_US);
+	unlock();
+	return res;
+}
+
+int I2CBus::read(uint8_t addr, uint8_t *dst, size_t len,
+		bool nostop, uint baud){
+	int res;
+
+	if (!tryLock()){
+		return PICO_ERROR_TIMEOUT;
+	}
+	selectBaud(baud);
+	res = i2c_read_timeout_us(pI2C, addr, dst, len, nostop,
+			I2C_BUS_TIMEOUT_US);
+	unlock();
+	return res;
+}
+
+int I2CBus::writeRead(uint8_t addr, const uint8_t *tx, size_t txLen,
+		uint8_t *rx, size_t rxLen, uint baud){
+	I2CTransaction t = {addr, baud, tx, txLen, rx, rxLen, 0};
+
+	if (!tryLock()){
+		return PICO_ERROR_TIMEOUT;
+	}
+	run(&t);
+	unlock();
+	return t.result;
+}
+
+void I2CBus::run(I2CTransaction *t){
+	selectBaud(t->baud);
+	t->result = 0;
+	if (t->txLen > 0){
+		t->result = i2c_write_timeout_us(pI2C, t->addr, t->tx, t->txLen,
+				(t->rxLen > 0), I2C_BUS_TIMEOUT_US);
+		if (t->result < 0){
+			return;
+		}
+	}
+	if (t->rxLen > 0){
+		t->result = i2c_read_timeout_us(pI2C, t->addr, t->rx, t->rxLen,
+				false, I2C_BUS_TIMEOUT_US);
+	}
+}
+
+bool I2CBus::queue(I2CTransaction *t){
+	bool res = false;
+
+	lock();
+	if (xQueued < I2C_BUS_MAX_BATCH){
+		pQueue[xQueued++] = t;
+		res = true;
+	}
+	unlock();
+	return res;
+}
+
+uint I2CBus::flush(){
+	uint failed = 0;
+
+	if (!tryLock()){
+		//Queue belongs to the lock holder, leave it for the next flush
+		return xQueued;
+	}
+	for (uint i = 0; i < xQueued; i++){
+		run(pQueue[i]);
+		if (pQueue[i]->result < 0){
+			failed++;
+		}
+	}
+	xQueued = 0;
+	unlock();
+	return failed;
+}
+
+uint I2CBus::queued(){
+	return xQueued;
+}
+
+i2c_inst_t * I2CBus::getI2C(){
+	return pI2C;
+}
+
+void I2CBus::setBaud(uint baud){
+	xBaud = baud;
+}
+
+uint I2CBus::getBaud(){
+	return xBaud;
+}
@@ -0,0 +1,215 @@
+/*
+ * I2CBus.h
+ *
+ * Shared I2C bus for several devices. Initialises the controller and
+ * pins once, switches clock speed per device and locks the bus for
+ * each transaction. Transactions from several devices can be queued
+ * and run back to back under one lock.
+ *
+ * Define I2C_BUS_FREERTOS=1 to lock with a FreeRTOS mutex, otherwise
+ * a Pico SDK mutex is used.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_I2CBUS_H_
+#define SRC_I2CBUS_H_
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+#ifndef I2C_BUS_FREERTOS
+#define I2C_BUS_FREERTOS 0
+#endif
+
+#if I2C_BUS_FREERTOS
+#include "FreeRTOS.h"
+#include "semphr.h"
+#else
+#include "pico/mutex.h"
+#endif
+
+#ifndef I2C_BUS_DEFAULT_BAUD
+#define I2C_BUS_DEFAULT_BAUD 400000
+#endif
+
+/*
+ * Bounds so a stuck or missing device cannot hang the caller
+ */
+#ifndef I2C_BUS_TIMEOUT_US
+#define I2C_BUS_TIMEOUT_US 10000
+#endif
+
+#ifndef I2C_BUS_LOCK_TIMEOUT_MS
+#define I2C_BUS_LOCK_TIMEOUT_MS 100
+#endif
+
+#ifndef I2C_BUS_MAX_BATCH
+#define I2C_BUS_MAX_BATCH 8
+#endif
+
+/*
+ * One write then read transaction for the batch queue.
+ * Either length may be zero. Result holds bytes read, or written
+ * if nothing to read, or a PICO_ERROR code. Each transfer is bounded
+ * by I2C_BUS_TIMEOUT_US.
+ */
+struct I2CTransaction {
+	uint8_t			addr;
+	uint			baud;
+	const uint8_t *	tx;
+	size_t			txLen;
+	uint8_t *		rx;
+	size_t			rxLen;
+	int				result;
+};
+
+class I2CBus {
+public:
+	/***
+	 * Constructor. Hardware is not touched until init
+	 * @param i2c - I2C controller
+	 * @param sdaPin - SDA GPIO pad
+	 * @param sclPin - SCL GPIO pad
+	 * @param baud - bus speed used when a device does not give one
+	 */
+	I2CBus(i2c_inst_t *i2c, uint8_t sdaPin, uint8_t sclPin,
+			uint baud = I2C_BUS_DEFAULT_BAUD);
+
+	virtual ~I2CBus();
+
+	/***
+	 * Initialise controller and pins. Only done on first call so
+	 * devices attaching later do not reset the bus.
+	 */
+	void init();
+
+	/***
+	 * Lock the bus, may be nested on the same task
+	 */
+	void lock();
+
+	/***
+	 * Lock the bus waiting at most I2C_BUS_LOCK_TIMEOUT_MS
+	 * @return true if locked
+	 */
+	bool tryLock();
+
+	/***
+	 * Unlock the bus
+	 */
+	void unlock();
+
+	/***
+	 * Write to a device
+	 * @param addr - 7 bit address
+	 * @param src - data
+	 * @param len - bytes to write
+	 * @param nostop - hold the bus for a following read
+	 * @param baud - speed for this device, 0 for bus default
+	 * @return bytes written or PICO_ERROR code, PICO_ERROR_TIMEOUT
+	 * if the bus could not be locked
+	 */
+	int write(uint8_t addr, const uint8_t *src, size_t len,
+			bool nostop = false, uint baud = 0);
+
+	/***
+	 * Read from a device
+	 * @param addr - 7 bit address
+	 * @param dst - buffer
+	 * @param len - bytes to read
+	 * @param nostop - hold the bus
+	 * @param baud - speed for this device, 0 for bus default
+	 * @return bytes read or PICO_ERROR code
+	 */
+	int read(uint8_t addr, uint8_t *dst, size_t len,
+			bool nostop = false, uint baud = 0);
+
+	/***
+	 * Write then read with a repeated start, under one lock.
+	 * Normally used to read registers
+	 * @param addr - 7 bit address
+	 * @param tx - data to write
+	 * @param txLen
+	 * @param rx - buffer to read into
+	 * @param rxLen
+	 * @param baud - speed for this device, 0 for bus default
+	 * @return bytes read or PICO_ERROR code
+	 */
+	int writeRead(uint8_t addr, const uint8_t *tx, size_t txLen,
+			uint8_t *rx, size_t rxLen, uint baud = 0);
+
+	/***
+	 * Queue a transaction for the next flush.
+	 * The transaction and its buffers must stay valid until flushed
+	 * @param t - transaction
+	 * @return false if the queue is full
+	 */
+	bool queue(I2CTransaction *t);
+
+	/***
+	 * Run all queued transactions back to back under one lock
+	 * If the bus cannot be locked nothing is run and the queue is
+	 * left untouched for a later flush
+	 * @return number of transactions that failed, or still queued if the
+	 * bus could not be locked
+	 */
+	uint flush();
+
+	/***
+	 * Number of transactions waiting for flush
+	 * @return count
+	 */
+	uint queued();
+
+	/***
+	 * Get the I2C controller
+	 * @return
+	 */
+	i2c_inst_t * getI2C();
+
+	/***
+	 * Set the default bus speed
+	 * @param baud
+	 */
+	void setBaud(uint baud);
+
+	/***
+	 * Get the default bus speed
+	 * @return baud
+	 */
+	uint getBaud();
+
+private:
+	/***
+	 * Switch controller speed if different from current
+	 * @param baud - 0 for bus default
+	 */
+	void selectBaud(uint baud);
+
+	/***
+	 * Run one transaction, bus must be locked
+	 * @param t
+	 */
+	void run(I2CTransaction *t);
+
+	i2c_inst_t *pI2C;
+	uint8_t xSdaPin;
+	uint8_t xSclPin;
+	uint xBaud;
+	uint xCurrentBaud = 0;
+	bool xInit = false;
+
+	I2CTransaction *pQueue[I2C_BUS_MAX_BATCH];
+	uint xQueued = 0;
+
+#if I2C_BUS_FREERTOS
+	StaticSemaphore_t xMutexBuffer;
+	SemaphoreHandle_t xMutex = NULL;
+#else
+	recursive_mutex_t xMutex;
+#endif
+};
+
+#endif /* SRC_I2CBUS_H_ */
@@ -0,0 +1,59 @@
+/*
+ * I2CDevice.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "I2CDevice.h"
+
+I2CDevice::I2CDevice(I2CBus *bus, uint8_t addr, uint baud) {
+	pBus = bus;
+	xAddr = addr;
+	xBaud = baud;
+	pBus->init();
+}
+
+I2CDevice::~I2CDevice() {
+	// NOP
+}
+
+int I2CDevice::write(const uint8_t *src, size_t len, bool nostop){
+	return pBus->write(xAddr, src, len, nostop, xBaud);
+}
+
+int I2CDevice::read(uint8_t *dst, size_t len, bool nostop){
+	return pBus->read(xAddr, dst, len, nostop, xBaud);
+}
+
+int I2CDevice::readReg(uint8_t reg, uint8_t *dst, size_t len){
+	return pBus->writeRead(xAddr, &reg, 1, dst, len, xBaud);
+}
+
+void I2CDevice::prepare(I2CTransaction *t,
+		const uint8_t *tx, size_t txLen,
+		uint8_t *rx, size_t rxLen){
+	t->addr = xAddr;
+	t->baud = xBaud;
+	t->tx = tx;
+	t->txLen = txLen;
+	t->rx = rx;
+	t->rxLen = rxLen;
+	t->result = 0;
+}
+
+void I2CDevice::setBaud(uint baud){
+	xBaud = baud;
+}
+
+uint I2CDevice::getBaud(){
+	return xBaud;
+}
+
+uint8_t I2CDevice::getAddr(){
+	return xAddr;
+}
+
+I2CBus * I2CDevice::getBus(){
+	return pBus;
+}
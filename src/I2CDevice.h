@@ -0,0 +1,97 @@
+/*
+ * I2CDevice.h
+ *
+ * A device on a shared I2C bus, with its own address and speed.
+ * Base for sensor drivers sharing the bus with the DS3231.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_I2CDEVICE_H_
+#define SRC_I2CDEVICE_H_
+
+#include "I2CBus.h"
+
+class I2CDevice {
+public:
+	/***
+	 * Constructor, initialises the bus if not already done
+	 * @param bus - shared bus
+	 * @param addr - 7 bit address
+	 * @param baud - speed for this device, 0 for bus default
+	 */
+	I2CDevice(I2CBus *bus, uint8_t addr, uint baud = 0);
+
+	virtual ~I2CDevice();
+
+	/***
+	 * Write to the device
+	 * @param src - data
+	 * @param len - bytes
+	 * @param nostop - hold the bus
+	 * @return bytes written or PICO_ERROR code
+	 */
+	int write(const uint8_t *src, size_t len, bool nostop = false);
+
+	/***
+	 * Read from the device
+	 * @param dst - buffer
+	 * @param len - bytes
+	 * @param nostop - hold the bus
+	 * @return bytes read or PICO_ERROR code
+	 */
+	int read(uint8_t *dst, size_t len, bool nostop = false);
+
+	/***
+	 * Read a block of registers
+	 * @param reg - first register
+	 * @param dst - buffer
+	 * @param len - bytes
+	 * @return bytes read or PICO_ERROR code
+	 */
+	int readReg(uint8_t reg, uint8_t *dst, size_t len);
+
+	/***
+	 * Fill in a transaction for this device, to queue on the bus
+	 * @param t - transaction to fill
+	 * @param tx - data to write, may be NULL
+	 * @param txLen
+	 * @param rx - buffer to read into, may be NULL
+	 * @param rxLen
+	 */
+	void prepare(I2CTransaction *t,
+			const uint8_t *tx, size_t txLen,
+			uint8_t *rx, size_t rxLen);
+
+	/***
+	 * Set the speed for this device
+	 * @param baud - 0 for bus default
+	 */
+	void setBaud(uint baud);
+
+	/***
+	 * Get the speed for this device
+	 * @return baud, 0 for bus default
+	 */
+	uint getBaud();
+
+	/***
+	 * Get the device address
+	 * @return 7 bit address
+	 */
+	uint8_t getAddr();
+
+	/***
+	 * Get the bus the device is on
+	 * @return bus
+	 */
+	I2CBus * getBus();
+
+protected:
+	I2CBus *pBus;
+	uint8_t xAddr;
+	uint xBaud;
+};
+
+#endif /* SRC_I2CDEVICE_H_ */
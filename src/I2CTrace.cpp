@@ -0,0 +1,180 @@
+/*
+ * I2CTrace.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "I2CTrace.h"
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#define I2C_TRACE_MAGIC 0x49324354
+
+struct I2CTraceData {
+	uint32_t		magic;
+	uint32_t		head;		// Index of oldest record
+	uint32_t		count;
+	uint32_t		dropped;
+	uint32_t		check;
+	I2CTraceRecord	recs[I2C_TRACE_SIZE];
+};
+
+static I2CTraceData __uninitialized_ram(xData);
+
+alignas(I2CTrace) static uint8_t xSingletonStore[sizeof(I2CTrace)];
+I2CTrace * I2CTrace::pSingleton = NULL;
+
+I2CTrace * I2CTrace::singleton(){
+	if (pSingleton == NULL){
+		pSingleton = new (xSingletonStore) I2CTrace();
+	}
+	return pSingleton;
+}
+
+I2CTrace::I2CTrace() {
+	validate();
+}
+
+I2CTrace::~I2CTrace() {
+	// NOP
+}
+
+void I2CTrace::record(uint8_t addr,
+		const uint8_t *tx, size_t txLen,
+		const uint8_t *rx, size_t rxLen,
+		int result, uint32_t startUs, uint32_t us){
+	I2CTraceRecord rec;
+	size_t n = 0;
+
+	if (!xEnabled){
+		return;
+	}
+	memset(&rec, 0, sizeof(rec));
+	rec.timeUs = startUs;
+	rec.durationUs = (us > 0xFFFF) ? 0xFFFF : us;
+	rec.addr = addr;
+	if ((tx != NULL) && (txLen > 0)){
+		rec.reg = tx[0];
+		rec.txLen = (txLen - 1 > 0xFF) ? 0xFF : txLen - 1;
+		for (size_t i = 1; i < txLen; i++){
+			if (n == I2C_TRACE_DATA){
+				rec.flags |= I2C_TRACE_TRUNC;
+				break;
+			}
+			rec.data[n++] = tx[i];
+		}
+	} else {
+		rec.flags |= I2C_TRACE_NOREG;
+	}
+	rec.rxLen = (rxLen > 0xFF) ? 0xFF : rxLen;
+	if ((rx != NULL) && (result >= 0)){
+		for (size_t i = 0; i < rxLen; i++){
+			if (n == I2C_TRACE_DATA){
+				rec.flags |= I2C_TRACE_TRUNC;
+				break;
+			}
+			rec.data[n++] = rx[i];
+		}
+	}
+	if (result > 127){
+		result = 127;
+	} else if (result < -128){
+		result = -128;
+	}
+	rec.result = (int8_t)result;
+	add(&rec);
+}
+
+void I2CTrace::mark(uint8_t tag){
+	I2CTraceRecord rec;
+
+	if (!xEnabled){
+		return;
+	}
+	memset(&rec, 0, sizeof(rec));
+	rec.timeUs = time_us_32();
+	rec.addr = I2C_TRACE_MARK;
+	rec.reg = tag;
+	add(&rec);
+}
+
+void I2CTrace::setEnabled(bool on){
+	xEnabled = on;
+}
+
+bool I2CTrace::isEnabled(){
+	return xEnabled;
+}
+
+void I2CTrace::add(const I2CTraceRecord *rec){
+	if (xData.count == I2C_TRACE_SIZE){
+		xData.head = (xData.head + 1) % I2C_TRACE_SIZE;
+		xData.count--;
+		xData.dropped++;
+	}
+	uint32_t i = (xData.head + xData.count) % I2C_TRACE_SIZE;
+	memcpy(&xData.recs[i], rec, sizeof(I2CTraceRecord));
+	xData.count++;
+	xData.check = check();
+}
+
+uint I2CTrace::read(I2CTraceRecord *recs, uint max, uint from){
+	uint n = 0;
+
+	while ((n < max) && (from + n < xData.count)){
+		uint32_t i = (xData.head + from + n) % I2C_TRACE_SIZE;
+		memcpy(&recs[n], &xData.recs[i], sizeof(I2CTraceRecord));
+		n++;
+	}
+	return n;
+}
+
+void I2CTrace::dump(){
+	printf("%s,dropped,%lu\n", I2C_TRACE_PREFIX,
+			(unsigned long)xData.dropped);
+	for (uint32_t n = 0; n < xData.count; n++){
+		uint32_t i = (xData.head + n) % I2C_TRACE_SIZE;
+		const uint8_t *b = (const uint8_t *)&xData.recs[i];
+		printf("%s,", I2C_TRACE_PREFIX);
+		for (size_t j = 0; j < sizeof(I2CTraceRecord); j++){
+			printf("%02X", b[j]);
+		}
+		printf("\n");
+	}
+}
+
+void I2CTrace::clear(){
+	xData.magic = I2C_TRACE_MAGIC;
+	xData.head = 0;
+	xData.count = 0;
+	xData.dropped = 0;
+	xData.check = check();
+}
+
+uint I2CTrace::count(){
+	return xData.count;
+}
+
+uint I2CTrace::capacity(){
+	return I2C_TRACE_SIZE;
+}
+
+uint32_t I2CTrace::getDropped(){
+	return xData.dropped;
+}
+
+void I2CTrace::validate(){
+	if ((xData.magic != I2C_TRACE_MAGIC) ||
+			(xData.head >= I2C_TRACE_SIZE) ||
+			(xData.count > I2C_TRACE_SIZE) ||
+			(xData.check != check())){
+		clear();
+	}
+}
+
+uint32_t I2CTrace::check(){
+	return (xData.magic ^ (xData.head << 16) ^ xData.count ^
+			(xData.dropped << 8)) * 2654435761u;
+}
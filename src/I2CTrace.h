@@ -0,0 +1,160 @@
+/*
+ * I2CTrace.h
+ *
+ * Trace of I2C transactions in a ring buffer of compact binary records.
+ * Held in RAM that is not initialised at boot, so the trace leading up
+ * to a watchdog reset can still be read. Attach to a DS3231 with
+ * set_trace. Dump prints the records as hex lines for capture over the
+ * serial port, to replay on the host against the DS3231 model.
+ * When full the oldest record is overwritten and counted as dropped.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_I2CTRACE_H_
+#define SRC_I2CTRACE_H_
+
+#include "pico/stdlib.h"
+
+#ifndef I2C_TRACE_SIZE
+#define I2C_TRACE_SIZE 128
+#endif
+
+//Data bytes kept per record, written after the register then read
+#define I2C_TRACE_DATA 8
+
+//Address of a mark record, not a transaction
+#define I2C_TRACE_MARK 0xFF
+
+//Record flags
+#define I2C_TRACE_TRUNC		0x01	// Data did not fit, only first bytes kept
+#define I2C_TRACE_NOREG		0x02	// Read without a register write
+
+//Prefix of each line of a dump
+#define I2C_TRACE_PREFIX "I2CT"
+
+/***
+ * Binary record, 20 bytes little endian as dumped
+ */
+struct I2CTraceRecord {
+	uint32_t	timeUs;			// Start of transaction, time_us_32
+	uint16_t	durationUs;		// Bus time, saturates at 0xFFFF
+	uint8_t		addr;			// 7 bit address or I2C_TRACE_MARK
+	uint8_t		reg;			// Register written first, or mark tag
+	uint8_t		txLen;			// Bytes written after the register
+	uint8_t		rxLen;			// Bytes read
+	int8_t		result;			// Bytes transferred or PICO_ERROR code
+	uint8_t		flags;
+	uint8_t		data[I2C_TRACE_DATA];	// Written data then read data
+};
+
+class I2CTrace {
+public:
+	/***
+	 * Get the trace held in retained memory. Contents are kept if valid
+	 * @return trace
+	 */
+	static I2CTrace * singleton();
+
+	/***
+	 * Record a write then read transaction. Read data is only kept if
+	 * the transaction succeeded.
+	 * @param addr - 7 bit address
+	 * @param tx - data written, first byte is the register. May be NULL
+	 * @param txLen
+	 * @param rx - data read. May be NULL
+	 * @param rxLen
+	 * @param result - bytes or PICO_ERROR code
+	 * @param startUs - time_us_32 at start
+	 * @param us - duration
+	 */
+	void record(uint8_t addr,
+			const uint8_t *tx, size_t txLen,
+			const uint8_t *rx, size_t rxLen,
+			int result, uint32_t startUs, uint32_t us);
+
+	/***
+	 * Add a mark, such as at the start of each sleep cycle, so the
+	 * host tool can count traffic between marks
+	 * @param tag - application defined
+	 */
+	void mark(uint8_t tag);
+
+	/***
+	 * Pause or resume recording, recording is on by default
+	 * @param on
+	 */
+	void setEnabled(bool on);
+
+	/***
+	 * Is recording on
+	 * @return
+	 */
+	bool isEnabled();
+
+	/***
+	 * Copy out the oldest records without removing them
+	 * @param recs - destination
+	 * @param max - max records to copy
+	 * @param from - skip this many of the oldest
+	 * @return number copied
+	 */
+	uint read(I2CTraceRecord *recs, uint max, uint from = 0);
+
+	/***
+	 * Print each record, oldest first, as a line of the prefix and the
+	 * record bytes in hex
+	 */
+	void dump();
+
+	/***
+	 * Remove all records
+	 */
+	void clear();
+
+	/***
+	 * Number of records held
+	 * @return
+	 */
+	uint count();
+
+	/***
+	 * Number of records that can be held
+	 * @return
+	 */
+	uint capacity();
+
+	/***
+	 * Records overwritten since last clear
+	 * @return
+	 */
+	uint32_t getDropped();
+
+private:
+	I2CTrace();
+	virtual ~I2CTrace();
+
+	/***
+	 * Check header, reset if not valid
+	 */
+	void validate();
+
+	/***
+	 * Check value of header
+	 * @return
+	 */
+	uint32_t check();
+
+	/***
+	 * Add a record, dropping the oldest if full
+	 * @param rec
+	 */
+	void add(const I2CTraceRecord *rec);
+
+	static I2CTrace * pSingleton;
+
+	bool xEnabled = true;
+};
+
+#endif /* SRC_I2CTRACE_H_ */
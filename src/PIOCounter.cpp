@@ -0,0 +1,250 @@
+/*
+ * PIOCounter.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "PIOCounter.h"
+#include "DeepSleep.h"
+#include "pulse_count.pio.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+PIOCounter::Channel * PIOCounter::pSMs[NUM_PIOS][NUM_PIO_STATE_MACHINES] = {{NULL}};
+uint PIOCounter::xOffset[NUM_PIOS] = {0};
+uint PIOCounter::xLoaded[NUM_PIOS] = {0};
+bool PIOCounter::xIRQAdded[NUM_PIOS] = {false};
+
+PIOCounter::PIOCounter() {
+	// NOP
+}
+
+PIOCounter::~PIOCounter() {
+	stop();
+	for (uint i = 0; i < xNumChannels; i++){
+		Channel *ch = &xChannels[i];
+		uint idx = pio_get_index(ch->pio);
+
+		pio_sm_unclaim(ch->pio, ch->sm);
+		pSMs[idx][ch->sm] = NULL;
+		xLoaded[idx]--;
+		if (xLoaded[idx] == 0){
+			pio_remove_program(ch->pio, &pulse_count_program, xOffset[idx]);
+		}
+	}
+	xNumChannels = 0;
+}
+
+int PIOCounter::addChannel(uint8_t gp, bool rising, bool pullUp){
+	PIO pios[NUM_PIOS] = {pio0, pio1};
+
+	if (xRunning || (xNumChannels >= PIO_COUNTER_MAX_CHANNELS)){
+		return -1;
+	}
+
+	for (uint p = 0; p < NUM_PIOS; p++){
+		int sm = pio_claim_unused_sm(pios[p], false);
+		if (sm < 0){
+			continue;
+		}
+		if (!loadProgram(pios[p])){
+			pio_sm_unclaim(pios[p], sm);
+			continue;
+		}
+
+		Channel *ch = &xChannels[xNumChannels];
+		ch->pio = pios[p];
+		ch->sm = sm;
+		ch->pad = gp;
+		ch->rising = rising;
+		ch->pullUp = pullUp;
+		ch->threshold = 0;
+		ch->last = 0;
+		ch->total = 0;
+		ch->hits = 0;
+		ch->hit = false;
+		pSMs[p][sm] = ch;
+		return xNumChannels++;
+	}
+	return -1;
+}
+
+void PIOCounter::setThreshold(uint channel, uint32_t pulses){
+	if (channel >= xNumChannels){
+		return;
+	}
+	Channel *ch = &xChannels[channel];
+	ch->threshold = pulses;
+
+	if (xRunning){
+		//Reload Y through the OSR without stopping the count
+		pio_sm_put(ch->pio, ch->sm, thresholdReload(pulses));
+		pio_sm_exec(ch->pio, ch->sm, pio_encode_pull(false, true));
+		pio_sm_exec(ch->pio, ch->sm, pio_encode_mov(pio_y, pio_osr));
+		pio_set_irq0_source_enabled(ch->pio,
+				(enum pio_interrupt_source)(pis_interrupt0 + ch->sm),
+				pulses != 0);
+	}
+}
+
+void PIOCounter::start(){
+	DeepSleep *deepSleep = DeepSleep::singleton();
+
+	if (xRunning){
+		return;
+	}
+
+	for (uint i = 0; i < xNumChannels; i++){
+		Channel *ch = &xChannels[i];
+		uint idx = pio_get_index(ch->pio);
+
+		gpio_init(ch->pad);
+		gpio_set_dir(ch->pad, GPIO_IN);
+		if (ch->pullUp){
+			gpio_pull_up(ch->pad);
+		}
+		//Program counts falling edges, so invert for rising
+		gpio_set_inover(ch->pad,
+				ch->rising ? GPIO_OVERRIDE_INVERT : GPIO_OVERRIDE_NORMAL);
+
+		pulse_count_program_init(ch->pio, ch->sm, xOffset[idx], ch->pad);
+		pio_sm_put(ch->pio, ch->sm, thresholdReload(ch->threshold));
+		pio_sm_exec(ch->pio, ch->sm, pio_encode_mov_not(pio_x, pio_null));
+		ch->last = 0;
+
+		pio_interrupt_clear(ch->pio, ch->sm);
+		pio_set_irq0_source_enabled(ch->pio,
+				(enum pio_interrupt_source)(pis_interrupt0 + ch->sm),
+				ch->threshold != 0);
+		if (!xIRQAdded[idx]){
+			uint irq = (idx == 0) ? PIO0_IRQ_0 : PIO1_IRQ_0;
+			irq_add_shared_handler(irq, PIOCounter::thresholdIRQ,
+					PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+			irq_set_enabled(irq, true);
+			xIRQAdded[idx] = true;
+		}
+
+		if (idx == 0){
+			deepSleep->enablePIO0();
+		} else {
+			deepSleep->enablePIO1();
+		}
+		pio_sm_set_enabled(ch->pio, ch->sm, true);
+	}
+	xRunning = true;
+}
+
+void PIOCounter::stop(){
+	DeepSleep *deepSleep = DeepSleep::singleton();
+
+	if (!xRunning){
+		return;
+	}
+	for (uint i = 0; i < xNumChannels; i++){
+		Channel *ch = &xChannels[i];
+
+		//Take the final count, X is reset by the next start
+		getCount(i);
+		pio_sm_set_enabled(ch->pio, ch->sm, false);
+		pio_set_irq0_source_enabled(ch->pio,
+				(enum pio_interrupt_source)(pis_interrupt0 + ch->sm),
+				false);
+		pio_interrupt_clear(ch->pio, ch->sm);
+		gpio_set_inover(ch->pad, GPIO_OVERRIDE_NORMAL);
+		gpio_disable_pulls(ch->pad);
+		if (pio_get_index(ch->pio) == 0){
+			deepSleep->disablePIO0();
+		} else {
+			deepSleep->disablePIO1();
+		}
+	}
+	xRunning = false;
+}
+
+uint64_t PIOCounter::getCount(uint channel){
+	if (channel >= xNumChannels){
+		return 0;
+	}
+	Channel *ch = &xChannels[channel];
+
+	if (xRunning){
+		uint32_t raw = readRaw(ch);
+		ch->total += (uint32_t)(raw - ch->last);
+		ch->last = raw;
+	}
+	return ch->total;
+}
+
+uint32_t PIOCounter::getThresholdHits(uint channel){
+	if (channel >= xNumChannels){
+		return 0;
+	}
+	return xChannels[channel].hits;
+}
+
+bool PIOCounter::takeThreshold(uint channel){
+	if (channel >= xNumChannels){
+		return false;
+	}
+	bool hit = xChannels[channel].hit;
+	xChannels[channel].hit = false;
+	return hit;
+}
+
+uint PIOCounter::getChannels(){
+	return xNumChannels;
+}
+
+uint32_t PIOCounter::readRaw(Channel *ch){
+	uint32_t irq = save_and_disable_interrupts();
+
+	//X counts down from all ones
+	while (!pio_sm_is_rx_fifo_empty(ch->pio, ch->sm)){
+		pio_sm_get(ch->pio, ch->sm);
+	}
+	pio_sm_exec(ch->pio, ch->sm, pio_encode_mov(pio_isr, pio_x));
+	pio_sm_exec(ch->pio, ch->sm, pio_encode_push(false, false));
+	uint32_t x = pio_sm_get_blocking(ch->pio, ch->sm);
+
+	restore_interrupts(irq);
+	return ~x;
+}
+
+bool PIOCounter::loadProgram(PIO pio){
+	uint idx = pio_get_index(pio);
+
+	if (xLoaded[idx] == 0){
+		if (!pio_can_add_program(pio, &pulse_count_program)){
+			return false;
+		}
+		xOffset[idx] = pio_add_program(pio, &pulse_count_program);
+	}
+	xLoaded[idx]++;
+	return true;
+}
+
+uint32_t PIOCounter::thresholdReload(uint32_t pulses){
+	//Y counts down through zero, so IRQ is on the pulses'th edge
+	if (pulses == 0){
+		return 0xFFFFFFFF;
+	}
+	return pulses - 1;
+}
+
+void PIOCounter::thresholdIRQ(){
+	PIO pios[NUM_PIOS] = {pio0, pio1};
+
+	for (uint p = 0; p < NUM_PIOS; p++){
+		for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++){
+			Channel *ch = pSMs[p][sm];
+			if ((ch != NULL) && (ch->threshold != 0) &&
+					pio_interrupt_get(pios[p], sm)){
+				pio_interrupt_clear(pios[p], sm);
+				ch->hits = ch->hits + 1;
+				ch->hit = true;
+				DeepSleep::singleton()->wake();
+			}
+		}
+	}
+}
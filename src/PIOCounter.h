@@ -0,0 +1,138 @@
+/*
+ * PIOCounter.h
+ *
+ * Counts edges on up to eight pads using PIO state machines, for more
+ * inputs than PulseCounter has PWM slices and on any pad. Keeps counting
+ * while the core is in DeepSleep. Each channel can raise an IRQ every
+ * threshold pulses, which ends the DeepSleep.
+ * Does not count in Dormant as the PIO is not clocked.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_PIOCOUNTER_H_
+#define SRC_PIOCOUNTER_H_
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+//One channel per state machine, both PIO blocks
+#ifndef PIO_COUNTER_MAX_CHANNELS
+#define PIO_COUNTER_MAX_CHANNELS 8
+#endif
+
+class PIOCounter {
+public:
+	PIOCounter();
+	virtual ~PIOCounter();
+
+	/***
+	 * Add a pad to count. Takes a state machine from PIO0, then PIO1
+	 * @param gp - GPIO Pad
+	 * @param rising - count rising edges, otherwise falling
+	 * @param pullUp - pull up the pad, for switch or open collector sensors
+	 * @return channel number, -1 if no state machine or program space
+	 */
+	int addChannel(uint8_t gp, bool rising = false, bool pullUp = true);
+
+	/***
+	 * Pulses between threshold IRQs. Can be changed while counting,
+	 * the next IRQ is then threshold pulses from the change.
+	 * @param channel
+	 * @param pulses - 0 for no IRQ
+	 */
+	void setThreshold(uint channel, uint32_t pulses);
+
+	/***
+	 * Start counting on all channels and keep the PIO blocks in use
+	 * clocked in DeepSleep
+	 */
+	void start();
+
+	/***
+	 * Stop counting and release the PIO DeepSleep clocks. Counts are
+	 * kept. The state machines stay claimed, and the program loaded,
+	 * until the counter is destroyed so start can resume on them.
+	 */
+	void stop();
+
+	/***
+	 * Total pulses on the channel since added. Must be read at least
+	 * once every 2^32 pulses.
+	 * @param channel
+	 * @return count
+	 */
+	uint64_t getCount(uint channel);
+
+	/***
+	 * Number of times the threshold has been reached
+	 * @param channel
+	 * @return count
+	 */
+	uint32_t getThresholdHits(uint channel);
+
+	/***
+	 * Did the channel reach its threshold since last asked
+	 * @param channel
+	 * @return true if reached
+	 */
+	bool takeThreshold(uint channel);
+
+	/***
+	 * Number of channels added
+	 * @return channels
+	 */
+	uint getChannels();
+
+private:
+	struct Channel {
+		PIO			pio;
+		uint		sm;
+		uint8_t		pad;
+		bool		rising;
+		bool		pullUp;
+		uint32_t	threshold;
+		uint32_t	last;			// Last raw count read from X
+		uint64_t	total;
+		volatile uint32_t hits;
+		volatile bool hit;
+	};
+
+	/***
+	 * Threshold IRQ shared by all counters
+	 */
+	static void thresholdIRQ();
+
+	/***
+	 * Load the program into the PIO if not already there
+	 * @param pio
+	 * @return false if no space
+	 */
+	static bool loadProgram(PIO pio);
+
+	/***
+	 * Value to load into Y for a threshold
+	 * @param pulses
+	 * @return
+	 */
+	static uint32_t thresholdReload(uint32_t pulses);
+
+	/***
+	 * Raw 32 bit count from the state machine
+	 * @param ch
+	 * @return
+	 */
+	uint32_t readRaw(Channel *ch);
+
+	static Channel * pSMs[NUM_PIOS][NUM_PIO_STATE_MACHINES];
+	static uint xOffset[NUM_PIOS];
+	static uint xLoaded[NUM_PIOS];
+	static bool xIRQAdded[NUM_PIOS];
+
+	Channel xChannels[PIO_COUNTER_MAX_CHANNELS];
+	uint xNumChannels = 0;
+	bool xRunning = false;
+};
+
+#endif /* SRC_PIOCOUNTER_H_ */
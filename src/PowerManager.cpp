@@ -0,0 +1,315 @@
+/*
+ * PowerManager.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "PowerManager.h"
+#include "DeepSleep.h"
+#include "Dormant.h"
+#include <stdio.h>
+
+#define POWER_MINUTE_US 60000000ULL
+
+static const char * xModeNames[POWER_MODES] = {
+	"busy",
+	"gated",
+	"xosc",
+	"deep",
+	"dormant"
+};
+
+PowerManager::PowerManager() {
+	xCurrent[POWER_MODE_BUSY] = POWER_AWAKE_UA;
+	xCurrent[POWER_MODE_GATED] = POWER_GATED_UA;
+	xCurrent[POWER_MODE_XOSC] = POWER_XOSC_UA;
+	xCurrent[POWER_MODE_DEEP] = POWER_DEEP_UA;
+	xCurrent[POWER_MODE_DORMANT] = POWER_DORMANT_UA;
+
+	xCost[POWER_MODE_BUSY] = 0;
+	xCost[POWER_MODE_GATED] = POWER_COST_GATED_US;
+	xCost[POWER_MODE_XOSC] = POWER_COST_XOSC_US;
+	xCost[POWER_MODE_DEEP] = POWER_COST_DEEP_US;
+	xCost[POWER_MODE_DORMANT] = POWER_COST_DORMANT_US;
+
+	for (uint i = 0; i < POWER_MODES; i++){
+		xCount[i] = 0;
+		xMeasured[i] = false;
+	}
+}
+
+PowerManager::~PowerManager() {
+	// NOP
+}
+
+void PowerManager::setRTC(DS3231 *rtc, uint8_t intPad){
+	DeepSleep::singleton()->setRTC(rtc, intPad);
+	Dormant::singleton()->setRTC(rtc, intPad);
+}
+
+bool PowerManager::hasWakePad(WakeTimer *timer){
+	if (timer == NULL){
+		return false;
+	}
+	return !timer->needsWakePad() || (timer->getWakePad() <= 28);
+}
+
+bool PowerManager::isFeasible(PowerMode mode, uint64_t us, uint32_t wakeSources){
+	WakeTimer *timer;
+
+	switch(mode){
+	case POWER_MODE_BUSY:
+		return true;
+	case POWER_MODE_GATED:
+		//sleepUs gates the USB clocks in both short modes
+		return (us >= DEEPSLEEP_US_MIN) && !(wakeSources & POWER_WAKE_USB);
+	case POWER_MODE_XOSC:
+		return (us >= DEEPSLEEP_US_MIN) && !(wakeSources & POWER_WAKE_USB);
+	case POWER_MODE_DEEP:
+		return (us >= POWER_MINUTE_US) && !(wakeSources & POWER_WAKE_USB) &&
+				hasWakePad(DeepSleep::singleton()->getWakeTimer());
+	case POWER_MODE_DORMANT:
+		//All clocks stop so only pads and a timer that runs without them
+		timer = Dormant::singleton()->getWakeTimer();
+		return (us >= POWER_MINUTE_US) &&
+				!(wakeSources & (POWER_WAKE_USB | POWER_WAKE_PERIPHERAL)) &&
+				hasWakePad(timer) && timer->canWakeDormant();
+	default:
+		return false;
+	}
+}
+
+uint64_t PowerManager::getCharge(PowerMode mode, uint64_t us){
+	uint64_t cost = xCost[mode];
+
+	if (cost > us){
+		cost = us;
+	}
+	return (cost * xCurrent[POWER_MODE_BUSY]) + ((us - cost) * xCurrent[mode]);
+}
+
+uint64_t PowerManager::getBreakEven(PowerMode a, PowerMode b){
+	int64_t awake = xCurrent[POWER_MODE_BUSY];
+	int64_t num;
+	uint64_t den;
+
+	if (xCurrent[b] >= xCurrent[a]){
+		return UINT64_MAX;
+	}
+	//Extra charge to enter and leave b over the saving per us asleep
+	num = ((int64_t)xCost[b] * (awake - xCurrent[b])) -
+			((int64_t)xCost[a] * (awake - xCurrent[a]));
+	den = xCurrent[a] - xCurrent[b];
+	if (num < 0){
+		return 0;
+	}
+	return (uint64_t)num / den + 1;
+}
+
+PowerMode PowerManager::select(uint64_t us, uint32_t wakeSources){
+	PowerMode best = POWER_MODE_BUSY;
+	uint64_t bestCharge = getCharge(POWER_MODE_BUSY, us);
+
+	for (uint m = POWER_MODE_BUSY + 1; m < POWER_MODES; m++){
+		PowerMode mode = (PowerMode)m;
+		if (!isFeasible(mode, us, wakeSources)){
+			continue;
+		}
+		uint64_t charge = getCharge(mode, us);
+		if (charge < bestCharge){
+			best = mode;
+			bestCharge = charge;
+		}
+	}
+	return best;
+}
+
+bool PowerManager::sleepFor(uint64_t us, uint32_t wakeSources, uint8_t wakePad){
+	uint64_t left = us;
+
+	//Minute modes still wake on the timer's own pad
+	if (!(wakeSources & POWER_WAKE_GPIO)){
+		wakePad = 0xFF;
+	}
+
+	while (left > 0){
+		PowerMode mode = select(left, wakeSources);
+		xLastMode = mode;
+		xCount[mode]++;
+
+		switch(mode){
+		case POWER_MODE_DEEP:
+		case POWER_MODE_DORMANT: {
+			uint64_t minutes = left / POWER_MINUTE_US;
+			uint64_t slept;
+			if (minutes > 60){
+				minutes = 60;
+			}
+			if (!sleepMinutes(mode, (uint)minutes, wakePad, &slept)){
+				return false;
+			}
+			if (slept == 0){
+				//No clock to tell, take the timer at its word
+				slept = minutes * POWER_MINUTE_US;
+			}
+			left = (slept >= left) ? 0 : left - slept;
+			break;
+		}
+		case POWER_MODE_GATED:
+		case POWER_MODE_XOSC: {
+			uint64_t start = time_us_64();
+			if (!DeepSleep::singleton()->sleepUs(left, wakePad,
+					(mode == POWER_MODE_XOSC))){
+				return false;
+			}
+			//Timer runs throughout, time past the alarm is the recovery
+			uint64_t elapsed = time_us_64() - start;
+			measured(mode, (elapsed > left) ? elapsed - left : 0);
+			left = 0;
+			break;
+		}
+		default:
+			sleep_us(left);
+			left = 0;
+			break;
+		}
+	}
+	return true;
+}
+
+bool PowerManager::sleepMinutes(PowerMode mode, uint minutes, uint8_t wakePad,
+		uint64_t *slept){
+	WakeTimer *timer;
+	uint32_t startEpoch = 0;
+	uint32_t endEpoch = 0;
+	uint64_t start;
+	uint64_t awake;
+
+	if (mode == POWER_MODE_DORMANT){
+		timer = Dormant::singleton()->getWakeTimer();
+	} else {
+		timer = DeepSleep::singleton()->getWakeTimer();
+	}
+	if (timer != NULL){
+		startEpoch = timer->getEpoch();
+	}
+
+	start = time_us_64();
+	if (mode == POWER_MODE_DORMANT){
+		Dormant::singleton()->sleep(minutes, wakePad);
+	} else {
+		DeepSleep::singleton()->sleep(minutes, wakePad);
+	}
+	awake = time_us_64() - start;
+
+	if (timer != NULL){
+		endEpoch = timer->getEpoch();
+	}
+	*slept = 0;
+	if ((startEpoch == 0) || (endEpoch <= startEpoch)){
+		return true;
+	}
+	*slept = (uint64_t)(endEpoch - startEpoch) * 1000000;
+
+	//Timer stops asleep so it counts only entry and recovery, unless
+	//the application kept it running
+	if (awake < *slept / 2){
+		measured(mode, awake);
+	}
+
+	//Alarm matches on the minute so up to a minute short is the timer
+	return (*slept + POWER_MINUTE_US >= minutes * POWER_MINUTE_US);
+}
+
+void PowerManager::measured(PowerMode mode, uint64_t us){
+	if (us > UINT32_MAX){
+		us = UINT32_MAX;
+	}
+	if (!xMeasured[mode]){
+		xCost[mode] = (uint32_t)us;
+		xMeasured[mode] = true;
+	} else {
+		xCost[mode] = (uint32_t)(((uint64_t)xCost[mode] * 3 + us) / 4);
+	}
+}
+
+void PowerManager::sleep(uint minutes, uint8_t wakePad){
+	uint64_t us = minutes * POWER_MINUTE_US;
+	PowerMode mode = POWER_MODE_DEEP;
+	uint64_t slept;
+
+	if (isFeasible(POWER_MODE_DORMANT, us, xWakeSources) &&
+			(getCharge(POWER_MODE_DORMANT, us) < getCharge(POWER_MODE_DEEP, us))){
+		mode = POWER_MODE_DORMANT;
+	}
+	xLastMode = mode;
+	xCount[mode]++;
+	sleepMinutes(mode, minutes, wakePad, &slept);
+}
+
+WakeTimer * PowerManager::getWakeTimer(){
+	return DeepSleep::singleton()->getWakeTimer();
+}
+
+void PowerManager::setWakeSources(uint32_t wakeSources){
+	xWakeSources = wakeSources;
+}
+
+void PowerManager::setCurrent(PowerMode mode, uint32_t ua){
+	if (mode < POWER_MODES){
+		xCurrent[mode] = ua;
+	}
+}
+
+void PowerManager::setCost(PowerMode mode, uint32_t us){
+	if (mode < POWER_MODES){
+		xCost[mode] = us;
+		xMeasured[mode] = false;
+	}
+}
+
+uint32_t PowerManager::getCost(PowerMode mode){
+	if (mode >= POWER_MODES){
+		return 0;
+	}
+	return xCost[mode];
+}
+
+PowerMode PowerManager::getLastMode(){
+	return xLastMode;
+}
+
+uint32_t PowerManager::getCount(PowerMode mode){
+	if (mode >= POWER_MODES){
+		return 0;
+	}
+	return xCount[mode];
+}
+
+const char * PowerManager::getModeName(PowerMode mode){
+	if (mode >= POWER_MODES){
+		return "unknown";
+	}
+	return xModeNames[mode];
+}
+
+void PowerManager::printCosts(){
+	for (uint m = 0; m < POWER_MODES; m++){
+		printf("POWER %-8s cost %lu us%s, %lu uA, %lu sleeps\n",
+				xModeNames[m],
+				(unsigned long)xCost[m],
+				xMeasured[m] ? " measured" : "",
+				(unsigned long)xCurrent[m],
+				(unsigned long)xCount[m]);
+	}
+	for (uint m = 1; m < POWER_MODES; m++){
+		uint64_t be = getBreakEven((PowerMode)(m - 1), (PowerMode)m);
+		if (be == UINT64_MAX){
+			printf("POWER %s over %s never\n", xModeNames[m], xModeNames[m - 1]);
+		} else {
+			printf("POWER %s over %s from %llu us\n",
+					xModeNames[m], xModeNames[m - 1], (unsigned long long)be);
+		}
+	}
+}
@@ -0,0 +1,249 @@
+/*
+ * PowerManager.h
+ *
+ * Sleep for a time in the cheapest mode that keeps the wake sources
+ * needed. Each mode costs some time awake to enter and leave, and
+ * draws its own current while asleep. Mode costs start from defaults
+ * and are replaced by measurements of each sleep, so the break-even
+ * points follow the board and the clocks in use.
+ *
+ * Modes from least to most saving:
+ *  BUSY - wait awake
+ *  GATED - DeepSleep::sleepUs, clocks gated but PLLs running, not USB
+ *  XOSC - DeepSleep::sleepUs, from the XOSC with the PLLs stopped
+ *  DEEP - DeepSleep::sleep, whole minutes on the wake timer
+ *  DORMANT - Dormant::sleep, whole minutes, XOSC stopped
+ *
+ * Minute modes are used for the whole minutes of a longer sleep, the
+ * rest is then slept in a short mode using the wake timer's clock.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_POWERMANAGER_H_
+#define SRC_POWERMANAGER_H_
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+#include "SleepController.h"
+
+/*
+ * Current in each mode, uA
+ */
+#ifndef POWER_AWAKE_UA
+#define POWER_AWAKE_UA 20000
+#endif
+
+#ifndef POWER_GATED_UA
+#define POWER_GATED_UA 5000
+#endif
+
+#ifndef POWER_XOSC_UA
+#define POWER_XOSC_UA 1000
+#endif
+
+#ifndef POWER_DEEP_UA
+#define POWER_DEEP_UA 800
+#endif
+
+#ifndef POWER_DORMANT_UA
+#define POWER_DORMANT_UA 200
+#endif
+
+/*
+ * Time awake to enter and leave each mode before any are measured, us
+ */
+#ifndef POWER_COST_GATED_US
+#define POWER_COST_GATED_US 20
+#endif
+
+#ifndef POWER_COST_XOSC_US
+#define POWER_COST_XOSC_US 3000
+#endif
+
+#ifndef POWER_COST_DEEP_US
+#define POWER_COST_DEEP_US 8000
+#endif
+
+#ifndef POWER_COST_DORMANT_US
+#define POWER_COST_DORMANT_US 10000
+#endif
+
+enum PowerMode {
+	POWER_MODE_BUSY = 0,
+	POWER_MODE_GATED,
+	POWER_MODE_XOSC,
+	POWER_MODE_DEEP,
+	POWER_MODE_DORMANT,
+	POWER_MODES
+};
+
+/*
+ * Wake sources that must keep working while asleep
+ */
+#define POWER_WAKE_TIMER		0x01	// The requested time passing
+#define POWER_WAKE_GPIO			0x02	// Wake pad
+#define POWER_WAKE_PERIPHERAL	0x04	// PWM, PIO, ADC or UART clocked from clk_sys
+#define POWER_WAKE_USB			0x08	// Needs the USB PLL and clocks, busy only
+
+class PowerManager : public SleepController {
+public:
+	PowerManager();
+	virtual ~PowerManager();
+
+	/***
+	 * Set the RTC for the DeepSleep and Dormant wake timers
+	 * @param rtc - NULL to use the Pico RTC
+	 * @param intPad - GPIO Pad the DS3231 INT/SQW is wired to. Minute
+	 * modes are not used with the DS3231 if >28
+	 */
+	void setRTC(DS3231 *rtc, uint8_t intPad = 0xFF);
+
+	/***
+	 * Sleep for a time in the cheapest mode that keeps the wake sources
+	 * @param us - time to sleep
+	 * @param wakeSources - POWER_WAKE bits
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 * @return false if woken early
+	 */
+	bool sleepFor(uint64_t us, uint32_t wakeSources = POWER_WAKE_TIMER,
+			uint8_t wakePad = 0xFF);
+
+	/***
+	 * Cheapest mode for a sleep
+	 * @param us - time to sleep
+	 * @param wakeSources - POWER_WAKE bits
+	 * @return mode
+	 */
+	PowerMode select(uint64_t us, uint32_t wakeSources);
+
+	/***
+	 * Can the mode keep the wake sources for the time
+	 * @param mode
+	 * @param us
+	 * @param wakeSources - POWER_WAKE bits
+	 * @return true if it can
+	 */
+	bool isFeasible(PowerMode mode, uint64_t us, uint32_t wakeSources);
+
+	/***
+	 * Charge used by a sleep in a mode
+	 * @param mode
+	 * @param us
+	 * @return uA x us, pC
+	 */
+	uint64_t getCharge(PowerMode mode, uint64_t us);
+
+	/***
+	 * Shortest sleep for which mode b uses less charge than mode a
+	 * @param a - mode with less saving
+	 * @param b - mode with more saving
+	 * @return us, 0 if b is always cheaper, UINT64_MAX if never
+	 */
+	uint64_t getBreakEven(PowerMode a, PowerMode b);
+
+	/***
+	 * Sleep whole minutes as a SleepController, in DEEP or DORMANT
+	 * @param minutes - Minutes to sleep for (<=60)
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 */
+	virtual void sleep(uint minutes, uint8_t wakePad);
+
+	/***
+	 * DeepSleep's wake timer, for its clock
+	 * @return Wake Timer
+	 */
+	virtual WakeTimer * getWakeTimer();
+
+	/***
+	 * Wake sources used by sleep(minutes, wakePad)
+	 * @param wakeSources - POWER_WAKE bits
+	 */
+	void setWakeSources(uint32_t wakeSources);
+
+	/***
+	 * Set the current drawn in a mode. BUSY is also the current while
+	 * entering and leaving the others
+	 * @param mode
+	 * @param ua
+	 */
+	void setCurrent(PowerMode mode, uint32_t ua);
+
+	/***
+	 * Set the time awake to enter and leave a mode, replaced as it
+	 * is measured
+	 * @param mode
+	 * @param us
+	 */
+	void setCost(PowerMode mode, uint32_t us);
+
+	/***
+	 * Time awake to enter and leave a mode
+	 * @param mode
+	 * @return us
+	 */
+	uint32_t getCost(PowerMode mode);
+
+	/***
+	 * Mode of the last sleep
+	 * @return mode
+	 */
+	PowerMode getLastMode();
+
+	/***
+	 * Number of sleeps in a mode
+	 * @param mode
+	 * @return count
+	 */
+	uint32_t getCount(PowerMode mode);
+
+	/***
+	 * Name of a mode
+	 * @param mode
+	 * @return name
+	 */
+	static const char * getModeName(PowerMode mode);
+
+	/***
+	 * Print cost, current and count for each mode and the break-even
+	 * of each step
+	 */
+	void printCosts();
+
+private:
+	/***
+	 * Sleep whole minutes in DEEP or DORMANT
+	 * @param mode
+	 * @param minutes
+	 * @param wakePad
+	 * @param slept - output, us slept by the wake timer's clock, 0 if
+	 * it keeps no time
+	 * @return false if woken early
+	 */
+	bool sleepMinutes(PowerMode mode, uint minutes, uint8_t wakePad,
+			uint64_t *slept);
+
+	/***
+	 * Add a measured cost to the running average
+	 * @param mode
+	 * @param us
+	 */
+	void measured(PowerMode mode, uint64_t us);
+
+	/***
+	 * Is there a timer that can reach the core
+	 * @param timer - can be NULL
+	 * @return false if NULL or it needs a wake pad that is not known
+	 */
+	bool hasWakePad(WakeTimer *timer);
+
+	uint32_t xCurrent[POWER_MODES];
+	uint32_t xCost[POWER_MODES];
+	uint32_t xCount[POWER_MODES];
+	bool xMeasured[POWER_MODES];
+	uint32_t xWakeSources = POWER_WAKE_TIMER;
+	PowerMode xLastMode = POWER_MODE_BUSY;
+};
+
+#endif /* SRC_POWERMANAGER_H_ */
@@ -0,0 +1,169 @@
+/*
+ * PulseCounter.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "PulseCounter.h"
+#include "DeepSleep.h"
+#include "hardware/pwm.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+PulseCounter * PulseCounter::pSlices[NUM_PWM_SLICES] = {NULL};
+bool PulseCounter::xIRQAdded = false;
+
+PulseCounter::PulseCounter(uint8_t gp, bool rising, bool pullUp) {
+	xPad = gp;
+	xSlice = pwm_gpio_to_slice_num(gp);
+	xRising = rising;
+	xPullUp = pullUp;
+}
+
+PulseCounter::~PulseCounter() {
+	stop();
+}
+
+bool PulseCounter::start(bool wrapIRQ){
+	if (xRunning){
+		return true;
+	}
+	if (pwm_gpio_to_channel(xPad) != PWM_CHAN_B){
+		return false;
+	}
+	if (pSlices[xSlice] != NULL){
+		return false;
+	}
+
+	gpio_init(xPad);
+	if (xPullUp){
+		gpio_pull_up(xPad);
+	}
+	gpio_set_dir(xPad, GPIO_IN);
+
+	//Count edges on B, wrapping at full 16 bits
+	pwm_config cfg = pwm_get_default_config();
+	pwm_config_set_clkdiv_mode(&cfg,
+			xRising ? PWM_DIV_B_RISING : PWM_DIV_B_FALLING);
+	pwm_config_set_clkdiv(&cfg, 1);
+	pwm_config_set_wrap(&cfg, PULSE_COUNTER_WRAP - 1);
+	pwm_init(xSlice, &cfg, false);
+	gpio_set_function(xPad, GPIO_FUNC_PWM);
+
+	xWraps = 0;
+	pSlices[xSlice] = this;
+	pwm_clear_irq(xSlice);
+	if (wrapIRQ){
+		if (!xIRQAdded){
+			irq_add_shared_handler(PWM_IRQ_WRAP, PulseCounter::wrapIRQ,
+					PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+			irq_set_enabled(PWM_IRQ_WRAP, true);
+			xIRQAdded = true;
+		}
+		pwm_set_irq_enabled(xSlice, true);
+	}
+
+	DeepSleep::singleton()->enablePWM();
+	pwm_set_enabled(xSlice, true);
+	xRunning = true;
+	return true;
+}
+
+void PulseCounter::stop(){
+	if (!xRunning){
+		return;
+	}
+	//Counter is reset by the next start so keep the total
+	xBase = getCount();
+	xWraps = 0;
+
+	pwm_set_enabled(xSlice, false);
+	pwm_set_irq_enabled(xSlice, false);
+	pwm_clear_irq(xSlice);
+	DeepSleep::singleton()->disablePWM();
+	pSlices[xSlice] = NULL;
+	gpio_disable_pulls(xPad);
+	gpio_set_function(xPad, GPIO_FUNC_SIO);
+	xRunning = false;
+}
+
+uint64_t PulseCounter::getCount(){
+	if (!xRunning){
+		return xBase;
+	}
+
+	uint32_t irq = save_and_disable_interrupts();
+	uint16_t ctr = pwm_get_counter(xSlice);
+	//A wrap not yet taken means the counter read may be after it
+	if (pwm_hw->intr & (1u << xSlice)){
+		takeWrap();
+		ctr = pwm_get_counter(xSlice);
+	}
+	uint64_t count = xBase + (xWraps * PULSE_COUNTER_WRAP) + ctr;
+	restore_interrupts(irq);
+
+	return count;
+}
+
+uint64_t PulseCounter::getDelta(){
+	return getCount() - xMarkCount;
+}
+
+void PulseCounter::mark(uint32_t epoch){
+	xMarkCount = getCount();
+	xMarkEpoch = epoch;
+}
+
+float PulseCounter::getRate(uint32_t epoch){
+	if (epoch <= xMarkEpoch){
+		return 0.0;
+	}
+	return (float)getDelta() / (float)(epoch - xMarkEpoch);
+}
+
+void PulseCounter::setScale(float scale){
+	xScale = scale;
+}
+
+float PulseCounter::getTotal(){
+	return (float)getCount() * xScale;
+}
+
+float PulseCounter::getScaledRate(uint32_t epoch){
+	return getRate(epoch) * xScale;
+}
+
+uint PulseCounter::maxSleepMin(float maxHz){
+	if (maxHz <= 0.0){
+		return 60;
+	}
+	//One pending wrap is caught on read, a second would be lost
+	float min = (float)PULSE_COUNTER_WRAP / maxHz / 60.0;
+	if (min >= 60.0){
+		return 60;
+	}
+	return (uint)min;
+}
+
+void PulseCounter::takeWrap(){
+	pwm_clear_irq(xSlice);
+	xWraps = xWraps + 1;
+}
+
+void PulseCounter::wrapIRQ(){
+	uint32_t status = pwm_get_irq_status_mask();
+	bool ours = false;
+
+	for (uint s = 0; s < NUM_PWM_SLICES; s++){
+		if ((pSlices[s] != NULL) && (status & (1u << s))){
+			pSlices[s]->takeWrap();
+			ours = true;
+		}
+	}
+
+	//Only a count, do not end a DeepSleep
+	if (ours){
+		DeepSleep::singleton()->sleepOn();
+	}
+}
@@ -0,0 +1,130 @@
+/*
+ * PulseCounter.h
+ *
+ * Counts edges on a GPIO using a PWM slice, which keeps counting while
+ * the core is in DeepSleep. The 16 bit slice counter is extended to 64
+ * bits by the wrap IRQ, which sends the core back to sleep so there is
+ * no wake per pulse. Does not count in Dormant as the PWM is not clocked.
+ *
+ * The PWM can only count on the channel B pin of a slice, the odd GPIO.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_PULSECOUNTER_H_
+#define SRC_PULSECOUNTER_H_
+
+#include "pico/stdlib.h"
+
+//Pulses counted between wraps of the slice counter
+#define PULSE_COUNTER_WRAP 0x10000
+
+class PulseCounter {
+public:
+	/***
+	 * Constructor
+	 * @param gp - GPIO Pad, must be PWM channel B
+	 * @param rising - count rising edges, otherwise falling
+	 * @param pullUp - pull up the pad, for switch or open collector sensors
+	 */
+	PulseCounter(uint8_t gp, bool rising = false, bool pullUp = true);
+
+	virtual ~PulseCounter();
+
+	/***
+	 * Claim the slice, start counting and keep the PWM clocked in
+	 * DeepSleep
+	 * @param wrapIRQ - extend the count by the wrap IRQ. If false the
+	 * count is only extended when read, so sleeps must be bounded by
+	 * maxSleepMin
+	 * @return false if pad is not channel B or slice already in use
+	 */
+	bool start(bool wrapIRQ = true);
+
+	/***
+	 * Stop counting and release the slice and its DeepSleep clock.
+	 * Count is kept.
+	 */
+	void stop();
+
+	/***
+	 * Total pulses since start
+	 * @return count
+	 */
+	uint64_t getCount();
+
+	/***
+	 * Pulses since the last mark
+	 * @return count
+	 */
+	uint64_t getDelta();
+
+	/***
+	 * Mark the count at a time, for getDelta and getRate
+	 * @param epoch - seconds, such as DS3231::get_epoch
+	 */
+	void mark(uint32_t epoch);
+
+	/***
+	 * Pulses per second since the last mark
+	 * @param epoch - seconds now, same source as mark
+	 * @return rate, 0 if no time has passed
+	 */
+	float getRate(uint32_t epoch);
+
+	/***
+	 * Set units per pulse, such as litres per pulse of a flow meter
+	 * or mm per tip of a rain gauge
+	 * @param scale
+	 */
+	void setScale(float scale);
+
+	/***
+	 * Total in units of the scale
+	 * @return count * scale
+	 */
+	float getTotal();
+
+	/***
+	 * Rate in units of the scale per second since the last mark
+	 * @param epoch - seconds now
+	 * @return rate * scale
+	 */
+	float getScaledRate(uint32_t epoch);
+
+	/***
+	 * Longest sleep that cannot lose pulses with the wrap IRQ off
+	 * @param maxHz - highest pulse rate expected
+	 * @return minutes, capped at 60
+	 */
+	static uint maxSleepMin(float maxHz);
+
+private:
+	/***
+	 * Wrap IRQ shared by all counters
+	 */
+	static void wrapIRQ();
+
+	/***
+	 * Take a pending wrap from the slice into the count.
+	 * Call with interrupts disabled
+	 */
+	void takeWrap();
+
+	static PulseCounter * pSlices[];
+	static bool xIRQAdded;
+
+	uint8_t xPad;
+	uint xSlice;
+	bool xRising;
+	bool xPullUp;
+	bool xRunning = false;
+	volatile uint64_t xWraps = 0;
+	uint64_t xBase = 0;
+	uint64_t xMarkCount = 0;
+	uint32_t xMarkEpoch = 0;
+	float xScale = 1.0;
+};
+
+#endif /* SRC_PULSECOUNTER_H_ */
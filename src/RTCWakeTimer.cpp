@@ -0,0 +1,122 @@
+/*
+ * RTCWakeTimer.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "RTCWakeTimer.h"
+#include <stdio.h>
+#include "hardware/rtc.h"
+#include "hardware/clocks.h"
+#include "pico/util/datetime.h"
+
+RTCWakeTimer::RTCWakeTimer() {
+	// NOP
+}
+
+RTCWakeTimer::~RTCWakeTimer() {
+	// NOP
+}
+
+void RTCWakeTimer::setClockPad(uint8_t gp, uint32_t hz){
+	datetime_t t;
+	bool running = rtc_running() && rtc_get_datetime(&t);
+
+	xClockPad = gp;
+	xClockHz = hz;
+	if (xClockPad > 28){
+		return;
+	}
+	clocksChanged();
+
+	//RTC divider is taken from clk_rtc at init so restart and keep time
+	rtc_init();
+	if (running){
+		rtc_set_datetime(&t);
+		//Wait for RTC to update
+		sleep_ms(250);
+	}
+}
+
+void RTCWakeTimer::start(){
+	if (!rtc_running()){
+		rtc_init();
+		 datetime_t t = {
+		            .year  = 2020,
+		            .month = 06,
+		            .day   = 05,
+		            .dotw  = 5, // 0 is Sunday, so 5 is Friday
+		            .hour  = 15,
+		            .min   = 45,
+		            .sec   = 00
+		    };
+		 if(!rtc_set_datetime(&t)){
+			 printf("RTC Set Failed\n");
+			 uart_default_tx_wait_blocking();
+		 }
+		 //Wait for RTC to update
+		 sleep_ms(250);
+	}
+}
+
+bool RTCWakeTimer::setAlarm(uint32_t minutes, WakeTimerCallback cb){
+	datetime_t t;
+
+	start();
+	if (!rtc_get_datetime (&t)){
+		printf("RTC Broken\n");
+		uart_default_tx_wait_blocking();
+		return false;
+	}
+
+	t.year = -1;
+	t.month = -1;
+	t.day = -1;
+	t.hour = -1;
+	t.dotw = -1;
+	t.min = (t.min + minutes) %60;
+	rtc_set_alarm ( &t,  cb);
+	return true;
+}
+
+void RTCWakeTimer::clearAlarm(){
+	//Alarm has wildcards so repeats unless disabled
+	rtc_disable_alarm();
+}
+
+bool RTCWakeTimer::canWakeDormant(){
+	return (xClockPad <= 28);
+}
+
+uint32_t RTCWakeTimer::getSleepClocks(){
+	return CLOCKS_SLEEP_EN0_CLK_RTC_RTC_BITS;
+}
+
+uint32_t RTCWakeTimer::getEpoch(){
+	datetime_t t;
+	int y;
+	uint32_t m;
+	uint32_t days;
+
+	if (!rtc_running() || !rtc_get_datetime(&t)){
+		return 0;
+	}
+
+	//Days since 1970 from the civil date, years run from March
+	y = t.year;
+	m = t.month;
+	if (m <= 2){
+		y--;
+	}
+	m = (m > 2) ? m - 3 : m + 9;
+	days = (uint32_t)(y * 365 + y / 4 - y / 100 + y / 400) +
+			(m * 153 + 2) / 5 + (t.day - 1) - 719468;
+	return days * 86400 + t.hour * 3600 + t.min * 60 + t.sec;
+}
+
+void RTCWakeTimer::clocksChanged(){
+	if (xClockPad <= 28){
+		clock_configure_gpin(clk_rtc, xClockPad, xClockHz, xClockHz);
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * RTCWakeTimer.h
+ *
+ * Wake Timer using the RP2040 internal RTC alarm.
+ * Clocked from XOSC it can only wake from DeepSleep. Clocked from an
+ * external reference on a GPIN pad it can also wake from Dormant.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_RTCWAKETIMER_H_
+#define SRC_RTCWAKETIMER_H_
+
+#include "pico/stdlib.h"
+#include "WakeTimer.h"
+
+class RTCWakeTimer : public WakeTimer {
+public:
+	RTCWakeTimer();
+	virtual ~RTCWakeTimer();
+
+	/***
+	 * Clock the RTC from an external reference on a GPIN pad,
+	 * such as the DS3231 32kHz output.
+	 * @param gp - GPIO Pad, must be 20 (GPIN0) or 22 (GPIN1). >28 disables
+	 * @param hz - frequency of the reference
+	 */
+	void setClockPad(uint8_t gp, uint32_t hz = 32768);
+
+	virtual bool setAlarm(uint32_t minutes, WakeTimerCallback cb = NULL);
+
+	virtual void clearAlarm();
+
+	/***
+	 * Only when clocked from a GPIN pad
+	 * @return true if clock pad set
+	 */
+	virtual bool canWakeDormant();
+
+	virtual uint32_t getSleepClocks();
+
+	virtual void clocksChanged();
+
+	/***
+	 * Time from the Pico RTC, only meaningful once set from a real
+	 * clock as it starts from a default date
+	 * @return epoch, 0 if not running
+	 */
+	virtual uint32_t getEpoch();
+
+private:
+	/***
+	 * Start the RTC with a default time if not already running
+	 */
+	void start();
+
+	uint8_t xClockPad = 0xFF;
+	uint32_t xClockHz = 0;
+};
+
+#endif /* SRC_RTCWAKETIMER_H_ */
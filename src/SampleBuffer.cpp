@@ -0,0 +1,161 @@
+/*
+ * SampleBuffer.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SampleBuffer.h"
+#include <cstring>
+#include <new>
+
+#define SAMPLE_BUFFER_MAGIC 0x53414D50
+
+struct SampleBufferData {
+	uint32_t		magic;
+	uint32_t		head;		// Index of oldest record
+	uint32_t		count;
+	uint32_t		dropped;
+	uint32_t		check;
+	SampleRecord	recs[SAMPLE_BUFFER_SIZE];
+};
+
+static SampleBufferData __uninitialized_ram(xData);
+
+alignas(SampleBuffer) static uint8_t xSingletonStore[sizeof(SampleBuffer)];
+SampleBuffer * SampleBuffer::pSingleton = NULL;
+
+SampleBuffer * SampleBuffer::singleton(){
+	if (pSingleton == NULL){
+		pSingleton = new (xSingletonStore) SampleBuffer();
+	}
+	return pSingleton;
+}
+
+SampleBuffer::SampleBuffer() {
+	validate();
+}
+
+SampleBuffer::~SampleBuffer() {
+	// NOP
+}
+
+void SampleBuffer::setRTC(DS3231 *rtc){
+	pRTC = rtc;
+}
+
+bool SampleBuffer::add(uint16_t channel, int32_t value, uint8_t priority){
+	SampleRecord rec;
+
+	rec.epoch = 0;
+	if (pRTC != NULL){
+		rec.epoch = pRTC->get_epoch();
+	}
+	rec.value = value;
+	rec.channel = channel;
+	rec.priority = priority;
+	rec.flags = 0;
+	return add(&rec);
+}
+
+bool SampleBuffer::add(const SampleRecord *rec){
+	bool res = true;
+
+	if (xData.count == SAMPLE_BUFFER_SIZE){
+		xData.head = (xData.head + 1) % SAMPLE_BUFFER_SIZE;
+		xData.count--;
+		xData.dropped++;
+		res = false;
+	}
+	uint32_t i = (xData.head + xData.count) % SAMPLE_BUFFER_SIZE;
+	memcpy(&xData.recs[i], rec, sizeof(SampleRecord));
+	xData.count++;
+	xData.check = check();
+	return res;
+}
+
+uint SampleBuffer::read(SampleRecord *recs, uint max, uint from){
+	uint n = 0;
+
+	while ((n < max) && (from + n < xData.count)){
+		uint32_t i = (xData.head + from + n) % SAMPLE_BUFFER_SIZE;
+		memcpy(&recs[n], &xData.recs[i], sizeof(SampleRecord));
+		n++;
+	}
+	return n;
+}
+
+const SampleRecord * SampleBuffer::span(uint from, uint *n){
+	if (from >= xData.count){
+		*n = 0;
+		return NULL;
+	}
+	uint32_t i = (xData.head + from) % SAMPLE_BUFFER_SIZE;
+	*n = xData.count - from;
+	if (i + *n > SAMPLE_BUFFER_SIZE){
+		*n = SAMPLE_BUFFER_SIZE - i;
+	}
+	return &xData.recs[i];
+}
+
+void SampleBuffer::consume(uint n){
+	if (n > xData.count){
+		n = xData.count;
+	}
+	xData.head = (xData.head + n) % SAMPLE_BUFFER_SIZE;
+	xData.count -= n;
+	xData.check = check();
+}
+
+void SampleBuffer::clear(){
+	xData.magic = SAMPLE_BUFFER_MAGIC;
+	xData.head = 0;
+	xData.count = 0;
+	xData.dropped = 0;
+	xData.check = check();
+}
+
+uint SampleBuffer::count(){
+	return xData.count;
+}
+
+uint SampleBuffer::capacity(){
+	return SAMPLE_BUFFER_SIZE;
+}
+
+uint32_t SampleBuffer::oldestEpoch(){
+	if (xData.count == 0){
+		return 0;
+	}
+	return xData.recs[xData.head].epoch;
+}
+
+uint8_t SampleBuffer::maxPriority(){
+	uint8_t p = 0;
+
+	for (uint32_t n = 0; n < xData.count; n++){
+		uint32_t i = (xData.head + n) % SAMPLE_BUFFER_SIZE;
+		if (xData.recs[i].priority > p){
+			p = xData.recs[i].priority;
+		}
+	}
+	return p;
+}
+
+uint32_t SampleBuffer::getDropped(){
+	return xData.dropped;
+}
+
+void SampleBuffer::validate(){
+	if ((xData.magic != SAMPLE_BUFFER_MAGIC) ||
+			(xData.head >= SAMPLE_BUFFER_SIZE) ||
+			(xData.count > SAMPLE_BUFFER_SIZE) ||
+			(xData.check != check())){
+		clear();
+	}
+}
+
+uint32_t SampleBuffer::check(){
+	return (xData.magic ^ (xData.head << 16) ^ xData.count ^
+			(xData.dropped << 8)) * 2654435761u;
+}
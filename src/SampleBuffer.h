@@ -0,0 +1,144 @@
+/*
+ * SampleBuffer.h
+ *
+ * Ring buffer of fixed size sample records held in RAM that is not
+ * initialised at boot, so samples survive Dormant and DeepSleep and can
+ * be batched into a single uplink. Records are stamped from the DS3231.
+ * When full the oldest record is overwritten and counted as dropped.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SAMPLEBUFFER_H_
+#define SRC_SAMPLEBUFFER_H_
+
+#include "pico/stdlib.h"
+#include "DS3231.hpp"
+
+#ifndef SAMPLE_BUFFER_SIZE
+#define SAMPLE_BUFFER_SIZE 256
+#endif
+
+/***
+ * Binary record, 12 bytes little endian as sent on the uplink
+ */
+struct SampleRecord {
+	uint32_t	epoch;		// Seconds since 1970 from the DS3231
+	int32_t		value;		// Scaled sample value
+	uint16_t	channel;	// Sensor id
+	uint8_t		priority;	// 0 routine, higher is more urgent
+	uint8_t		flags;		// Application defined
+};
+
+class SampleBuffer {
+public:
+	/***
+	 * Get the buffer held in retained memory. Contents are kept if valid
+	 * @return buffer
+	 */
+	static SampleBuffer * singleton();
+
+	/***
+	 * Set the RTC used to stamp records
+	 * @param rtc - NULL leaves epoch as zero
+	 */
+	void setRTC(DS3231 *rtc);
+
+	/***
+	 * Add a sample stamped with the RTC time
+	 * @param channel
+	 * @param value
+	 * @param priority
+	 * @return true if added without dropping the oldest
+	 */
+	bool add(uint16_t channel, int32_t value, uint8_t priority = 0);
+
+	/***
+	 * Add a record as given
+	 * @param rec
+	 * @return true if added without dropping the oldest
+	 */
+	bool add(const SampleRecord *rec);
+
+	/***
+	 * Copy out the oldest records without removing them
+	 * @param recs - destination
+	 * @param max - max records to copy
+	 * @param from - skip this many of the oldest
+	 * @return number copied
+	 */
+	uint read(SampleRecord *recs, uint max, uint from = 0);
+
+	/***
+	 * Get the records held contiguously in memory from an offset, for
+	 * sending without a copy. The ring may wrap so call again from
+	 * from + n for the rest. Valid until the buffer is changed.
+	 * @param from - skip this many of the oldest
+	 * @param n - output, number of contiguous records
+	 * @return pointer to first record, NULL if none
+	 */
+	const SampleRecord * span(uint from, uint *n);
+
+	/***
+	 * Remove the oldest records, normally once sent
+	 * @param n - number to remove
+	 */
+	void consume(uint n);
+
+	/***
+	 * Remove all records
+	 */
+	void clear();
+
+	/***
+	 * Number of records held
+	 * @return
+	 */
+	uint count();
+
+	/***
+	 * Number of records that can be held
+	 * @return
+	 */
+	uint capacity();
+
+	/***
+	 * Epoch of the oldest record
+	 * @return epoch, 0 if empty
+	 */
+	uint32_t oldestEpoch();
+
+	/***
+	 * Highest priority held
+	 * @return priority, 0 if empty
+	 */
+	uint8_t maxPriority();
+
+	/***
+	 * Records overwritten since last clear
+	 * @return
+	 */
+	uint32_t getDropped();
+
+private:
+	SampleBuffer();
+	virtual ~SampleBuffer();
+
+	/***
+	 * Check header, reset if not valid
+	 */
+	void validate();
+
+	/***
+	 * Check value of header
+	 * @return
+	 */
+	uint32_t check();
+
+	static SampleBuffer * pSingleton;
+
+	DS3231 *pRTC = NULL;
+};
+
+#endif /* SRC_SAMPLEBUFFER_H_ */
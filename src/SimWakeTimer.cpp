@@ -0,0 +1,87 @@
+/*
+ * SimWakeTimer.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SimWakeTimer.h"
+
+SimWakeTimer::SimWakeTimer() {
+	// NOP
+}
+
+SimWakeTimer::~SimWakeTimer() {
+	// NOP
+}
+
+bool SimWakeTimer::setAlarm(uint32_t minutes, WakeTimerCallback cb){
+	if (xFail){
+		return false;
+	}
+	xAlarm = xNow + (uint64_t)minutes * 60;
+	xArmed = true;
+	xAlarmCount++;
+	pCB = cb;
+	return true;
+}
+
+void SimWakeTimer::clearAlarm(){
+	xArmed = false;
+}
+
+bool SimWakeTimer::canWakeDormant(){
+	return true;
+}
+
+uint32_t SimWakeTimer::getEpoch(){
+	return (uint32_t)xNow;
+}
+
+uint64_t SimWakeTimer::getNow(){
+	return xNow;
+}
+
+void SimWakeTimer::setNow(uint64_t seconds){
+	xNow = seconds;
+}
+
+bool SimWakeTimer::isArmed(){
+	return xArmed;
+}
+
+uint64_t SimWakeTimer::getAlarmTime(){
+	return xAlarm;
+}
+
+bool SimWakeTimer::fire(){
+	if (!xArmed){
+		return false;
+	}
+	if (xAlarm > xNow){
+		xNow = xAlarm;
+	}
+	if (pCB != NULL){
+		pCB();
+	}
+	return true;
+}
+
+bool SimWakeTimer::advance(uint64_t seconds){
+	xNow += seconds;
+	if (xArmed && (xAlarm <= xNow)){
+		if (pCB != NULL){
+			pCB();
+		}
+		return true;
+	}
+	return false;
+}
+
+uint32_t SimWakeTimer::getAlarmCount(){
+	return xAlarmCount;
+}
+
+void SimWakeTimer::setFail(bool fail){
+	xFail = fail;
+}
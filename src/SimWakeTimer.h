@@ -0,0 +1,91 @@
+/*
+ * SimWakeTimer.h
+ *
+ * Simulated Wake Timer for running sleep scheduling logic on the host.
+ * Keeps its own clock in seconds which the test harness advances.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SIMWAKETIMER_H_
+#define SRC_SIMWAKETIMER_H_
+
+#include "WakeTimer.h"
+
+class SimWakeTimer : public WakeTimer {
+public:
+	SimWakeTimer();
+	virtual ~SimWakeTimer();
+
+	virtual bool setAlarm(uint32_t minutes, WakeTimerCallback cb = NULL);
+
+	virtual void clearAlarm();
+
+	virtual bool canWakeDormant();
+
+	/***
+	 * Simulated time now
+	 * @return seconds
+	 */
+	virtual uint32_t getEpoch();
+
+	/***
+	 * Simulated time now
+	 * @return seconds
+	 */
+	uint64_t getNow();
+
+	/***
+	 * Set simulated time
+	 * @param seconds
+	 */
+	void setNow(uint64_t seconds);
+
+	/***
+	 * Is an alarm armed
+	 * @return true if armed
+	 */
+	bool isArmed();
+
+	/***
+	 * Time the armed alarm will fire
+	 * @return seconds
+	 */
+	uint64_t getAlarmTime();
+
+	/***
+	 * Advance time to the alarm and fire it
+	 * @return false if no alarm armed
+	 */
+	bool fire();
+
+	/***
+	 * Advance simulated time, firing the alarm if passed
+	 * @param seconds
+	 * @return true if the alarm fired
+	 */
+	bool advance(uint64_t seconds);
+
+	/***
+	 * Number of times alarm has been armed
+	 * @return count
+	 */
+	uint32_t getAlarmCount();
+
+	/***
+	 * Make setAlarm fail, to simulate a broken timer
+	 * @param fail
+	 */
+	void setFail(bool fail = true);
+
+private:
+	uint64_t xNow = 0;
+	uint64_t xAlarm = 0;
+	bool xArmed = false;
+	bool xFail = false;
+	uint32_t xAlarmCount = 0;
+	WakeTimerCallback pCB = NULL;
+};
+
+#endif /* SRC_SIMWAKETIMER_H_ */
@@ -0,0 +1,16 @@
+/*
+ * SleepController.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SleepController.h"
+
+SleepController::SleepController() {
+	// NOP
+}
+
+SleepController::~SleepController() {
+	// NOP
+}
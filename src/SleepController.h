@@ -0,0 +1,38 @@
+/*
+ * SleepController.h
+ *
+ * Interface for a sleep mode that can sleep for a number of minutes
+ * woken by its wake timer or a GPIO pad. Implemented by Dormant and
+ * DeepSleep so schedulers can drive either.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SLEEPCONTROLLER_H_
+#define SRC_SLEEPCONTROLLER_H_
+
+#include "pico/stdlib.h"
+#include "WakeTimer.h"
+
+class SleepController {
+public:
+	SleepController();
+	virtual ~SleepController();
+
+	/***
+	 * Sleep for number of minutes and wake by GPIO pad or by the wake
+	 * timer
+	 * @param minutes - Minutes to sleep for (<=60)
+	 * @param wakePad - GPIO Pad for wake. >28 GPIO wake is not enabled
+	 */
+	virtual void sleep(uint minutes, uint8_t wakePad) = 0;
+
+	/***
+	 * Get the timer used to wake from a timed sleep
+	 * @return Wake Timer or NULL
+	 */
+	virtual WakeTimer * getWakeTimer() = 0;
+};
+
+#endif /* SRC_SLEEPCONTROLLER_H_ */
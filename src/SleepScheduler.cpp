@@ -0,0 +1,262 @@
+/*
+ * SleepScheduler.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "SleepScheduler.h"
+#include <cstring>
+
+SleepScheduler::SleepScheduler(SleepController *ctrl, uint8_t wakePad) {
+	pCtrl = ctrl;
+	xWakePad = wakePad;
+	memset(xJobs, 0, sizeof(xJobs));
+}
+
+SleepScheduler::~SleepScheduler() {
+	// NOP
+}
+
+int SleepScheduler::alloc(SleepJobCallback cb, void *arg){
+	if (cb == NULL){
+		return -1;
+	}
+	for (int i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		if (!xJobs[i].active){
+			memset(&xJobs[i], 0, sizeof(SleepJob));
+			xJobs[i].cb = cb;
+			xJobs[i].arg = arg;
+			return i;
+		}
+	}
+	return -1;
+}
+
+int SleepScheduler::addPeriodic(uint32_t periodSec, SleepJobCallback cb,
+		void *arg, uint32_t first, uint32_t slackSec){
+	int id;
+
+	if (periodSec == 0){
+		return -1;
+	}
+	id = alloc(cb, arg);
+	if (id >= 0){
+		xJobs[id].periodSec = periodSec;
+		xJobs[id].due = (first != 0) ? first : getNow() + periodSec;
+		xJobs[id].active = true;
+		setSlack(id, slackSec);
+	}
+	return id;
+}
+
+int SleepScheduler::addOneShot(uint32_t delaySec, SleepJobCallback cb, void *arg,
+		uint32_t slackSec){
+	int id = alloc(cb, arg);
+
+	if (id >= 0){
+		xJobs[id].due = getNow() + delaySec;
+		xJobs[id].active = true;
+		setSlack(id, slackSec);
+	}
+	return id;
+}
+
+bool SleepScheduler::setSlack(int id, uint32_t slackSec){
+	if ((id < 0) || (id >= SLEEP_SCHEDULER_MAX_JOBS) || !xJobs[id].active){
+		return false;
+	}
+	//Keep successive windows of the same job apart
+	if ((xJobs[id].periodSec != 0) && (slackSec > xJobs[id].periodSec / 2)){
+		slackSec = xJobs[id].periodSec / 2;
+	}
+	//Window must not open before the epoch starts
+	if (slackSec >= xJobs[id].due){
+		slackSec = xJobs[id].due - 1;
+	}
+	xJobs[id].slackSec = slackSec;
+	return true;
+}
+
+bool SleepScheduler::remove(int id){
+	if ((id < 0) || (id >= SLEEP_SCHEDULER_MAX_JOBS) || !xJobs[id].active){
+		return false;
+	}
+	xJobs[id].active = false;
+	return true;
+}
+
+const SleepJob * SleepScheduler::getJob(int id){
+	if ((id < 0) || (id >= SLEEP_SCHEDULER_MAX_JOBS) || !xJobs[id].active){
+		return NULL;
+	}
+	return &xJobs[id];
+}
+
+uint32_t SleepScheduler::getNextDue(){
+	uint32_t next = 0;
+
+	for (uint i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		if (xJobs[i].active && ((next == 0) || (xJobs[i].due < next))){
+			next = xJobs[i].due;
+		}
+	}
+	return next;
+}
+
+uint SleepScheduler::getSleepMinutes(uint32_t now){
+	SleepJob *tight = NULL;
+	uint32_t start;
+	uint32_t wake;
+
+	//Job whose window closes first sets the latest wake
+	for (uint i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		SleepJob *job = &xJobs[i];
+		if (job->active && ((tight == NULL) ||
+				(job->due + job->slackSec < tight->due + tight->slackSec))){
+			tight = job;
+		}
+	}
+	if (tight == NULL){
+		return SLEEP_SCHEDULER_MAX_MIN;
+	}
+
+	//Last minute the alarm can match before the window closes
+	start = now - (now % 60);
+	wake = tight->due + tight->slackSec;
+	wake -= (wake - start) % 60;
+	if ((wake > start) && (wake > now) && (wake + tight->slackSec >= tight->due)){
+		if ((wake - start) / 60 > SLEEP_SCHEDULER_MAX_MIN){
+			return SLEEP_SCHEDULER_MAX_MIN;
+		}
+		return (wake - start) / 60;
+	}
+	//Window holds no minute, wake just after due
+	return minutesUntil(tight->due, now);
+}
+
+uint SleepScheduler::dispatch(uint32_t now){
+	uint32_t minutes[SLEEP_SCHEDULER_MAX_JOBS];
+	uint distinct = 0;
+	uint n = 0;
+
+	for (uint i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		SleepJob *job = &xJobs[i];
+		if (!job->active || (job->due - job->slackSec > now)){
+			continue;
+		}
+
+		//Minute the job would have woken the core in on its own
+		uint32_t m = (job->due + 59) / 60;
+		uint d = 0;
+		while ((d < distinct) && (minutes[d] != m)){
+			d++;
+		}
+		if (d == distinct){
+			minutes[distinct++] = m;
+		}
+
+		if (job->periodSec == 0){
+			//Free the slot first so the job can add another
+			job->active = false;
+		} else {
+			//Run once for a long sleep and skip the periods missed
+			uint32_t late = 0;
+			if (now > job->due + job->slackSec){
+				late = (now - job->due - job->slackSec) / job->periodSec;
+			}
+			job->missed += late;
+			job->due += (late + 1) * job->periodSec;
+		}
+		job->runs++;
+		job->cb(job->arg);
+		n++;
+	}
+	if (distinct > 1){
+		xSaved += distinct - 1;
+	}
+	xRuns += n;
+	return n;
+}
+
+uint SleepScheduler::step(){
+	uint32_t now = getNow();
+	uint n = dispatch(now);
+	uint minutes;
+
+	//Jobs may take long enough for another window to open
+	now = getNow();
+	for (uint i = 0; i < SLEEP_SCHEDULER_MAX_JOBS; i++){
+		if (xJobs[i].active && (xJobs[i].due - xJobs[i].slackSec <= now)){
+			return n;
+		}
+	}
+	minutes = getSleepMinutes(now);
+
+	pCtrl->sleep(minutes, xWakePad);
+	xWakes++;
+
+	if (xEstimate != 0){
+		xEstimate += minutes * 60;
+	}
+	return n;
+}
+
+void SleepScheduler::run(){
+	for (;;){
+		step();
+	}
+}
+
+uint32_t SleepScheduler::getNow(){
+	WakeTimer *timer = pCtrl->getWakeTimer();
+	uint32_t now = 0;
+
+	if (timer != NULL){
+		now = timer->getEpoch();
+	}
+	if (now != 0){
+		xEstimate = 0;
+		return now;
+	}
+	//No clock, estimate from the minutes slept. Starts at 1 as 0 is no job
+	if (xEstimate == 0){
+		xEstimate = 1;
+	}
+	return xEstimate;
+}
+
+uint SleepScheduler::minutesUntil(uint32_t due, uint32_t now){
+	uint32_t start;
+	uint32_t minutes;
+
+	if (due <= now){
+		return 1;
+	}
+	//Alarms match on the minute so count from the start of this one
+	start = now - (now % 60);
+	minutes = (due - start + 59) / 60;
+	if (minutes < 1){
+		minutes = 1;
+	}
+	if (minutes > SLEEP_SCHEDULER_MAX_MIN){
+		minutes = SLEEP_SCHEDULER_MAX_MIN;
+	}
+	return minutes;
+}
+
+void SleepScheduler::setWakePad(uint8_t wakePad){
+	xWakePad = wakePad;
+}
+
+uint32_t SleepScheduler::getWakes(){
+	return xWakes;
+}
+
+uint32_t SleepScheduler::getRuns(){
+	return xRuns;
+}
+
+uint32_t SleepScheduler::getWakesSaved(){
+	return xSaved;
+}
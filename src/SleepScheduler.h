@@ -0,0 +1,203 @@
+/*
+ * SleepScheduler.h
+ *
+ * Runs periodic and one shot jobs between sleeps. Works out when the
+ * next job is due, arms a single wake timer alarm for it through a
+ * SleepController, sleeps, then runs every job due on wake in one
+ * batch. Jobs sharing a wake cost one clock recovery and one set of
+ * RTC traffic instead of one each.
+ *
+ * Jobs may be given slack, running anywhere from due - slack to
+ * due + slack. The scheduler wakes as late as the tightest window
+ * allows and runs every job whose window has opened, so jobs with
+ * slightly different periods share wakes instead of each waking the
+ * core. Wakes saved this way are counted.
+ *
+ * Time is taken from the wake timer's clock. Alarms match on the
+ * minute, so sleeps are whole minutes counted from the start of the
+ * current minute. Without slack a job runs up to a minute after it is
+ * due, never before. Jobs with periods in whole minutes stay aligned.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_SLEEPSCHEDULER_H_
+#define SRC_SLEEPSCHEDULER_H_
+
+#include "pico/stdlib.h"
+#include "SleepController.h"
+
+//Jobs held, fixed so no heap is used
+#ifndef SLEEP_SCHEDULER_MAX_JOBS
+#define SLEEP_SCHEDULER_MAX_JOBS 8
+#endif
+
+//Longest single sleep, the wake timers take up to 60 minutes
+#ifndef SLEEP_SCHEDULER_MAX_MIN
+#define SLEEP_SCHEDULER_MAX_MIN 60
+#endif
+
+typedef void (*SleepJobCallback)(void *arg);
+
+struct SleepJob {
+	SleepJobCallback	cb;
+	void *				arg;
+	uint32_t			periodSec;	// 0 for one shot
+	uint32_t			due;		// Epoch next due
+	uint32_t			slackSec;	// May run this much before or after due
+	uint32_t			runs;
+	uint32_t			missed;		// Periods skipped after a long sleep
+	bool				active;
+};
+
+class SleepScheduler {
+public:
+	/***
+	 * Constructor
+	 * @param ctrl - sleep mode, such as DeepSleep::singleton()
+	 * @param wakePad - GPIO Pad that also wakes. >28 GPIO wake is not enabled
+	 */
+	SleepScheduler(SleepController *ctrl, uint8_t wakePad = 0xFF);
+
+	virtual ~SleepScheduler();
+
+	/***
+	 * Add a job that repeats
+	 * @param periodSec - time between runs
+	 * @param cb - called with arg on each run
+	 * @param arg
+	 * @param first - epoch first due, 0 for one period from now
+	 * @param slackSec - may run this much early or late, at most half
+	 * the period
+	 * @return job id, -1 if SLEEP_SCHEDULER_MAX_JOBS already added
+	 */
+	int addPeriodic(uint32_t periodSec, SleepJobCallback cb,
+			void *arg = NULL, uint32_t first = 0, uint32_t slackSec = 0);
+
+	/***
+	 * Add a job that runs once then is removed
+	 * @param delaySec - time from now
+	 * @param cb - called with arg
+	 * @param arg
+	 * @param slackSec - may run this much early or late
+	 * @return job id, -1 if SLEEP_SCHEDULER_MAX_JOBS already added
+	 */
+	int addOneShot(uint32_t delaySec, SleepJobCallback cb, void *arg = NULL,
+			uint32_t slackSec = 0);
+
+	/***
+	 * Change the slack of a job
+	 * @param id
+	 * @param slackSec - capped at half the period of a periodic job
+	 * @return false if not an active job
+	 */
+	bool setSlack(int id, uint32_t slackSec);
+
+	/***
+	 * Remove a job, may be called from a job
+	 * @param id
+	 * @return false if not an active job
+	 */
+	bool remove(int id);
+
+	/***
+	 * Get a job
+	 * @param id
+	 * @return job, NULL if not an active job
+	 */
+	const SleepJob * getJob(int id);
+
+	/***
+	 * Time the next job is due
+	 * @return epoch, 0 if no jobs
+	 */
+	uint32_t getNextDue();
+
+	/***
+	 * Minutes to sleep so the wake falls inside every job's window,
+	 * as late as the tightest window allows
+	 * @param now - epoch
+	 * @return minutes, 1 to SLEEP_SCHEDULER_MAX_MIN
+	 */
+	uint getSleepMinutes(uint32_t now);
+
+	/***
+	 * Run every job whose window has opened, in id order
+	 * @param now - epoch
+	 * @return number of jobs run
+	 */
+	uint dispatch(uint32_t now);
+
+	/***
+	 * Run the jobs due then sleep until the next is due. On a GPIO
+	 * wake this returns before any job is due.
+	 * @return number of jobs run before sleeping
+	 */
+	uint step();
+
+	/***
+	 * step forever
+	 */
+	void run();
+
+	/***
+	 * Time now from the wake timer. If the timer keeps no time, it is
+	 * estimated from the minutes slept, which drifts by the time awake
+	 * and is wrong after a GPIO wake
+	 * @return epoch
+	 */
+	uint32_t getNow();
+
+	/***
+	 * Minutes to sleep from now until an epoch
+	 * @param due - epoch
+	 * @param now - epoch
+	 * @return minutes, 1 to SLEEP_SCHEDULER_MAX_MIN
+	 */
+	static uint minutesUntil(uint32_t due, uint32_t now);
+
+	/***
+	 * Set the GPIO Pad that also wakes
+	 * @param wakePad - >28 GPIO wake is not enabled
+	 */
+	void setWakePad(uint8_t wakePad);
+
+	/***
+	 * Number of sleeps taken
+	 * @return count
+	 */
+	uint32_t getWakes();
+
+	/***
+	 * Number of job runs
+	 * @return count
+	 */
+	uint32_t getRuns();
+
+	/***
+	 * Wakes saved by slack, counted as the distinct minutes jobs in
+	 * each batch were due in, less the one wake taken
+	 * @return count
+	 */
+	uint32_t getWakesSaved();
+
+private:
+	/***
+	 * Take a free job slot
+	 * @param cb
+	 * @param arg
+	 * @return job id, -1 if none free
+	 */
+	int alloc(SleepJobCallback cb, void *arg);
+
+	SleepController *pCtrl;
+	uint8_t xWakePad;
+	SleepJob xJobs[SLEEP_SCHEDULER_MAX_JOBS];
+	uint32_t xEstimate = 0;
+	uint32_t xWakes = 0;
+	uint32_t xRuns = 0;
+	uint32_t xSaved = 0;
+};
+
+#endif /* SRC_SLEEPSCHEDULER_H_ */
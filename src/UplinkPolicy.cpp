@@ -0,0 +1,63 @@
+/*
+ * UplinkPolicy.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "UplinkPolicy.h"
+
+UplinkPolicy::UplinkPolicy(uint minSamples, uint32_t maxAgeSec, uint8_t priority) {
+	xMinSamples = minSamples;
+	xMaxAge = maxAgeSec;
+	xPriority = priority;
+}
+
+UplinkPolicy::~UplinkPolicy() {
+	// NOP
+}
+
+void UplinkPolicy::setMinSamples(uint minSamples){
+	xMinSamples = minSamples;
+}
+
+void UplinkPolicy::setMaxAge(uint32_t maxAgeSec){
+	xMaxAge = maxAgeSec;
+}
+
+void UplinkPolicy::setPriority(uint8_t priority){
+	xPriority = priority;
+}
+
+bool UplinkPolicy::isDue(SampleBuffer *buf, uint32_t now){
+	uint n = buf->count();
+
+	if (n == 0){
+		pReason = "empty";
+		return false;
+	}
+	if ((xPriority != 0) && (buf->maxPriority() >= xPriority)){
+		pReason = "priority";
+		return true;
+	}
+	if ((xMinSamples != 0) && (n >= xMinSamples)){
+		pReason = "count";
+		return true;
+	}
+	if (n + UPLINK_POLICY_FULL_MARGIN >= buf->capacity()){
+		pReason = "full";
+		return true;
+	}
+	uint32_t oldest = buf->oldestEpoch();
+	if ((xMaxAge != 0) && (now != 0) && (oldest != 0) &&
+			(now >= oldest) && ((now - oldest) >= xMaxAge)){
+		pReason = "age";
+		return true;
+	}
+	pReason = "wait";
+	return false;
+}
+
+const char * UplinkPolicy::getReason(){
+	return pReason;
+}
@@ -0,0 +1,58 @@
+/*
+ * UplinkPolicy.h
+ *
+ * Decide if the samples held in a SampleBuffer are worth waking the
+ * radio for. An uplink is due when enough samples are held, the oldest
+ * is too old, an urgent sample is held or the buffer is close to full.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_UPLINKPOLICY_H_
+#define SRC_UPLINKPOLICY_H_
+
+#include "pico/stdlib.h"
+#include "SampleBuffer.h"
+
+#ifndef UPLINK_POLICY_FULL_MARGIN
+#define UPLINK_POLICY_FULL_MARGIN 8
+#endif
+
+class UplinkPolicy {
+public:
+	/***
+	 * Constructor
+	 * @param minSamples - samples held to trigger uplink, 0 disables
+	 * @param maxAgeSec - age of oldest sample to trigger uplink, 0 disables
+	 * @param priority - priority to trigger immediate uplink, 0 disables
+	 */
+	UplinkPolicy(uint minSamples = 15, uint32_t maxAgeSec = 3600, uint8_t priority = 1);
+	virtual ~UplinkPolicy();
+
+	void setMinSamples(uint minSamples);
+	void setMaxAge(uint32_t maxAgeSec);
+	void setPriority(uint8_t priority);
+
+	/***
+	 * Is an uplink due
+	 * @param buf - buffer of samples
+	 * @param now - current epoch, 0 skips age check
+	 * @return true if radio wake is worthwhile
+	 */
+	bool isDue(SampleBuffer *buf, uint32_t now);
+
+	/***
+	 * Reason for last isDue
+	 * @return string for reporting
+	 */
+	const char * getReason();
+
+private:
+	uint xMinSamples;
+	uint32_t xMaxAge;
+	uint8_t xPriority;
+	const char *pReason = "none";
+};
+
+#endif /* SRC_UPLINKPOLICY_H_ */
@@ -0,0 +1,51 @@
+/*
+ * WakeTimer.cpp
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#include "WakeTimer.h"
+
+WakeTimer::WakeTimer() {
+	// NOP
+}
+
+WakeTimer::~WakeTimer() {
+	// NOP
+}
+
+void WakeTimer::sleepPrepare(){
+	// NOP
+}
+
+void WakeTimer::wakeRecover(){
+	// NOP
+}
+
+uint32_t WakeTimer::getSleepClocks(){
+	return 0;
+}
+
+void WakeTimer::clocksChanged(){
+	// NOP
+}
+
+uint32_t WakeTimer::getEpoch(){
+	return 0;
+}
+
+bool WakeTimer::needsWakePad(){
+	return false;
+}
+
+uint8_t WakeTimer::getWakePad(){
+	return 0xFF;
+}
+
+bool WakeTimer::canReach(uint8_t wakePad){
+	if (!needsWakePad()){
+		return true;
+	}
+	return (getWakePad() <= 28) || (wakePad <= 28);
+}
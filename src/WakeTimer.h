@@ -0,0 +1,97 @@
+/*
+ * WakeTimer.h
+ *
+ * Interface for a timer that can wake the Pico from Dormant or
+ * DeepSleep after a number of minutes. Implemented by the DS3231,
+ * the RP2040 internal RTC and a host simulator.
+ *
+ * Kept free of Pico SDK headers so it can be built on the host.
+ *
+ *  Created on: 18 Oct 2026
+ *      Author: jondurrant
+ */
+
+#ifndef SRC_WAKETIMER_H_
+#define SRC_WAKETIMER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void (*WakeTimerCallback)(void);
+
+class WakeTimer {
+public:
+	WakeTimer();
+	virtual ~WakeTimer();
+
+	/***
+	 * Arm the alarm for a number of minutes from now
+	 * @param minutes - minutes to sleep for (<=60)
+	 * @param cb - called from IRQ if the timer interrupts the core
+	 * directly. External timers wake through a GPIO pad and ignore it
+	 * @return true if the alarm is armed. On false the sleep controller
+	 * falls back to another timer rather than sleep without one
+	 */
+	virtual bool setAlarm(uint32_t minutes, WakeTimerCallback cb = NULL) = 0;
+
+	/***
+	 * Clear the alarm after wake, so it will not fire again
+	 */
+	virtual void clearAlarm() = 0;
+
+	/***
+	 * Can the alarm wake the core from Dormant, with XOSC stopped
+	 * @return true if it can
+	 */
+	virtual bool canWakeDormant() = 0;
+
+	/***
+	 * Called once the alarm is armed and just before sleeping
+	 */
+	virtual void sleepPrepare();
+
+	/***
+	 * Called on wake before the alarm is cleared
+	 */
+	virtual void wakeRecover();
+
+	/***
+	 * Clocks, as CLOCKS_SLEEP_EN0 bits, that must keep running in DeepSleep
+	 * @return bit mask
+	 */
+	virtual uint32_t getSleepClocks();
+
+	/***
+	 * Called after the system clocks have been reconfigured
+	 * going into or coming out of sleep
+	 */
+	virtual void clocksChanged();
+
+	/***
+	 * Time now from the timer's clock
+	 * @return seconds since 1970, 0 if the timer keeps no time
+	 */
+	virtual uint32_t getEpoch();
+
+	/***
+	 * Does the alarm wake the core through a GPIO pad, rather than
+	 * interrupting it directly
+	 * @return true if a wake pad is needed
+	 */
+	virtual bool needsWakePad();
+
+	/***
+	 * GPIO pad the alarm wakes the core through
+	 * @return pad, >28 if none or not known
+	 */
+	virtual uint8_t getWakePad();
+
+	/***
+	 * Can the alarm reach the core on a sleep
+	 * @param wakePad - pad the sleep wakes on, >28 if none
+	 * @return false if a wake pad is needed and neither is known
+	 */
+	bool canReach(uint8_t wakePad);
+};
+
+#endif /* SRC_WAKETIMER_H_ */